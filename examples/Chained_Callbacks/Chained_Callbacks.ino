@@ -0,0 +1,130 @@
+/****************************************************************************************************************************
+  Chained_Callbacks.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+/*
+   Notes:
+   Special design is necessary to share data between interrupt code and the rest of your program.
+   Variables usually need to be "volatile" types. Volatile tells the compiler to avoid optimizations that assume
+   variable can not spontaneously change. Because your function may change variables while your program is using them,
+   the compiler needs this hint. But volatile alone is often not enough.
+   When accessing shared variables, usually interrupts must be disabled. Even with volatile,
+   if the interrupt changes a multi-byte variable between a sequence of instructions, it can be read incorrectly.
+   If your data is multiple variables, such as an array and a count, usually interrupts need to be disabled
+   or the entire sequence of your code which accesses the data.
+*/
+
+// These define's must be placed at the beginning before #include "TimerInterrupt_Generic.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     4
+
+#include "ESP32_S2_TimerInterrupt.h"
+
+// Don't use PIN_D3 in core v2.0.0 and v2.0.1. Check https://github.com/espressif/arduino-esp32/issues/5868
+// Don't use PIN_D2 with ESP32_C3 (crash)
+#define PIN_D19             19        // Pin D19 mapped to pin GPIO9 of ESP32
+
+// One 100us hardware tick shared by several sub-rate callbacks, each with its own divisor and context
+#define TIMER0_INTERVAL_US        100
+
+typedef struct
+{
+	volatile uint32_t count;
+	uint8_t           pin;
+} chainedData_t;
+
+chainedData_t fastData    = { 0, PIN_D19 };   // every tick,       100us
+chainedData_t mediumData  = { 0, 0 };         // every 10th tick,    1ms
+chainedData_t slowData    = { 0, 0 };         // every 10000th tick, 1s
+
+// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+// and you can't use float calculation inside ISR
+// Only OK in core v1.0.6-
+bool IRAM_ATTR FastHandler(void * context)
+{
+	chainedData_t* data = (chainedData_t*) context;
+
+	//timer interrupt toggles pin PIN_D19
+	digitalWrite(data->pin, data->count & 1);
+	data->count++;
+
+	return false;
+}
+
+bool IRAM_ATTR CountHandler(void * context)
+{
+	((chainedData_t*) context)->count++;
+
+	return false;
+}
+
+// Init ESP32 timer 0
+ESP32Timer ITimer0(0);
+
+void setup()
+{
+	pinMode(PIN_D19, OUTPUT);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Chained_Callbacks on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Chained callbacks only, no setFrequency() callback
+	ITimer0.addCallback(FastHandler,  &fastData);
+	ITimer0.addCallback(CountHandler, &mediumData, 10);
+	ITimer0.addCallback(CountHandler, &slowData,   10000);
+
+	// Interval in microsecs
+	if (ITimer0.attachInterruptInterval(TIMER0_INTERVAL_US, NULL))
+	{
+		Serial.print(F("Starting  ITimer0 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0. Select another freq. or timer"));
+
+	Serial.flush();
+}
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+
+	if (millis() - lastPrint > 5000)
+	{
+		lastPrint = millis();
+
+		Serial.print(F("fast = "));
+		Serial.print(fastData.count);
+		Serial.print(F(", medium = "));
+		Serial.print(mediumData.count);
+		Serial.print(F(", slow = "));
+		Serial.println(slowData.count);
+	}
+}
@@ -0,0 +1,143 @@
+/****************************************************************************************************************************
+  ISR_16_Timers_Static_Schedule.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  Same 16 timers as ISR_16_Timers_Array_Complex, but described by a constexpr table kept in flash and checked at compile
+  time. ESP32_ISR_StaticSchedule only keeps 8 bytes of RAM per timer, and there is no setInterval() at boot.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include "ESP32_S2_ISR_StaticSchedule.h"
+
+#define HW_TIMER_INTERVAL_MS      10L
+
+#define NUMBER_ISR_TIMERS         16
+
+typedef struct
+{
+	unsigned long deltaMillis;
+	unsigned long previousMillis;
+} ISRTimerData;
+
+ISRTimerData curISRTimerData[NUMBER_ISR_TIMERS];
+
+void IRAM_ATTR doingSomething(void * param)
+{
+	ISRTimerData* data = (ISRTimerData*) param;
+
+	unsigned long currentMillis  = millis();
+
+	data->deltaMillis    = currentMillis - data->previousMillis;
+	data->previousMillis = currentMillis;
+}
+
+// In flash. Periods not multiple of HW_TIMER_INTERVAL_MS are rejected at compile time by ISR_TIMER_STATIC_SCHEDULE()
+constexpr ISRTimerSchedule_t schedule[NUMBER_ISR_TIMERS] =
+{
+	// period, callback, param, numRuns
+	{  5000L, doingSomething, &curISRTimerData[0],  TIMER_RUN_FOREVER },
+	{ 10000L, doingSomething, &curISRTimerData[1],  TIMER_RUN_FOREVER },
+	{ 15000L, doingSomething, &curISRTimerData[2],  TIMER_RUN_FOREVER },
+	{ 20000L, doingSomething, &curISRTimerData[3],  TIMER_RUN_FOREVER },
+	{ 25000L, doingSomething, &curISRTimerData[4],  TIMER_RUN_FOREVER },
+	{ 30000L, doingSomething, &curISRTimerData[5],  TIMER_RUN_FOREVER },
+	{ 35000L, doingSomething, &curISRTimerData[6],  TIMER_RUN_FOREVER },
+	{ 40000L, doingSomething, &curISRTimerData[7],  TIMER_RUN_FOREVER },
+	{ 45000L, doingSomething, &curISRTimerData[8],  TIMER_RUN_FOREVER },
+	{ 50000L, doingSomething, &curISRTimerData[9],  TIMER_RUN_FOREVER },
+	{ 55000L, doingSomething, &curISRTimerData[10], TIMER_RUN_FOREVER },
+	{ 60000L, doingSomething, &curISRTimerData[11], TIMER_RUN_FOREVER },
+	{ 65000L, doingSomething, &curISRTimerData[12], TIMER_RUN_FOREVER },
+	{ 70000L, doingSomething, &curISRTimerData[13], TIMER_RUN_FOREVER },
+	{ 75000L, doingSomething, &curISRTimerData[14], TIMER_RUN_FOREVER },
+	{ 80000L, doingSomething, &curISRTimerData[15], 10 }
+};
+
+ISR_TIMER_STATIC_SCHEDULE(ISR_Schedule, schedule, HW_TIMER_INTERVAL_MS);
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+// and you can't use float calculation inside ISR
+// Only OK in core v1.0.6-
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	ISR_Schedule.run();
+
+	return true;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_16_Timers_Static_Schedule on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	Serial.print(F("Schedule RAM = "));
+	Serial.print(ISR_Schedule.getRamSize());
+	Serial.println(F(" bytes"));
+
+	unsigned long startMillis = millis();
+
+	for (uint16_t i = 0; i < NUMBER_ISR_TIMERS; i++)
+		curISRTimerData[i].previousMillis = startMillis;
+
+	if (!ISR_Schedule.init())
+		Serial.println(F("Invalid schedule entry"));
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_MS * 1000, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+}
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+
+	if (millis() - lastPrint > 10000)
+	{
+		lastPrint = millis();
+
+		for (uint16_t i = 0; i < NUMBER_ISR_TIMERS; i++)
+		{
+			Serial.print(F("Timer : "));
+			Serial.print(i);
+			Serial.print(F(", programmed : "));
+			Serial.print(schedule[i].period);
+			Serial.print(F(", actual : "));
+			Serial.println(curISRTimerData[i].deltaMillis);
+		}
+	}
+}
@@ -0,0 +1,144 @@
+/****************************************************************************************************************************
+  ISR_Auto_Tick.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  The hardware timer calling ISR_Timer.run() is reprogrammed automatically to the coarsest tick serving all the timers:
+  with 500 ms and 1500 ms timers, the tick is 500 ms instead of 1 ms, i.e. 500 times fewer interrupts. Adding a 300 ms
+  timer brings the tick down to 100 ms, deleting it brings it back up to 500 ms.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+// Initial tick, until enableAutoTick() takes over
+#define HW_TIMER_INTERVAL_US      1000L
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+volatile uint32_t tickCount = 0;
+volatile uint32_t count500  = 0;
+volatile uint32_t count1500 = 0;
+volatile uint32_t count300  = 0;
+
+int timer300 = -1;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	tickCount++;
+
+	return ISR_Timer.run();
+}
+
+void IRAM_ATTR doing500()
+{
+	count500++;
+}
+
+void IRAM_ATTR doing1500()
+{
+	count1500++;
+}
+
+void IRAM_ATTR doing300()
+{
+	count300++;
+}
+
+void printCounts()
+{
+	Serial.print(F("Tick (ms) = "));
+	Serial.print(ISR_Timer.getAutoTick());
+	Serial.print(F(", interrupts = "));
+	Serial.print(tickCount);
+	Serial.print(F(", 500ms = "));
+	Serial.print(count500);
+	Serial.print(F(", 1500ms = "));
+	Serial.print(count1500);
+	Serial.print(F(", 300ms = "));
+	Serial.println(count300);
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Auto_Tick on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting  ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	// Ticks up to 1s, the intervals must be exact multiples of the tick
+	ISR_Timer.enableAutoTick(ITimer, 1000, 0);
+
+	ISR_Timer.setInterval(500L,  doing500);
+	ISR_Timer.setInterval(1500L, doing1500);
+
+	printCounts();
+}
+
+void loop()
+{
+	static unsigned long lastChange = 0;
+	static unsigned long lastPrint  = 0;
+
+	if (millis() - lastPrint > 3000)
+	{
+		lastPrint = millis();
+
+		printCounts();
+	}
+
+	if (millis() - lastChange > 15000)
+	{
+		lastChange = millis();
+
+		if (timer300 < 0)
+		{
+			timer300 = ISR_Timer.setInterval(300L, doing300);
+		}
+		else
+		{
+			ISR_Timer.deleteTimer(timer300);
+			timer300 = -1;
+		}
+	}
+
+	// takes into account the timers deleted by run(), none here
+	ISR_Timer.updateAutoTick();
+}
@@ -0,0 +1,135 @@
+/****************************************************************************************************************************
+  ISR_Long_Timer.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_ISR_LongTimer adds long-period, aligned and cron-like jobs on a 64-bit timebase, while using only one slot of
+  ESP32_ISR_Timer. Only the nearest deadline is armed, so rare jobs cost nothing per tick.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+#include "ESP32_S2_ISR_LongTimer.h"
+
+#define HW_TIMER_INTERVAL_US      10000L
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+// Init ESP32_ISR_LongTimer, layered on ISR_Timer
+ESP32_ISR_LongTimer LongTimer;
+
+volatile uint32_t minuteCount   = 0;
+volatile uint32_t hourCount     = 0;
+volatile uint32_t cronCount     = 0;
+volatile uint32_t longCount     = 0;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	ISR_Timer.run();
+
+	return true;
+}
+
+void IRAM_ATTR everyMinute()
+{
+	minuteCount++;
+}
+
+void IRAM_ATTR everyHourOnTheHour()
+{
+	hourCount++;
+}
+
+void IRAM_ATTR weekdayMorning()
+{
+	cronCount++;
+}
+
+void IRAM_ATTR every60Days()
+{
+	longCount++;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Long_Timer on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting  ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	if (!LongTimer.init(ISR_Timer))
+		Serial.println(F("Can't init LongTimer. No free ISR_Timer slot"));
+
+	// Set the wall clock, e.g. from NTP. Here Tue, 14 Nov 2023 22:13:20 UTC
+	LongTimer.setWallClock(1700000000000ULL);
+
+	// Aligned to the wall clock
+	LongTimer.setAligned(60000ULL, 0, everyMinute);
+	LongTimer.setAligned(3600000ULL, 0, everyHourOnTheHour);
+
+	// 07:30 on Monday to Friday
+	long_timer_cron_t cron = { 1ULL << 30, 1UL << 7, LONG_TIMER_MONDAY | LONG_TIMER_TUESDAY | LONG_TIMER_WEDNESDAY |
+	                           LONG_TIMER_THURSDAY | LONG_TIMER_FRIDAY
+	                         };
+	LongTimer.setCron(cron, weekdayMorning);
+
+	// Far beyond the 49.7-day unsigned long millis() limit
+	LongTimer.setInterval(60ULL * 86400000ULL, every60Days);
+}
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+
+	if (millis() - lastPrint >= 10000)
+	{
+		lastPrint = millis();
+
+		Serial.print(F("Minutes = "));
+		Serial.print(minuteCount);
+		Serial.print(F(", Hours = "));
+		Serial.print(hourCount);
+		Serial.print(F(", Cron = "));
+		Serial.print(cronCount);
+		Serial.print(F(", 60 days = "));
+		Serial.print(longCount);
+		Serial.print(F(", next deadline in ms = "));
+		Serial.println((uint32_t) (LongTimer.getNextDeadline() - ESP32_ISR_LongTimer::now()));
+	}
+}
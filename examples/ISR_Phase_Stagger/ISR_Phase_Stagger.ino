@@ -0,0 +1,117 @@
+/****************************************************************************************************************************
+  ISR_Phase_Stagger.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  Eight timers of 1 to 8 s, all starting together, are due in the same ISR_Timer.run() every second or so: 4 of them
+  at 6 s, all 8 at 840 s. With enablePhaseStagger(), their first runs are spread over the phases of the GCD of the
+  periods (1 s), and the most callbacks run by one ISR_Timer.run() drops to 1. Set USING_PHASE_STAGGER to false to
+  compare.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+#define USING_PHASE_STAGGER       true
+
+#define HW_TIMER_INTERVAL_MS      1L
+
+#define NUMBER_ISR_TIMERS         8
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+volatile uint32_t callsThisRun   = 0;
+volatile uint32_t maxCallsPerRun = 0;
+volatile uint32_t totalCalls     = 0;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	callsThisRun = 0;
+
+	bool yield = ISR_Timer.run();
+
+	if (callsThisRun > maxCallsPerRun)
+		maxCallsPerRun = callsThisRun;
+
+	return yield;
+}
+
+void IRAM_ATTR doingSomething()
+{
+	callsThisRun++;
+	totalCalls++;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Phase_Stagger on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_MS * 1000, TimerHandler))
+	{
+		Serial.print(F("Starting  ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+#if USING_PHASE_STAGGER
+	// Only the timers registered from now on are staggered, in bins of the hardware tick
+	ISR_Timer.enablePhaseStagger(HW_TIMER_INTERVAL_MS);
+#endif
+
+	for (uint16_t i = 0; i < NUMBER_ISR_TIMERS; i++)
+	{
+		ISR_Timer.setInterval(1000L * (i + 1), doingSomething);
+	}
+
+	// Upper bound of the callbacks per run(), over the 840 s hyperperiod
+	Serial.print(F("Peak load = "));
+	Serial.println(ISR_Timer.getPeakLoad());
+}
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+
+	if (millis() - lastPrint > 10000)
+	{
+		lastPrint = millis();
+
+		Serial.print(F("Calls = "));
+		Serial.print(totalCalls);
+		Serial.print(F(", max calls per run() = "));
+		Serial.println(maxCallsPerRun);
+	}
+}
@@ -0,0 +1,125 @@
+/****************************************************************************************************************************
+  ISR_Sharded_Timer.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  One ESP32_ISR_Timer shard per core, each driven by its own hardware timer pinned to that core. A task on each core
+  registers its own timers in its local shard, and the loop() disables / enables a timer of the other core through
+  the shard queue. On ESP32_S2 (single core), there is only one shard, and the core 0 task is not created.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+#include "ESP32_S2_ISR_ShardedTimer.h"
+
+#define HW_TIMER_INTERVAL_US      1000L
+
+// One hardware timer per shard
+ESP32Timer ITimer0(0);
+ESP32Timer ITimer1(1);
+
+ESP32_ISR_ShardedTimer ShardedTimer;
+
+volatile uint32_t core0Count  = 0;
+volatile uint32_t core1Count  = 0;
+
+int core0TimerId = -1;
+
+void IRAM_ATTR countCore0()
+{
+	core0Count++;
+}
+
+void IRAM_ATTR countCore1()
+{
+	core1Count++;
+}
+
+void core0Task(void * param)
+{
+	// registered in the shard of core 0
+	core0TimerId = ShardedTimer.setInterval(10L, countCore0);
+
+	vTaskDelete(NULL);
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Sharded_Timer on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+	Serial.print(F("Shards = "));
+	Serial.println(ShardedTimer.getNumShards());
+
+	// Each shard's interrupt is allocated on its own core
+	for (uint8_t core = 0; core < ShardedTimer.getNumShards(); core++)
+	{
+		if (ShardedTimer.attachShard(core, (core == 0) ? ITimer0 : ITimer1, HW_TIMER_INTERVAL_US))
+		{
+			Serial.print(F("Starting shard OK, core = "));
+			Serial.println(core);
+		}
+		else
+			Serial.println(F("Can't set shard. Select another freq. or timer"));
+	}
+
+	// registered in the shard of the loop() core
+	ShardedTimer.setInterval(20L, countCore1);
+
+	if (ShardedTimer.getNumShards() > 1)
+		xTaskCreatePinnedToCore(core0Task, "core0Task", 2048, NULL, 1, NULL, 0);
+}
+
+void loop()
+{
+	static unsigned long lastToggle = 0;
+	static bool enabled = true;
+
+	if (millis() - lastToggle > 5000)
+	{
+		lastToggle = millis();
+
+		Serial.print(F("Counts: core 0 = "));
+		Serial.print(core0Count);
+		Serial.print(F(", core 1 = "));
+		Serial.println(core1Count);
+
+		// core0TimerId is in the other shard: the request is queued, done at its next tick
+		if (core0TimerId >= 0)
+		{
+			enabled = !enabled;
+
+			if (enabled)
+				ShardedTimer.enable(core0TimerId);
+			else
+				ShardedTimer.disable(core0TimerId);
+		}
+	}
+}
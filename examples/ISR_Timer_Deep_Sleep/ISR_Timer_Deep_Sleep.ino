@@ -0,0 +1,152 @@
+/****************************************************************************************************************************
+  ISR_Timer_Deep_Sleep.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  The ESP32_ISR_Timer schedule is saved into RTC memory before deep sleep, then restored at wake-up with the sleep time
+  applied, so the long-period jobs keep their phase instead of restarting from zero.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+#include <sys/time.h>
+
+#define HW_TIMER_INTERVAL_US      1000L
+
+#define AWAKE_TIME_MS             5000L
+#define SLEEP_TIME_MS             20000L
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+volatile uint32_t sensorReads   = 0;
+volatile uint32_t uploads       = 0;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	ISR_Timer.run();
+
+	return true;
+}
+
+void IRAM_ATTR readSensor()
+{
+	sensorReads++;
+}
+
+void IRAM_ATTR upload()
+{
+	uploads++;
+}
+
+// Callback ids: keep the order when updating the firmware, a snapshot only stores the index
+const timer_registry_t timerRegistry[] =
+{
+	TIMER_REGISTRY_ENTRY(readSensor),
+	TIMER_REGISTRY_ENTRY(upload)
+};
+
+#define NUM_REGISTRY_ENTRIES      ( sizeof(timerRegistry) / sizeof(timerRegistry[0]) )
+
+// Kept during deep sleep
+RTC_DATA_ATTR timer_snapshot_t  timerSnapshot;
+RTC_DATA_ATTR int64_t           sleepStartMs;
+
+int64_t wallMillis()
+{
+	// unlike millis(), the RTC time keeps counting during deep sleep
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (int64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Timer_Deep_Sleep on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	int numRestored = -1;
+
+	if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER)
+	{
+		numRestored = ISR_Timer.restoreSnapshot(timerSnapshot, timerRegistry, NUM_REGISTRY_ENTRIES,
+		                                        (unsigned long) (wallMillis() - sleepStartMs));
+	}
+
+	if (numRestored < 0)
+	{
+		// Cold boot: build the schedule from scratch
+		ISR_Timer.setInterval(2000L,  readSensor);
+		ISR_Timer.setInterval(60000L, upload);
+
+		Serial.println(F("Schedule created"));
+	}
+	else
+	{
+		Serial.print(F("Schedule restored, timers = "));
+		Serial.println(numRestored);
+	}
+}
+
+void loop()
+{
+	if (millis() > AWAKE_TIME_MS)
+	{
+		if (ISR_Timer.saveSnapshot(timerSnapshot, timerRegistry, NUM_REGISTRY_ENTRIES) >= 0)
+		{
+			sleepStartMs = wallMillis();
+		}
+
+		Serial.print(F("Sensor reads = "));
+		Serial.print(sensorReads);
+		Serial.print(F(", uploads = "));
+		Serial.print(uploads);
+		Serial.println(F(". Going to deep sleep"));
+		Serial.flush();
+
+		esp_sleep_enable_timer_wakeup(SLEEP_TIME_MS * 1000ULL);
+		esp_deep_sleep_start();
+	}
+}
@@ -0,0 +1,125 @@
+/****************************************************************************************************************************
+  ISR_Timer_Sequence.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  A timer sequence runs "pulse A, wait 3 ms, pulse B, wait 10 ms, repeat" in only one slot of ESP32_ISR_Timer. Each completed
+  step arms the next one from the tick, without setTimeout() from inside the callbacks.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+// Don't use PIN_D3 in core v2.0.0 and v2.0.1. Check https://github.com/espressif/arduino-esp32/issues/5868
+// Don't use PIN_D2 with ESP32_C3 (crash)
+#define PIN_D19             19        // Pin D19 mapped to pin GPIO9 of ESP32
+#define PIN_D18             18        // Pin D18 mapped to pin GPIO18 of ESP32
+
+#define HW_TIMER_INTERVAL_US      1000L
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+volatile uint32_t sequenceCount = 0;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	ISR_Timer.run();
+
+	return true;
+}
+
+void IRAM_ATTR pinHigh(void * pin)
+{
+	digitalWrite((uint32_t) pin, HIGH);
+}
+
+void IRAM_ATTR pinLow(void * pin)
+{
+	digitalWrite((uint32_t) pin, LOW);
+}
+
+void IRAM_ATTR countSequence(void * param)
+{
+	sequenceCount++;
+}
+
+// delay (ms, from the previous step), callback, param. Steps with delay 0 run in the same tick as the previous one
+const timer_step_t pulseSteps[] =
+{
+	{  1, pinHigh,        (void *) PIN_D19 },     // pulse A, 1ms
+	{  1, pinLow,         (void *) PIN_D19 },
+	{  3, pinHigh,        (void *) PIN_D18 },     // wait 3 ms, pulse B, 1ms
+	{  1, pinLow,         (void *) PIN_D18 },
+	{  0, countSequence,  NULL },
+	{ 10, NULL,           NULL }                  // wait 10 ms, repeat
+};
+
+timer_sequence_t pulseSequence = { pulseSteps, sizeof(pulseSteps) / sizeof(pulseSteps[0]), 0 };
+
+void setup()
+{
+	pinMode(PIN_D19, OUTPUT);
+	pinMode(PIN_D18, OUTPUT);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Timer_Sequence on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	// Whole sequence forever, in one slot
+	if (ISR_Timer.setSequence(pulseSequence) < 0)
+		Serial.println(F("Can't set sequence"));
+}
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+
+	if (millis() - lastPrint > 5000)
+	{
+		lastPrint = millis();
+
+		Serial.print(F("Sequences = "));
+		Serial.print(sequenceCount);
+		Serial.print(F(", timers used = "));
+		Serial.println(ISR_Timer.getNumTimers());
+	}
+}
@@ -0,0 +1,95 @@
+/****************************************************************************************************************************
+  SoftPWM_16_Channels.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_SoftPWM drives 16 software PWM channels at 1kHz with 1us resolution from one hardware timer. Interrupts only
+  happen at the distinct edges of each period, and new duty cycles are applied together at the next period start.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include "ESP32_S2_SoftPWM.h"
+
+#define PWM_FREQUENCY_HZ          1000.0f
+#define NUMBER_PWM_CHANNELS       16
+
+// Don't use GPIO0-3 (boot, USB / UART), 19-20 (USB) and 26-32 (flash / PSRAM)
+const uint8_t pwmPins[NUMBER_PWM_CHANNELS] = { 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 21 };
+
+// Init ESP32 timer 0, dedicated to ESP32_SoftPWM
+ESP32Timer ITimer0(0);
+
+ESP32_SoftPWM SoftPWM;
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting SoftPWM_16_Channels on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	for (uint8_t i = 0; i < NUMBER_PWM_CHANNELS; i++)
+		SoftPWM.addChannel(pwmPins[i]);
+
+	if (SoftPWM.begin(ITimer0, PWM_FREQUENCY_HZ))
+	{
+		Serial.print(F("Starting SoftPWM OK, period = "));
+		Serial.print(SoftPWM.getPeriod());
+		Serial.println(F(" us"));
+	}
+	else
+		Serial.println(F("Can't start SoftPWM. Select another freq. or timer"));
+}
+
+void loop()
+{
+	static uint16_t phase = 0;
+
+	// Breathing pattern, each channel shifted by 1/16 of the cycle. All 16 new duty cycles are applied together
+	for (uint8_t i = 0; i < NUMBER_PWM_CHANNELS; i++)
+	{
+		uint16_t pos = (phase + i * (2000 / NUMBER_PWM_CHANNELS)) % 2000;
+
+		SoftPWM.setDutyPermille(i, (pos < 1000) ? pos : 2000 - pos, false);
+	}
+
+	SoftPWM.apply();
+
+	phase = (phase + 10) % 2000;
+
+	static unsigned long lastPrint = 0;
+
+	if (millis() - lastPrint > 5000)
+	{
+		lastPrint = millis();
+
+		Serial.print(F("Edges per period = "));
+		Serial.println(SoftPWM.getNumEdges());
+	}
+
+	delay(10);
+}
@@ -0,0 +1,168 @@
+/****************************************************************************************************************************
+  Timer_Coroutine.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  Three coroutines share one FreeRTOS task: one blinks with co_await sleep_for(), one waits for a button event with a
+  timeout, one runs on every 100 ms tick. The ESP32_ISR_Timer callback driving the scheduler passes the yield request
+  of tick() back to the ISR with requestYield().
+
+  Needs C++20 coroutines, i.e. GCC >= 10 (ESP32 core v3+), built with -std=gnu++2a:
+    PlatformIO  : build_unflags = -std=gnu++11 -std=gnu++17
+                  build_flags   = -std=gnu++2a
+    Arduino IDE : compiler.cpp.extra_flags=-std=gnu++2a in platform.local.txt
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG             0
+#define _TIMERINTERRUPT_LOGLEVEL_         3
+
+// Opt-in, needs -std=gnu++2a
+#define USING_ESP32_S2_TIMER_COROUTINE    true
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+#include "ESP32_S2_TimerCoroutine.h"
+
+#ifndef LED_BUILTIN
+	#define LED_BUILTIN       2
+#endif
+
+#define BUTTON_PIN          0
+
+#define HW_TIMER_INTERVAL_US      1000L
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+ESP32_CoScheduler scheduler;
+ESP32_CoEvent     buttonEvent(scheduler);
+ESP32_CoTick      tick100ms(scheduler);
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	// true if a callback woke the coroutine task
+	return ISR_Timer.run();
+}
+
+void IRAM_ATTR SchedulerTick()
+{
+	// the callback returns void: the yield goes back through run()
+	if (scheduler.tick())
+		ISR_Timer.requestYield();
+}
+
+void IRAM_ATTR Tick100ms()
+{
+	if (tick100ms.signal())
+		ISR_Timer.requestYield();
+}
+
+void IRAM_ATTR ButtonISR()
+{
+	buttonEvent.set();
+}
+
+ESP32_CoTask blink()
+{
+	bool state = false;
+
+	while (true)
+	{
+		digitalWrite(LED_BUILTIN, state = !state);
+
+		co_await sleep_for(500000);
+	}
+}
+
+ESP32_CoTask button()
+{
+	while (true)
+	{
+		if (co_await buttonEvent.wait(5000000))
+			Serial.println(F("Button pressed"));
+		else
+			Serial.println(F("No button press for 5 s"));
+	}
+}
+
+ESP32_CoTask counter()
+{
+	uint32_t ticks = 0;
+
+	while (true)
+	{
+		co_await next_tick(tick100ms);
+
+		if (++ticks % 50 == 0)
+		{
+			Serial.print(F("Ticks = "));
+			Serial.println(ticks);
+		}
+	}
+}
+
+void coroutineTask(void * param)
+{
+	scheduler.run();
+}
+
+void setup()
+{
+	pinMode(LED_BUILTIN, OUTPUT);
+	pinMode(BUTTON_PIN, INPUT_PULLUP);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer_Coroutine on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	scheduler.spawn(blink());
+	scheduler.spawn(button());
+	scheduler.spawn(counter());
+
+	xTaskCreate(coroutineTask, "coroutines", 4096, NULL, 5, NULL);
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	ISR_Timer.setInterval(1L,   SchedulerTick);
+	ISR_Timer.setInterval(100L, Tick100ms);
+
+	attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), ButtonISR, FALLING);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,84 @@
+/****************************************************************************************************************************
+  Timer_Encoder.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_TimerEncoder decodes 2 quadrature encoders sampled at 50kHz on one hardware timer, without any GPIO interrupt,
+  and prints their positions and velocities.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include "ESP32_S2_TimerEncoder.h"
+
+#define ENCODER_SAMPLE_INTERVAL_US    20L         // 50kHz, up to 50k edges/s per encoder
+
+#define ENCODER0_PIN_A                4
+#define ENCODER0_PIN_B                5
+#define ENCODER1_PIN_A                6
+#define ENCODER1_PIN_B                7
+
+// Init ESP32 timer 0
+ESP32Timer ITimer0(0);
+
+ESP32_TimerEncoder Encoders;
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer_Encoder on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	Encoders.addEncoder(ENCODER0_PIN_A, ENCODER0_PIN_B);
+	Encoders.addEncoder(ENCODER1_PIN_A, ENCODER1_PIN_B, true);
+
+	// Interval in microsecs. The decoder is a chained callback, no setFrequency() callback is needed
+	if (ITimer0.attachInterruptInterval(ENCODER_SAMPLE_INTERVAL_US, NULL) && Encoders.begin(ITimer0))
+	{
+		Serial.print(F("Starting  ITimer0 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0. Select another freq. or timer"));
+}
+
+void loop()
+{
+	for (uint8_t i = 0; i < Encoders.getNumEncoders(); i++)
+	{
+		Serial.print(F("Encoder "));
+		Serial.print(i);
+		Serial.print(F(" : position = "));
+		Serial.print(Encoders.getPosition(i));
+		Serial.print(F(", velocity = "));
+		Serial.print(Encoders.getVelocity(i));
+		Serial.print(F(" counts/s, errors = "));
+		Serial.println(Encoders.getErrors(i));
+	}
+
+	delay(500);
+}
@@ -0,0 +1,100 @@
+/****************************************************************************************************************************
+  Timer_Exact_Frequency.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  Generates the 44.1 kHz sample clock of an audio output, whose period is 22.675... counts of the 1 MHz timer clock.
+  setFrequency() would run at 1 MHz / 22 = 45.45 kHz, 3% too fast. attachInterruptExact() alternates periods of 22 and
+  23 counts, so that the mean frequency is exact. Every 10 s, the rate is retuned between 44.1 kHz and 48 kHz
+  without any glitch, and the measured sample rate is printed every second.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+#define SAMPLE_RATE_1             44100.0
+#define SAMPLE_RATE_2             48000.0
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+volatile uint32_t sampleCount = 0;
+
+bool IRAM_ATTR SampleHandler(void * timerNo)
+{
+	// output one audio sample here
+	sampleCount++;
+
+	return false;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer_Exact_Frequency on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	if (ITimer.attachInterruptExact(SAMPLE_RATE_1, SampleHandler))
+	{
+		Serial.print(F("Starting ITimer OK, exact frequency = "));
+		Serial.println(ITimer.getExactFrequency(), 6);
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+}
+
+void loop()
+{
+	static unsigned long lastPrint  = 0;
+	static unsigned long lastRetune = 0;
+	static uint32_t      lastCount  = 0;
+	static bool          rate1      = true;
+
+	if (millis() - lastPrint >= 1000)
+	{
+		lastPrint += 1000;
+
+		uint32_t count = sampleCount;
+
+		Serial.print(F("Samples in the last second = "));
+		Serial.println(count - lastCount);
+
+		lastCount = count;
+	}
+
+	if (millis() - lastRetune >= 10000)
+	{
+		lastRetune = millis();
+
+		rate1 = !rate1;
+
+		// the current period ends as programmed, the phase is kept
+		ITimer.changeFrequencyExact(rate1 ? SAMPLE_RATE_1 : SAMPLE_RATE_2);
+
+		Serial.print(F("Retuned to "));
+		Serial.println(ITimer.getExactFrequency(), 6);
+	}
+}
@@ -0,0 +1,106 @@
+/****************************************************************************************************************************
+  Timer_Rate_Limiter.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  A button ISR and the loop() both send messages, throttled to 5 messages/s with bursts of 10 by one
+  ESP32_TimerRateLimiter. The bucket refills from the timestamp of ITimer, without any refill timer or timer slot.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerRateLimiter.h"
+
+#define BUTTON_PIN                0         // BOOT button
+
+#define HW_TIMER_INTERVAL_US      10000L
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// 5 messages/s, bursts of 10
+ESP32_TimerRateLimiter messageLimiter;
+
+volatile uint32_t buttonMessages  = 0;
+uint32_t          loopMessages    = 0;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	return false;
+}
+
+void IRAM_ATTR buttonISR()
+{
+	// bouncing included: only the first presses in a burst get through
+	if (messageLimiter.tryAcquire())
+		buttonMessages++;
+}
+
+void setup()
+{
+	pinMode(BUTTON_PIN, INPUT_PULLUP);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer_Rate_Limiter on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs. ITimer is only the timebase here, any running timer can be
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	if (!messageLimiter.begin(ITimer, 5.0f, 10))
+		Serial.println(F("Can't set messageLimiter"));
+
+	attachInterrupt(BUTTON_PIN, buttonISR, FALLING);
+}
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+
+	// try to send as fast as possible
+	if (messageLimiter.tryAcquire())
+		loopMessages++;
+
+	if (millis() - lastPrint > 5000)
+	{
+		lastPrint = millis();
+
+		Serial.print(F("Messages: loop = "));
+		Serial.print(loopMessages);
+		Serial.print(F(", button = "));
+		Serial.print(buttonMessages);
+		Serial.print(F(", rejected = "));
+		Serial.println(messageLimiter.getRejected());
+	}
+}
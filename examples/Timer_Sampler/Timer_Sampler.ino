@@ -0,0 +1,113 @@
+/****************************************************************************************************************************
+  Timer_Sampler.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_TimerSampler samples a pin at 20kHz into a ping-pong buffer, and wakes loop() only once per block of 1000 samples,
+  with the timestamp of the first sample of the block.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include "ESP32_S2_TimerSampler.h"
+
+// Don't use PIN_D3 in core v2.0.0 and v2.0.1. Check https://github.com/espressif/arduino-esp32/issues/5868
+// Don't use PIN_D2 with ESP32_C3 (crash)
+#define PIN_D19             19        // Pin D19 mapped to pin GPIO9 of ESP32
+
+#define SAMPLE_INTERVAL_US        50L         // 20kHz
+#define SAMPLES_PER_BLOCK         1000
+
+// Init ESP32 timer 0
+ESP32Timer ITimer0(0);
+
+ESP32_TimerSampler<uint8_t, SAMPLES_PER_BLOCK> Sampler;
+
+uint8_t IRAM_ATTR readPin(void * pin)
+{
+	return digitalRead((uint32_t) pin);
+}
+
+void setup()
+{
+	pinMode(PIN_D19, INPUT_PULLUP);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer_Sampler on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs. The sampler is a chained callback, no setFrequency() callback is needed
+	if (ITimer0.attachInterruptInterval(SAMPLE_INTERVAL_US, NULL))
+	{
+		Serial.print(F("Starting  ITimer0 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0. Select another freq. or timer"));
+
+	// loop() is the consumer task
+	if (!Sampler.begin(ITimer0, readPin, (void *) PIN_D19))
+		Serial.println(F("Can't start Sampler"));
+}
+
+void loop()
+{
+	uint64_t timestamp;
+
+	const uint8_t* samples = Sampler.waitBlock(pdMS_TO_TICKS(1000), &timestamp);
+
+	if (samples == NULL)
+	{
+		Serial.println(F("No block"));
+
+		return;
+	}
+
+	uint16_t numHigh = 0;
+
+	for (uint16_t i = 0; i < SAMPLES_PER_BLOCK; i++)
+		numHigh += samples[i];
+
+	Sampler.releaseBlock();
+
+	static uint32_t lastPrint = 0;
+
+	// one line per second, i.e. every 20 blocks
+	if (Sampler.getNumBlocks() - lastPrint >= 20)
+	{
+		lastPrint = Sampler.getNumBlocks();
+
+		Serial.print(F("Block @ "));
+		Serial.print((uint32_t) (ESP32TimerInterrupt::countsToNs(timestamp) / 1000));
+		Serial.print(F(" us, high = "));
+		Serial.print(numHigh);
+		Serial.print(F(" / "));
+		Serial.print(SAMPLES_PER_BLOCK);
+		Serial.print(F(", overruns = "));
+		Serial.println(Sampler.getOverruns());
+	}
+}
@@ -0,0 +1,113 @@
+/****************************************************************************************************************************
+  Timer_Task_Notify.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  A worker task is woken directly by timer expirations, without any callback calling xTaskNotifyFromISR() by hand:
+  every 10th tick of ITimer sets bit 0, and ESP32_ISR_Timer timers set bits 1 and 2. The notifications of one ISR
+  are coalesced, so the task is notified and switched to only once.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+#define HW_TIMER_INTERVAL_US      1000L
+
+#define BIT_FAST                  (1UL << 0)
+#define BIT_SLOW                  (1UL << 1)
+#define BIT_REPORT                (1UL << 2)
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+TaskHandle_t workerTask = NULL;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	// true only if a notification woke a higher priority task
+	return ISR_Timer.run();
+}
+
+void worker(void * param)
+{
+	uint32_t fastCount  = 0;
+	uint32_t slowCount  = 0;
+	uint32_t bits;
+
+	while (true)
+	{
+		xTaskNotifyWait(0, ULONG_MAX, &bits, portMAX_DELAY);
+
+		if (bits & BIT_FAST)
+			fastCount++;
+
+		if (bits & BIT_SLOW)
+			slowCount++;
+
+		if (bits & BIT_REPORT)
+		{
+			Serial.print(F("Fast = "));
+			Serial.print(fastCount);
+			Serial.print(F(", slow = "));
+			Serial.println(slowCount);
+		}
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer_Task_Notify on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	xTaskCreate(worker, "worker", 4096, NULL, 5, &workerTask);
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	// every 10 ms, straight from the hardware timer ISR
+	ITimer.addTaskNotify(workerTask, BIT_FAST, 10);
+
+	// every 100 ms and 5 s, from ESP32_ISR_Timer
+	ISR_Timer.setTaskNotify(100L,  workerTask, BIT_SLOW);
+	ISR_Timer.setTaskNotify(5000L, workerTask, BIT_REPORT);
+}
+
+void loop()
+{
+}
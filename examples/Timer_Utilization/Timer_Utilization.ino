@@ -0,0 +1,134 @@
+/****************************************************************************************************************************
+  Timer_Utilization.ino
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  Measures the share of the CPU taken by the timer interrupt running ESP32_ISR_Timer, with the distribution of the
+  ISR durations, and estimates the highest tick rate the same callbacks could sustain. Every 10 s, one more busy
+  callback is added, to see the utilization and the headroom change.
+*****************************************************************************************************************************/
+
+// These define's must be placed at the beginning before #include "ESP32_S2_TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+// Don't define _TIMERINTERRUPT_LOGLEVEL_ > 0. Only for special ISR debugging only. Can hang the system.
+#define TIMER_INTERRUPT_DEBUG         0
+#define _TIMERINTERRUPT_LOGLEVEL_     3
+
+// Can be included as many times as necessary, without `Multiple Definitions` Linker Error
+#include "ESP32_S2_TimerInterrupt.h"
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_S2_ISR_Timer.h"
+
+#define HW_TIMER_INTERVAL_US      1000L
+
+#define MAX_BUSY_TIMERS           8
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+uint8_t numBusyTimers = 0;
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	return ISR_Timer.run();
+}
+
+// Simulates a callback doing some work, about 20 us
+void IRAM_ATTR busyCallback()
+{
+	uint32_t start = TISR_GET_CYCLE_COUNT();
+
+	while (TISR_GET_CYCLE_COUNT() - start < 20 * F_CPU / 1000000);
+}
+
+void printUtilization()
+{
+	timer_utilization_t stats;
+
+	ITimer.getUtilizationStats(stats);
+
+	Serial.print(F("Busy timers = "));
+	Serial.print(numBusyTimers);
+	Serial.print(F(", utilization = "));
+	Serial.print(stats.utilization / 100.0f);
+	Serial.print(F("%, mean = "));
+	Serial.print(stats.meanCycles);
+	Serial.print(F(", peak = "));
+	Serial.print(stats.peakCycles);
+	Serial.print(F(" cycles, max tick rate at 50% = "));
+	Serial.print(ITimer.getMaxTickRate(50));
+	Serial.println(F(" Hz"));
+
+	// log2 histogram of the ISR durations
+	for (uint8_t k = 0; k < ESP32_S2_TIMER_UTIL_BUCKETS; k++)
+	{
+		if (stats.histogram[k] == 0)
+			continue;
+
+		Serial.print(F("  "));
+		Serial.print(1UL << k);
+		Serial.print(F("+ cycles : "));
+		Serial.println(stats.histogram[k]);
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting Timer_Utilization on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_S2_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(HW_TIMER_INTERVAL_US, TimerHandler))
+	{
+		Serial.print(F("Starting ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+
+	// utilization over 1 s windows
+	ITimer.setUtilizationTracking(true, 1000);
+}
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+	static unsigned long lastAdd   = 0;
+
+	if (millis() - lastPrint > 2000)
+	{
+		lastPrint = millis();
+
+		printUtilization();
+	}
+
+	if ( (millis() - lastAdd > 10000) && (numBusyTimers < MAX_BUSY_TIMERS) )
+	{
+		lastAdd = millis();
+
+		ISR_Timer.setInterval(10L * (numBusyTimers + 1), busyCallback);
+		numBusyTimers++;
+	}
+}
@@ -0,0 +1,797 @@
+/****************************************************************************************************************************
+  ESP32_S2_ISR_LongTimer.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_ISR_LongTimer is a long-period / calendar scheduler layered on top of ESP32_ISR_Timer. It uses a 64-bit millisecond
+  monotonic timebase, so periods are no longer limited by unsigned long miliseconds, and supports aligned schedules
+  ("every hour on the hour") and cron-like recurrences. Only the nearest deadline is armed in one ESP32_ISR_Timer slot,
+  so any number of rare jobs costs nothing per tick. The jobs are kept in a min-heap of deadlines: each due job costs
+  O(log n) in ISR. The next minute of a cron job, a walk of up to 8 days, is computed by a task.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ISR_LONG_TIMER_GENERIC_H
+#define ISR_LONG_TIMER_GENERIC_H
+
+////////////////////////////////////////
+
+#include "ESP32_S2_ISR_Timer.hpp"
+
+#include <esp_timer.h>
+
+////////////////////////////////////////
+
+// Number of long-period jobs per ESP32_ISR_LongTimer. They cost nothing per tick, only some RAM (~48 bytes each)
+#ifndef MAX_NUMBER_LONG_TIMERS
+  #define MAX_NUMBER_LONG_TIMERS          32
+#endif
+
+#if (MAX_NUMBER_LONG_TIMERS > 254)
+  #error MAX_NUMBER_LONG_TIMERS must be <= 254
+#endif
+
+// Task computing the next deadline of the cron jobs, created with the first cron job
+#ifndef LONG_TIMER_CRON_TASK_STACK
+  #define LONG_TIMER_CRON_TASK_STACK      2048
+#endif
+
+#ifndef LONG_TIMER_CRON_TASK_PRIORITY
+  #define LONG_TIMER_CRON_TASK_PRIORITY   (configMAX_PRIORITIES - 2)
+#endif
+
+// Longest delay (ms) ever armed in the underlying ESP32_ISR_Timer slot. Far deadlines are reached in several hops,
+// so the unsigned long millis() arithmetic of ESP32_ISR_Timer never wraps
+#ifndef LONG_TIMER_MAX_ARM_MS
+  #define LONG_TIMER_MAX_ARM_MS           3600000UL
+#endif
+
+////////////////////////////////////////
+
+#define LONG_TIMER_MS_PER_MINUTE          60000ULL
+#define LONG_TIMER_MINUTES_PER_DAY        1440UL
+
+// Days of week for long_timer_cron_t.daysOfWeek. 01/01/1970 was a Thursday
+#define LONG_TIMER_SUNDAY                 0x01
+#define LONG_TIMER_MONDAY                 0x02
+#define LONG_TIMER_TUESDAY                0x04
+#define LONG_TIMER_WEDNESDAY              0x08
+#define LONG_TIMER_THURSDAY               0x10
+#define LONG_TIMER_FRIDAY                 0x20
+#define LONG_TIMER_SATURDAY               0x40
+#define LONG_TIMER_EVERY_DAY              0x7F
+
+#define LONG_TIMER_EVERY_MINUTE           0x0FFFFFFFFFFFFFFFULL
+#define LONG_TIMER_EVERY_HOUR             0x00FFFFFFUL
+
+// position of a job not in the deadline heap
+#define LONG_TIMER_NOT_IN_HEAP            0xFF
+
+////////////////////////////////////////
+
+// Cron-like recurrence, matched against the wall clock set by setWallClock() (UTC, unless a local time is given)
+// bit n of minutes => minute n (0-59), bit n of hours => hour n (0-23), bit n of daysOfWeek => day n (0 = Sunday)
+typedef struct
+{
+  uint64_t  minutes;
+  uint32_t  hours;
+  uint8_t   daysOfWeek;
+} long_timer_cron_t;
+
+////////////////////////////////////////
+
+class ESP32_ISR_LongTimer
+{
+  public:
+
+#define LONG_TIMER_TYPE_PERIODIC    0       // every period ms, phase from registration
+#define LONG_TIMER_TYPE_ALIGNED     1       // every period ms, aligned to the wall clock plus offset
+#define LONG_TIMER_TYPE_CRON        2       // cron-like minutes / hours / days-of-week recurrence
+
+    ////////////////////////////////////////
+
+    ESP32_ISR_LongTimer()
+      : _isrTimer(NULL), _slot(-1), _numJobs(0), _epochOffset(0), _heapSize(0), _cronTask(NULL), _cronWake(false)
+    {
+      memset((void*) _jobs, 0, sizeof(_jobs));
+      memset((void*) _heapPos, LONG_TIMER_NOT_IN_HEAP, sizeof(_heapPos));
+    };
+
+    ////////////////////////////////////////
+
+    // Takes one slot of isrTimer, which must already be driven by a hardware timer
+    // Returns false if isrTimer has no free slot
+    bool init(ESP32_ISR_Timer& isrTimer)
+    {
+      _isrTimer = &isrTimer;
+
+      _slot = _isrTimer->setInterval(LONG_TIMER_MAX_ARM_MS, ISRHandler, this);
+
+      if (_slot < 0)
+      {
+        TISR_LOGERROR(F("ESP32_ISR_LongTimer: no free ESP32_ISR_Timer slot"));
+
+        return false;
+      }
+
+      // re-armed with a new delay at each run, the slot must not move the automatic tick of isrTimer
+      _isrTimer->setAutoTickExempt(_slot);
+
+      // jobs added before init()
+      rearm();
+
+      TISR_LOGINFO1(F("ESP32_ISR_LongTimer: using ESP32_ISR_Timer slot = "), _slot);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // 64-bit monotonic time in ms since boot. Never wraps in practice
+    static inline uint64_t IRAM_ATTR now()
+    {
+      return (uint64_t) esp_timer_get_time() / 1000ULL;
+    }
+
+    ////////////////////////////////////////
+
+    // Current wall-clock time in ms, as set by setWallClock()
+    inline uint64_t wallClock()
+    {
+      return now() + _epochOffset;
+    }
+
+    ////////////////////////////////////////
+
+    // Tell the scheduler the current wall-clock time (e.g. Unix time in ms from NTP, plus your time zone offset).
+    // Aligned and cron jobs are re-synchronized. Until called, wall clock == time since boot
+    void setWallClock(const uint64_t& epochMs)
+    {
+      portENTER_CRITICAL(&_mux);
+
+      _epochOffset = epochMs - now();
+
+      portEXIT_CRITICAL(&_mux);
+
+      // one job at a time, the cron walk out of the lock
+      for (uint8_t i = 0; i < MAX_NUMBER_LONG_TIMERS; i++)
+        updateWallDeadline(i);
+
+      rearm();
+    }
+
+    ////////////////////////////////////////
+
+    // Job will call function 'f' every 'periodMs' milliseconds, 'n' times (TIMER_RUN_FOREVER = forever)
+    // returns the job number on success or -1 on failure (f == NULL, periodMs == 0 or no free job)
+    int setInterval(const uint64_t& periodMs, timer_callback f, const unsigned& n = TIMER_RUN_FOREVER)
+    {
+      return setupJob(LONG_TIMER_TYPE_PERIODIC, periodMs, 0, NULL, (void *) f, NULL, false, n);
+    }
+
+    int setInterval(const uint64_t& periodMs, timer_callback_p f, void* p, const unsigned& n = TIMER_RUN_FOREVER)
+    {
+      return setupJob(LONG_TIMER_TYPE_PERIODIC, periodMs, 0, NULL, (void *) f, p, true, n);
+    }
+
+    ////////////////////////////////////////
+
+    // Job will call function 'f' once, after 'delayMs' milliseconds
+    int setTimeout(const uint64_t& delayMs, timer_callback f)
+    {
+      return setupJob(LONG_TIMER_TYPE_PERIODIC, delayMs, 0, NULL, (void *) f, NULL, false, TIMER_RUN_ONCE);
+    }
+
+    int setTimeout(const uint64_t& delayMs, timer_callback_p f, void* p)
+    {
+      return setupJob(LONG_TIMER_TYPE_PERIODIC, delayMs, 0, NULL, (void *) f, p, true, TIMER_RUN_ONCE);
+    }
+
+    ////////////////////////////////////////
+
+    // Job will call function 'f' whenever (wallClock - offsetMs) is a multiple of 'periodMs'.
+    // For example, setAligned(3600000, 0, f) => every hour on the hour, setAligned(86400000, 7200000, f) => 02:00 daily
+    int setAligned(const uint64_t& periodMs, const uint64_t& offsetMs, timer_callback f)
+    {
+      return setupJob(LONG_TIMER_TYPE_ALIGNED, periodMs, offsetMs, NULL, (void *) f, NULL, false, TIMER_RUN_FOREVER);
+    }
+
+    int setAligned(const uint64_t& periodMs, const uint64_t& offsetMs, timer_callback_p f, void* p)
+    {
+      return setupJob(LONG_TIMER_TYPE_ALIGNED, periodMs, offsetMs, NULL, (void *) f, p, true, TIMER_RUN_FOREVER);
+    }
+
+    ////////////////////////////////////////
+
+    // Job will call function 'f' at the start of every minute matching 'cron'
+    int setCron(const long_timer_cron_t& cron, timer_callback f)
+    {
+      return setupJob(LONG_TIMER_TYPE_CRON, 0, 0, &cron, (void *) f, NULL, false, TIMER_RUN_FOREVER);
+    }
+
+    int setCron(const long_timer_cron_t& cron, timer_callback_p f, void* p)
+    {
+      return setupJob(LONG_TIMER_TYPE_CRON, 0, 0, &cron, (void *) f, p, true, TIMER_RUN_FOREVER);
+    }
+
+    ////////////////////////////////////////
+
+    // destroy the specified job
+    void deleteTimer(const unsigned& numJob)
+    {
+      if (numJob >= MAX_NUMBER_LONG_TIMERS)
+      {
+        return;
+      }
+
+      portENTER_CRITICAL(&_mux);
+
+      if (_jobs[numJob].callback != NULL)
+      {
+        freeJob(numJob);
+      }
+
+      portEXIT_CRITICAL(&_mux);
+
+      rearm();
+    }
+
+    ////////////////////////////////////////
+
+    // Monotonic time (see now()) of the specified job's next run, or 0 if not used
+    uint64_t getNextRun(const unsigned& numJob)
+    {
+      if (numJob >= MAX_NUMBER_LONG_TIMERS)
+      {
+        return 0;
+      }
+
+      return _jobs[numJob].deadline;
+    }
+
+    ////////////////////////////////////////
+
+    // Monotonic time (see now()) of the nearest deadline of all jobs, or 0 if no job
+    uint64_t getNextDeadline()
+    {
+      portENTER_CRITICAL(&_mux);
+
+      uint64_t nearest = (_heapSize > 0) ? _jobs[_heap[0]].deadline : 0;
+
+      portEXIT_CRITICAL(&_mux);
+
+      return nearest;
+    }
+
+    ////////////////////////////////////////
+
+    // returns the number of used jobs
+    unsigned getNumTimers()
+    {
+      return _numJobs;
+    }
+
+    ////////////////////////////////////////
+
+    // returns the number of available jobs
+    unsigned getNumAvailableTimers()
+    {
+      return MAX_NUMBER_LONG_TIMERS - _numJobs;
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    typedef struct
+    {
+      uint64_t          deadline;         // next run, in monotonic ms (see now())
+      uint64_t          period;           // period for periodic and aligned jobs
+      uint64_t          offset;           // wall-clock offset for aligned jobs
+      long_timer_cron_t cron;             // recurrence for cron jobs
+      void*             callback;         // pointer to the callback function
+      void*             param;            // function parameter
+      bool              hasParam;         // true if callback takes a parameter
+      uint8_t           type;             // LONG_TIMER_TYPE_xxx
+      unsigned          maxNumRuns;       // number of runs to be executed
+      unsigned          numRuns;          // number of executed runs
+      bool              toBeCalled;       // deferred function call - N.B.: only used in process()
+      bool              cronPending;      // cron job out of the heap, waiting for the cron task
+    } long_job_t;
+
+    ////////////////////////////////////////
+
+    ESP32_ISR_Timer*  _isrTimer;
+    int               _slot;              // ESP32_ISR_Timer slot used to arm the nearest deadline
+
+    volatile long_job_t _jobs[MAX_NUMBER_LONG_TIMERS];
+    volatile unsigned   _numJobs;
+
+    volatile uint64_t   _epochOffset;     // wall clock - monotonic time, in ms
+
+    // min-heap of the job numbers by deadline, and position of each job in it, or LONG_TIMER_NOT_IN_HEAP
+    uint8_t             _heap[MAX_NUMBER_LONG_TIMERS];
+    uint8_t             _heapPos[MAX_NUMBER_LONG_TIMERS];
+    uint8_t             _heapSize;
+
+    TaskHandle_t        _cronTask;
+    volatile bool       _cronWake;        // cron task to be notified, retried at the next run if not accepted
+
+    // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+    portMUX_TYPE      _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    ////////////////////////////////////////
+
+    int setupJob(const uint8_t& type, const uint64_t& period, const uint64_t& offset, const long_timer_cron_t* cron,
+                 void* f, void* p, bool h, const unsigned& n)
+    {
+      if ( (f == NULL) || ( (type != LONG_TIMER_TYPE_CRON) && (period == 0) ) )
+      {
+        return -1;
+      }
+
+      if ( (type == LONG_TIMER_TYPE_CRON) && ( ( (cron->minutes & LONG_TIMER_EVERY_MINUTE) == 0 ) ||
+                                               ( (cron->hours & LONG_TIMER_EVERY_HOUR) == 0 ) ||
+                                               ( (cron->daysOfWeek & LONG_TIMER_EVERY_DAY) == 0 ) ) )
+      {
+        TISR_LOGERROR(F("ESP32_ISR_LongTimer: cron never matches"));
+
+        return -1;
+      }
+
+      if ( (type == LONG_TIMER_TYPE_CRON) && (_cronTask == NULL) &&
+           (xTaskCreatePinnedToCore(cronTask, "LongTimerCron", LONG_TIMER_CRON_TASK_STACK, this,
+                                    LONG_TIMER_CRON_TASK_PRIORITY, &_cronTask, tskNO_AFFINITY) != pdPASS) )
+      {
+        TISR_LOGERROR(F("ESP32_ISR_LongTimer: can't create the cron task"));
+
+        _cronTask = NULL;
+
+        return -1;
+      }
+
+      // first deadline, computed out of the lock
+      long_job_t newJob;
+
+      memset((void*) &newJob, 0, sizeof(newJob));
+
+      newJob.type       = type;
+      newJob.period     = period;
+      newJob.offset     = offset;
+
+      if (cron)
+        newJob.cron     = *cron;
+
+      newJob.callback   = f;
+      newJob.param      = p;
+      newJob.hasParam   = h;
+      newJob.maxNumRuns = n;
+
+      uint64_t epochOffset = _epochOffset;
+
+      if (type == LONG_TIMER_TYPE_PERIODIC)
+      {
+        newJob.deadline = now() + period;
+      }
+      else
+      {
+        newJob.deadline = nextWallDeadline(newJob, now() + epochOffset) - epochOffset;
+      }
+
+      int freeJob = -1;
+
+      portENTER_CRITICAL(&_mux);
+
+      for (uint8_t i = 0; i < MAX_NUMBER_LONG_TIMERS; i++)
+      {
+        if (_jobs[i].callback == NULL)
+        {
+          freeJob = i;
+          break;
+        }
+      }
+
+      if (freeJob >= 0)
+      {
+        memcpy((void*) &_jobs[freeJob], &newJob, sizeof(long_job_t));
+
+        heapInsert(freeJob);
+
+        _numJobs++;
+      }
+
+      portEXIT_CRITICAL(&_mux);
+
+      if (freeJob >= 0)
+      {
+        rearm();
+      }
+
+      return freeJob;
+    }
+
+    ////////////////////////////////////////
+
+    // Index of the lowest set bit of mask at or above 'from', below 'limit', or -1
+    static inline int IRAM_ATTR nextBit(const uint64_t mask, int from, const int limit)
+    {
+      for ( ; from < limit; from++)
+      {
+        if (mask & (1ULL << from))
+          return from;
+      }
+
+      return -1;
+    }
+
+    ////////////////////////////////////////
+
+    // Next wall-clock time (ms) strictly after 'wall' matching the aligned or cron job
+    static uint64_t nextWallDeadline(const long_job_t& job, const uint64_t& wall)
+    {
+      if (job.type == LONG_TIMER_TYPE_ALIGNED)
+      {
+        // offset can be larger than period, only the phase matters
+        uint64_t phase = job.offset % job.period;
+
+        if (wall < phase)
+          return phase;
+
+        return wall - ( (wall - phase) % job.period ) + job.period;
+      }
+
+      // LONG_TIMER_TYPE_CRON : walk days, then hours, then minutes. At most 8 days are visited
+      uint64_t minute = (wall / LONG_TIMER_MS_PER_MINUTE) + 1;
+
+      for (uint16_t guard = 0; guard < 8 * 25; guard++)
+      {
+        uint64_t day      = minute / LONG_TIMER_MINUTES_PER_DAY;
+        int      hour     = (minute % LONG_TIMER_MINUTES_PER_DAY) / 60;
+        int      min      = minute % 60;
+
+        if ( (job.cron.daysOfWeek & (1 << ( (day + 4) % 7) ) ) == 0 )
+        {
+          minute = (day + 1) * LONG_TIMER_MINUTES_PER_DAY;
+          continue;
+        }
+
+        int nextHour = nextBit(job.cron.hours, hour, 24);
+
+        if (nextHour < 0)
+        {
+          minute = (day + 1) * LONG_TIMER_MINUTES_PER_DAY;
+          continue;
+        }
+
+        if (nextHour != hour)
+        {
+          hour  = nextHour;
+          min   = 0;
+        }
+
+        int nextMin = nextBit(job.cron.minutes, min, 60);
+
+        if (nextMin < 0)
+        {
+          minute = (day * LONG_TIMER_MINUTES_PER_DAY) + (hour + 1) * 60;
+          continue;
+        }
+
+        return ( (day * LONG_TIMER_MINUTES_PER_DAY) + hour * 60 + nextMin ) * LONG_TIMER_MS_PER_MINUTE;
+      }
+
+      // Not reachable with a valid cron, as validated in setupJob()
+      return wall + LONG_TIMER_MS_PER_MINUTE;
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held. a before b in the heap
+    inline bool IRAM_ATTR heapBefore(const uint8_t& a, const uint8_t& b)
+    {
+      return (_jobs[_heap[a]].deadline < _jobs[_heap[b]].deadline);
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held
+    void IRAM_ATTR heapSwap(const uint8_t& a, const uint8_t& b)
+    {
+      uint8_t job = _heap[a];
+
+      _heap[a]            = _heap[b];
+      _heap[b]            = job;
+      _heapPos[_heap[a]]  = a;
+      _heapPos[_heap[b]]  = b;
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held. Moves the entry at pos to its place, after a change of its deadline
+    void IRAM_ATTR heapFix(uint8_t pos)
+    {
+      while ( (pos > 0) && heapBefore(pos, (pos - 1) / 2) )
+      {
+        heapSwap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+      }
+
+      while (true)
+      {
+        uint8_t first = pos;
+        uint8_t left  = 2 * pos + 1;
+
+        if ( (left < _heapSize) && heapBefore(left, first) )
+          first = left;
+
+        if ( (left + 1 < _heapSize) && heapBefore(left + 1, first) )
+          first = left + 1;
+
+        if (first == pos)
+          break;
+
+        heapSwap(pos, first);
+        pos = first;
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held
+    void IRAM_ATTR heapInsert(const uint8_t& numJob)
+    {
+      _heap[_heapSize]  = numJob;
+      _heapPos[numJob]  = _heapSize;
+      _heapSize++;
+
+      heapFix(_heapSize - 1);
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held. No-op if the job is not in the heap
+    void IRAM_ATTR heapRemove(const uint8_t& numJob)
+    {
+      uint8_t pos = _heapPos[numJob];
+
+      if (pos == LONG_TIMER_NOT_IN_HEAP)
+        return;
+
+      _heapSize--;
+      _heapPos[numJob] = LONG_TIMER_NOT_IN_HEAP;
+
+      if (pos < _heapSize)
+      {
+        _heap[pos]            = _heap[_heapSize];
+        _heapPos[_heap[pos]]  = pos;
+
+        heapFix(pos);
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held
+    void IRAM_ATTR freeJob(const uint8_t& numJob)
+    {
+      heapRemove(numJob);
+
+      memset((void*) &_jobs[numJob], 0, sizeof(long_job_t));
+      _numJobs--;
+    }
+
+    ////////////////////////////////////////
+
+    // Recomputes the deadline of an aligned or cron job from the wall clock, with the cron walk out of the lock
+    void updateWallDeadline(const uint8_t& numJob)
+    {
+      long_job_t job;
+
+      portENTER_CRITICAL(&_mux);
+
+      memcpy(&job, (const void*) &_jobs[numJob], sizeof(long_job_t));
+
+      portEXIT_CRITICAL(&_mux);
+
+      if ( (job.callback == NULL) || (job.type == LONG_TIMER_TYPE_PERIODIC) )
+        return;
+
+      uint64_t epochOffset  = _epochOffset;
+      uint64_t deadline     = nextWallDeadline(job, now() + epochOffset) - epochOffset;
+
+      portENTER_CRITICAL(&_mux);
+
+      // unless deleted and maybe replaced meanwhile
+      if ( (_jobs[numJob].callback == job.callback) && (_jobs[numJob].type == job.type) )
+      {
+        _jobs[numJob].deadline    = deadline;
+        _jobs[numJob].cronPending = false;
+
+        if (_heapPos[numJob] == LONG_TIMER_NOT_IN_HEAP)
+          heapInsert(numJob);
+        else
+          heapFix(_heapPos[numJob]);
+      }
+
+      portEXIT_CRITICAL(&_mux);
+    }
+
+    ////////////////////////////////////////
+
+    // Puts the cron jobs run by process() back in the heap, with their next deadline
+    void updateCronJobs()
+    {
+      for (uint8_t i = 0; i < MAX_NUMBER_LONG_TIMERS; i++)
+      {
+        if (_jobs[i].cronPending)
+          updateWallDeadline(i);
+      }
+
+      rearm();
+    }
+
+    ////////////////////////////////////////
+
+    static void cronTask(void* longTimer)
+    {
+      while (true)
+      {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        ( (ESP32_ISR_LongTimer*) longTimer)->updateCronJobs();
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Arm the ESP32_ISR_Timer slot for the nearest deadline, capped to LONG_TIMER_MAX_ARM_MS
+    void IRAM_ATTR rearm()
+    {
+      if (_slot < 0)
+        return;
+
+      portENTER_CRITICAL_SAFE(&_mux);
+
+      uint64_t nearest  = (_heapSize > 0) ? _jobs[_heap[0]].deadline : 0;
+      uint64_t currTime = now();
+
+      portEXIT_CRITICAL_SAFE(&_mux);
+
+      unsigned long delay = LONG_TIMER_MAX_ARM_MS;
+
+      if (nearest != 0)
+      {
+        if (nearest <= currTime)
+          delay = 1;
+        else if (nearest - currTime < LONG_TIMER_MAX_ARM_MS)
+          delay = (unsigned long) (nearest - currTime);
+      }
+
+      if (_cronWake)
+        delay = 1;
+
+      _isrTimer->changeInterval(_slot, delay);
+    }
+
+    ////////////////////////////////////////
+
+    static void IRAM_ATTR ISRHandler(void* longTimer)
+    {
+      ( (ESP32_ISR_LongTimer*) longTimer)->process();
+    }
+
+    ////////////////////////////////////////
+
+    // Called from ESP32_ISR_Timer::run() when the nearest deadline (or a LONG_TIMER_MAX_ARM_MS hop) is reached.
+    // Only the due jobs are visited, from the top of the heap. Periodic and aligned jobs get their next deadline here,
+    // cron jobs leave the heap until the cron task computes it
+    void IRAM_ATTR process()
+    {
+      uint64_t  currTime  = now();
+      uint8_t   due[MAX_NUMBER_LONG_TIMERS];
+      uint8_t   numDue    = 0;
+      bool      cronDue   = false;
+
+      portENTER_CRITICAL_ISR(&_mux);
+
+      while ( (_heapSize > 0) && (_jobs[_heap[0]].deadline <= currTime) )
+      {
+        uint8_t               i   = _heap[0];
+        volatile long_job_t&  job = _jobs[i];
+
+        job.toBeCalled  = true;
+        due[numDue++]   = i;
+
+        if (job.type == LONG_TIMER_TYPE_PERIODIC)
+        {
+          // skip missed periods, as ESP32_ISR_Timer::run() does
+          job.deadline += job.period * ( ( (currTime - job.deadline) / job.period ) + 1);
+          heapFix(0);
+        }
+        else if (job.type == LONG_TIMER_TYPE_ALIGNED)
+        {
+          uint64_t wall   = currTime + _epochOffset;
+          uint64_t phase  = job.offset % job.period;
+
+          // next multiple after wall, as nextWallDeadline(). wall >= phase, as the job was due
+          job.deadline = wall - ( (wall - phase) % job.period ) + job.period - _epochOffset;
+          heapFix(0);
+        }
+        else
+        {
+          job.cronPending = true;
+          heapRemove(i);
+          cronDue = true;
+        }
+      }
+
+      portEXIT_CRITICAL_ISR(&_mux);
+
+      for (uint8_t k = 0; k < numDue; k++)
+      {
+        volatile long_job_t& job = _jobs[due[k]];
+
+        // unless deleted by a previous callback
+        if (!job.toBeCalled)
+          continue;
+
+        job.toBeCalled = false;
+
+        if (job.hasParam)
+          (*(timer_callback_p) job.callback)(job.param);
+        else
+          (*(timer_callback) job.callback)();
+
+        if ( (job.callback != NULL) && (job.maxNumRuns != TIMER_RUN_FOREVER) && (++job.numRuns >= job.maxNumRuns) )
+        {
+          portENTER_CRITICAL_ISR(&_mux);
+
+          freeJob(due[k]);
+
+          portEXIT_CRITICAL_ISR(&_mux);
+        }
+      }
+
+      if (cronDue)
+        _cronWake = true;
+
+      // through run(), which notifies out of its lock
+      if (_cronWake && _cronTask && _isrTimer->notifyFromRun(_cronTask, 1))
+        _cronWake = false;
+
+      rearm();
+    }
+
+    ////////////////////////////////////////
+
+}; // class ESP32_ISR_LongTimer
+
+#endif    // ISR_LONG_TIMER_GENERIC_H
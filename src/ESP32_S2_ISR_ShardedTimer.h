@@ -0,0 +1,460 @@
+/****************************************************************************************************************************
+  ESP32_S2_ISR_ShardedTimer.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_ISR_ShardedTimer runs one ESP32_ISR_Timer shard per core, each driven by its own hardware timer pinned to that
+  core. Timers are registered in the shard of the calling core, so their spinlock is never contended by the other
+  core, and operations on a timer of the other core are sent to it through a FreeRTOS queue, drained by its ISR.
+  On single core chips, such as the ESP32_S2 (portNUM_PROCESSORS = 1), it collapses to one shard, without queue:
+  the sharding is then inert, and only kept for code shared with dual core ESP32 boards.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+
+#pragma once
+
+#ifndef ISR_SHARDED_TIMER_GENERIC_H
+#define ISR_SHARDED_TIMER_GENERIC_H
+
+////////////////////////////////////////
+
+#include "ESP32_S2_TimerInterrupt.h"
+#include "ESP32_S2_ISR_Timer.hpp"
+
+////////////////////////////////////////
+
+// One shard per core by default
+#ifndef ESP32_SHARDED_TIMER_NUM_SHARDS
+  #define ESP32_SHARDED_TIMER_NUM_SHARDS    portNUM_PROCESSORS
+#endif
+
+#if (ESP32_SHARDED_TIMER_NUM_SHARDS > portNUM_PROCESSORS)
+  #error ESP32_SHARDED_TIMER_NUM_SHARDS must be <= portNUM_PROCESSORS
+#endif
+
+// Cross-core operations waiting for the next tick of a shard
+#ifndef ESP32_SHARDED_TIMER_QUEUE_LEN
+  #define ESP32_SHARDED_TIMER_QUEUE_LEN     8
+#endif
+
+// Sharded timer id: shard (core) in bits 8 and up, timer number of the shard in bits 0 to 7
+#define SHARDED_TIMER_ID(shard, numTimer)   ( ( (shard) << 8 ) | (numTimer) )
+#define SHARDED_TIMER_SHARD(timerId)        ( (timerId) >> 8 )
+#define SHARDED_TIMER_NUM(timerId)          ( (timerId) & 0xFF )
+
+////////////////////////////////////////
+
+// Operations sent to the shard of another core
+#define SHARDED_TIMER_OP_DELETE     0
+#define SHARDED_TIMER_OP_RESTART    1
+#define SHARDED_TIMER_OP_ENABLE     2
+#define SHARDED_TIMER_OP_DISABLE    3
+#define SHARDED_TIMER_OP_INTERVAL   4
+
+typedef struct
+{
+  uint8_t       op;                 // SHARDED_TIMER_OP_xxx
+  uint8_t       numTimer;           // timer number in the shard
+  unsigned long value;              // new interval of SHARDED_TIMER_OP_INTERVAL
+} sharded_timer_msg_t;
+
+////////////////////////////////////////
+
+class ESP32_ISR_ShardedTimer
+{
+  public:
+
+    ////////////////////////////////////////
+
+    ESP32_ISR_ShardedTimer()
+    {
+      for (uint8_t s = 0; s < ESP32_SHARDED_TIMER_NUM_SHARDS; s++)
+      {
+        _shards[s].owner      = this;
+        _shards[s].index      = s;
+        _shards[s].hwTimer    = NULL;
+        _shards[s].queue      = NULL;
+        _shards[s].callbackNo = -1;
+        _shards[s].failedOps  = 0;
+      }
+
+      _lastFailedTimer = -1;
+    }
+
+    ////////////////////////////////////////
+
+    // Drives the shard of 'core' with 'timer', ticking every intervalUs. The timer interrupt is allocated on that core
+    // (setCoreAffinity()), so must not be started yet. Call once per core
+    bool attachShard(const uint8_t& core, ESP32TimerInterrupt& timer, const unsigned long& intervalUs)
+    {
+      if ( (core >= ESP32_SHARDED_TIMER_NUM_SHARDS) || (_shards[core].hwTimer != NULL) )
+      {
+        TISR_LOGERROR1(F("ESP32_ISR_ShardedTimer: invalid or already attached shard ="), core);
+
+        return false;
+      }
+
+      shard_t* shard = &_shards[core];
+
+      shard->timer.init();
+
+#if (ESP32_SHARDED_TIMER_NUM_SHARDS > 1)
+
+      if (shard->queue == NULL)
+        shard->queue = xQueueCreate(ESP32_SHARDED_TIMER_QUEUE_LEN, sizeof(sharded_timer_msg_t));
+
+      if (shard->queue == NULL)
+      {
+        TISR_LOGERROR(F("ESP32_ISR_ShardedTimer: can't create queue"));
+
+        return false;
+      }
+
+#endif
+
+      if ( !timer.setCoreAffinity((ESP32_SHARDED_TIMER_NUM_SHARDS > 1) ? core : ESP32_S2_TIMER_ANY_CORE) ||
+           !timer.attachInterruptInterval(intervalUs, NULL) )
+      {
+        return false;
+      }
+
+      shard->callbackNo = timer.addCallback(shardISR, shard);
+
+      if (shard->callbackNo < 0)
+        return false;
+
+      shard->hwTimer = &timer;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Timers are registered in the shard of the calling core, or in the first attached one if that core has none.
+    // Same arguments as ESP32_ISR_Timer. Return a sharded timer id, or -1 on failure
+
+    int setInterval(const unsigned long& d, timer_callback f)
+    {
+      int s = registrationShard();
+
+      return (s < 0) ? -1 : toTimerId(s, _shards[s].timer.setInterval(d, f));
+    }
+
+    int setInterval(const unsigned long& d, timer_callback_p f, void* p)
+    {
+      int s = registrationShard();
+
+      return (s < 0) ? -1 : toTimerId(s, _shards[s].timer.setInterval(d, f, p));
+    }
+
+    int setTimeout(const unsigned long& d, timer_callback f)
+    {
+      int s = registrationShard();
+
+      return (s < 0) ? -1 : toTimerId(s, _shards[s].timer.setTimeout(d, f));
+    }
+
+    int setTimeout(const unsigned long& d, timer_callback_p f, void* p)
+    {
+      int s = registrationShard();
+
+      return (s < 0) ? -1 : toTimerId(s, _shards[s].timer.setTimeout(d, f, p));
+    }
+
+    int setTimer(const unsigned long& d, timer_callback f, const unsigned& n)
+    {
+      int s = registrationShard();
+
+      return (s < 0) ? -1 : toTimerId(s, _shards[s].timer.setTimer(d, f, n));
+    }
+
+    int setTimer(const unsigned long& d, timer_callback_p f, void* p, const unsigned& n)
+    {
+      int s = registrationShard();
+
+      return (s < 0) ? -1 : toTimerId(s, _shards[s].timer.setTimer(d, f, p, n));
+    }
+
+    ////////////////////////////////////////
+
+    // Operations on a timer of the calling core's shard are done now. Those on a timer of another shard are queued,
+    // done at its next tick. Safe in ISR
+    // return false for an invalid id, a non-used timer of the calling core's shard, or a full queue. The queued ones
+    // failing later are counted by getFailedOps()
+
+    bool IRAM_ATTR deleteTimer(const int& timerId)
+    {
+      return dispatch(timerId, SHARDED_TIMER_OP_DELETE, 0);
+    }
+
+    bool IRAM_ATTR restartTimer(const int& timerId)
+    {
+      return dispatch(timerId, SHARDED_TIMER_OP_RESTART, 0);
+    }
+
+    bool IRAM_ATTR enable(const int& timerId)
+    {
+      return dispatch(timerId, SHARDED_TIMER_OP_ENABLE, 0);
+    }
+
+    bool IRAM_ATTR disable(const int& timerId)
+    {
+      return dispatch(timerId, SHARDED_TIMER_OP_DISABLE, 0);
+    }
+
+    bool IRAM_ATTR changeInterval(const int& timerId, const unsigned long& d)
+    {
+      return dispatch(timerId, SHARDED_TIMER_OP_INTERVAL, d);
+    }
+
+    ////////////////////////////////////////
+
+    // Read only, from any core
+    bool isEnabled(const int& timerId)
+    {
+      uint8_t s = SHARDED_TIMER_SHARD(timerId);
+
+      if ( (timerId < 0) || (s >= ESP32_SHARDED_TIMER_NUM_SHARDS) || (_shards[s].hwTimer == NULL) )
+        return false;
+
+      return _shards[s].timer.isEnabled(SHARDED_TIMER_NUM(timerId));
+    }
+
+    ////////////////////////////////////////
+
+    // Number of used timers in all shards
+    unsigned getNumTimers()
+    {
+      unsigned numTimers = 0;
+
+      for (uint8_t s = 0; s < ESP32_SHARDED_TIMER_NUM_SHARDS; s++)
+      {
+        if (_shards[s].hwTimer)
+          numTimers += _shards[s].timer.getNumTimers();
+      }
+
+      return numTimers;
+    }
+
+    ////////////////////////////////////////
+
+    // Number of queued operations which failed when applied by the shard of another core (non-used timer or invalid
+    // interval), e.g. a timer deleted meanwhile
+    uint32_t getFailedOps()
+    {
+      uint32_t failedOps = 0;
+
+      for (uint8_t s = 0; s < ESP32_SHARDED_TIMER_NUM_SHARDS; s++)
+        failedOps += _shards[s].failedOps;
+
+      return failedOps;
+    }
+
+    // Sharded timer id of the last failed queued operation, -1 if none
+    int getLastFailedTimer()
+    {
+      return _lastFailedTimer;
+    }
+
+    void clearFailedOps()
+    {
+      for (uint8_t s = 0; s < ESP32_SHARDED_TIMER_NUM_SHARDS; s++)
+        _shards[s].failedOps = 0;
+
+      _lastFailedTimer = -1;
+    }
+
+    ////////////////////////////////////////
+
+    // The ESP32_ISR_Timer of one shard, for the other settings (priorities, domains, etc.). Best called from its core
+    ESP32_ISR_Timer& getShard(const uint8_t& core)
+    {
+      return _shards[(core < ESP32_SHARDED_TIMER_NUM_SHARDS) ? core : 0].timer;
+    }
+
+    ////////////////////////////////////////
+
+    static constexpr uint8_t getNumShards()
+    {
+      return ESP32_SHARDED_TIMER_NUM_SHARDS;
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    typedef struct
+    {
+      ESP32_ISR_Timer         timer;
+      ESP32_ISR_ShardedTimer* owner;
+      uint8_t                 index;          // shard number, i.e. its core
+      ESP32TimerInterrupt*    hwTimer;        // NULL if not attached
+      QueueHandle_t           queue;          // operations from the other cores, NULL with only one shard
+      int8_t                  callbackNo;     // chained callback of hwTimer
+      volatile uint32_t       failedOps;      // queued operations failed, only written by the shard's core
+    } shard_t;
+
+    shard_t       _shards[ESP32_SHARDED_TIMER_NUM_SHARDS];
+
+    // written by the shard of either core, a single 32-bit store
+    volatile int  _lastFailedTimer;
+
+    ////////////////////////////////////////
+
+    static inline uint8_t IRAM_ATTR localShard() __attribute__((always_inline))
+    {
+#if (ESP32_SHARDED_TIMER_NUM_SHARDS > 1)
+      return xPortGetCoreID();
+#else
+      return 0;
+#endif
+    }
+
+    ////////////////////////////////////////
+
+    // A task migrated to the other core meanwhile is still correct, only contends the other shard's spinlock
+    int registrationShard()
+    {
+      uint8_t s = localShard();
+
+      if (_shards[s].hwTimer)
+        return s;
+
+      for (s = 0; s < ESP32_SHARDED_TIMER_NUM_SHARDS; s++)
+      {
+        if (_shards[s].hwTimer)
+          return s;
+      }
+
+      TISR_LOGERROR(F("ESP32_ISR_ShardedTimer: no shard attached"));
+
+      return -1;
+    }
+
+    ////////////////////////////////////////
+
+    static int toTimerId(const int& shard, const int& numTimer)
+    {
+      return (numTimer < 0) ? -1 : SHARDED_TIMER_ID(shard, numTimer);
+    }
+
+    ////////////////////////////////////////
+
+    bool IRAM_ATTR dispatch(const int& timerId, const uint8_t& op, const unsigned long& value)
+    {
+      uint8_t s = SHARDED_TIMER_SHARD(timerId);
+
+      if ( (timerId < 0) || (s >= ESP32_SHARDED_TIMER_NUM_SHARDS) || (_shards[s].hwTimer == NULL) )
+        return false;
+
+#if (ESP32_SHARDED_TIMER_NUM_SHARDS > 1)
+
+      if (s != localShard())
+      {
+        sharded_timer_msg_t msg = { op, (uint8_t) SHARDED_TIMER_NUM(timerId), value };
+
+        // never blocks: the shard may be busy for a whole tick
+        if (xPortInIsrContext())
+          return (xQueueSendFromISR(_shards[s].queue, &msg, NULL) == pdTRUE);
+
+        return (xQueueSend(_shards[s].queue, &msg, 0) == pdTRUE);
+      }
+
+#endif
+
+      return apply(_shards[s].timer, op, SHARDED_TIMER_NUM(timerId), value);
+    }
+
+    ////////////////////////////////////////
+
+    static bool IRAM_ATTR apply(ESP32_ISR_Timer& timer, const uint8_t& op, const uint8_t& numTimer,
+                                const unsigned long& value)
+    {
+      // deleted meanwhile, e.g. a timeout already run
+      if (!timer.isUsed(numTimer))
+        return false;
+
+      switch (op)
+      {
+        case SHARDED_TIMER_OP_DELETE:
+          timer.deleteTimer(numTimer);
+          break;
+
+        case SHARDED_TIMER_OP_RESTART:
+          timer.restartTimer(numTimer);
+          break;
+
+        case SHARDED_TIMER_OP_ENABLE:
+          timer.enable(numTimer);
+          break;
+
+        case SHARDED_TIMER_OP_DISABLE:
+          timer.disable(numTimer);
+          break;
+
+        case SHARDED_TIMER_OP_INTERVAL:
+          return timer.changeInterval(numTimer, value);
+
+        default:
+          return false;
+      }
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Chained callback of each shard's hardware timer, on the shard's core. Called out of the hardware timer's lock,
+    // so the shard's run() sends its task notifications out of any lock
+    static bool IRAM_ATTR shardISR(void * context)
+    {
+      shard_t* shard = (shard_t*) context;
+
+#if (ESP32_SHARDED_TIMER_NUM_SHARDS > 1)
+
+      sharded_timer_msg_t msg;
+
+      while (xQueueReceiveFromISR(shard->queue, &msg, NULL) == pdTRUE)
+      {
+        // the sender already got true: report the failure here
+        if (!apply(shard->timer, msg.op, msg.numTimer, msg.value))
+        {
+          shard->failedOps++;
+          shard->owner->_lastFailedTimer = SHARDED_TIMER_ID(shard->index, msg.numTimer);
+        }
+      }
+
+#endif
+
+      return shard->timer.run();
+    }
+};
+
+#endif    // ISR_SHARDED_TIMER_GENERIC_H
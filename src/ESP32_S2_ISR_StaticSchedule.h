@@ -0,0 +1,259 @@
+/****************************************************************************************************************************
+  ESP32_S2_ISR_StaticSchedule.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_ISR_StaticSchedule runs a fixed firmware schedule described by a constexpr table of period / callback / runs.
+  The table stays in flash, the periods are checked against the tick at compile time (ISR_TIMER_STATIC_SCHEDULE) and
+  again by init(), and the only RAM used at run time
+  is one countdown and one run counter per entry, instead of a full ESP32_ISR_Timer slot each.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ISR_STATIC_SCHEDULE_GENERIC_H
+#define ISR_STATIC_SCHEDULE_GENERIC_H
+
+////////////////////////////////////////
+
+#include "ESP32_S2_ISR_Timer.hpp"
+
+#include <stddef.h>
+
+////////////////////////////////////////
+
+// One entry of a static schedule. Declare the table constexpr so that it's placed in flash, for example
+//
+//   constexpr ISRTimerSchedule_t schedule[] =
+//   {
+//     // period (ms), callback, param, numRuns
+//     {  100, doingSomething, &data[0], TIMER_RUN_FOREVER },
+//     { 5000, doingSomething, &data[1], 3 },
+//   };
+//
+// param must be a constant expression: nullptr or the address of a global / static object, not a cast integer.
+// With USING_ESP32_S2_TIMER_IRAM, the table is read in the ISR while the flash cache may be disabled, so declare it
+// DRAM_ATTR instead of constexpr
+typedef struct
+{
+  unsigned long     period;               // in ms, a non-zero multiple of the tick
+  timer_callback_p  callback;
+  void*             param;
+  uint32_t          numRuns;              // TIMER_RUN_FOREVER or number of runs
+} ISRTimerSchedule_t;
+
+////////////////////////////////////////
+
+// Compile-time checks of a whole table. C++11 constexpr, so one return statement and recursion
+constexpr bool ISRTimerScheduleValid(const ISRTimerSchedule_t* table, const size_t numEntries, const unsigned long tickMs)
+{
+  return (numEntries == 0) ||
+         ( (tickMs > 0) && (table[0].period >= tickMs) && (table[0].period % tickMs == 0) &&
+           (table[0].callback != nullptr) && ISRTimerScheduleValid(table + 1, numEntries - 1, tickMs) );
+}
+
+////////////////////////////////////////
+
+#define ISR_TIMER_SCHEDULE_SIZE(table)          ( sizeof(table) / sizeof((table)[0]) )
+
+// Use after the table, with the same tick as the template parameter of ESP32_ISR_StaticSchedule
+#define ISR_TIMER_SCHEDULE_CHECK(table, tickMs) \
+  static_assert(ISRTimerScheduleValid(table, ISR_TIMER_SCHEDULE_SIZE(table), tickMs), \
+                #table ": each period must be a non-zero multiple of the tick, and each callback not NULL")
+
+// Declares the schedule 'name' running 'table', checked at compile time
+#define ISR_TIMER_STATIC_SCHEDULE(name, table, tickMs) \
+  ISR_TIMER_SCHEDULE_CHECK(table, tickMs); \
+  ESP32_ISR_StaticSchedule<ISR_TIMER_SCHEDULE_SIZE(table), tickMs> name(table)
+
+////////////////////////////////////////
+
+// NumEntries : ISR_TIMER_SCHEDULE_SIZE(table)
+// TickMs     : interval (ms) between two calls of run(), normally the hardware timer interval
+template <size_t NumEntries, unsigned long TickMs>
+class ESP32_ISR_StaticSchedule
+{
+    static_assert(NumEntries > 0, "Empty static schedule");
+    static_assert(TickMs > 0, "Tick must be > 0 ms");
+
+  public:
+
+    ////////////////////////////////////////
+
+    ESP32_ISR_StaticSchedule(const ISRTimerSchedule_t (&table)[NumEntries]) : _table(table)
+    {
+    }
+
+    ////////////////////////////////////////
+
+    // Builds the dispatch counters from the table and enables all entries. Call before the hardware timer is started
+    // Returns false, with all entries disabled, if an entry has a period not a non-zero multiple of TickMs (it would
+    // never run) or a NULL callback: a table declared without ISR_TIMER_STATIC_SCHEDULE / ISR_TIMER_SCHEDULE_CHECK
+    bool init()
+    {
+      for (size_t i = 0; i < NumEntries; i++)
+      {
+        if ( !ISRTimerScheduleValid(&_table[i], 1, TickMs) )
+        {
+          TISR_LOGERROR3(F("ESP32_ISR_StaticSchedule: invalid entry = "), i, F(", period = "), _table[i].period);
+
+          portENTER_CRITICAL(&_mux);
+
+          for (size_t k = 0; k < NumEntries; k++)
+            _countdown[k] = 0;
+
+          portEXIT_CRITICAL(&_mux);
+
+          return false;
+        }
+      }
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_mux);
+
+      for (size_t i = 0; i < NumEntries; i++)
+        restartEntry(i);
+
+      portEXIT_CRITICAL(&_mux);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called from the hardware timer ISR every TickMs
+    void IRAM_ATTR run()
+    {
+      portENTER_CRITICAL_ISR(&_mux);
+
+      for (size_t i = 0; i < NumEntries; i++)
+      {
+        // countdown == 0 => disabled or all runs done
+        if ( (_countdown[i] == 0) || (--_countdown[i] != 0) )
+          continue;
+
+        const ISRTimerSchedule_t& entry = _table[i];
+
+        // TickMs is a compile-time constant, no run-time division
+        _countdown[i] = entry.period / TickMs;
+
+        if ( (entry.numRuns != TIMER_RUN_FOREVER) && (--_runsLeft[i] == 0) )
+          _countdown[i] = 0;
+
+        entry.callback(entry.param);
+      }
+
+      portEXIT_CRITICAL_ISR(&_mux);
+    }
+
+    ////////////////////////////////////////
+
+    // Restarts the entry from a full period, with all its runs. Returns false for an invalid entry, as init()
+    bool enable(const size_t& numEntry)
+    {
+      if ( (numEntry >= NumEntries) || !ISRTimerScheduleValid(&_table[numEntry], 1, TickMs) )
+        return false;
+
+      portENTER_CRITICAL(&_mux);
+      restartEntry(numEntry);
+      portEXIT_CRITICAL(&_mux);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    bool disable(const size_t& numEntry)
+    {
+      if (numEntry >= NumEntries)
+        return false;
+
+      portENTER_CRITICAL(&_mux);
+      _countdown[numEntry] = 0;
+      portEXIT_CRITICAL(&_mux);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    bool isEnabled(const size_t& numEntry)
+    {
+      return (numEntry < NumEntries) && (_countdown[numEntry] != 0);
+    }
+
+    ////////////////////////////////////////
+
+    // Runs left of a numRuns entry, 0 for TIMER_RUN_FOREVER entries
+    uint32_t getRunsLeft(const size_t& numEntry)
+    {
+      return (numEntry < NumEntries) ? _runsLeft[numEntry] : 0;
+    }
+
+    ////////////////////////////////////////
+
+    constexpr size_t getNumEntries()
+    {
+      return NumEntries;
+    }
+
+    ////////////////////////////////////////
+
+    // RAM used by the dispatch structure, the table itself is in flash
+    static constexpr size_t getRamSize()
+    {
+      return sizeof(ESP32_ISR_StaticSchedule<NumEntries, TickMs>);
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    ////////////////////////////////////////
+
+    void restartEntry(const size_t& numEntry)
+    {
+      _countdown[numEntry] = _table[numEntry].period / TickMs;
+      _runsLeft[numEntry]  = _table[numEntry].numRuns;
+    }
+
+    ////////////////////////////////////////
+
+    const ISRTimerSchedule_t* _table;
+
+    volatile uint32_t _countdown[NumEntries];     // ticks to the next run, 0 => disabled
+    volatile uint32_t _runsLeft[NumEntries];      // runs left, not used for TIMER_RUN_FOREVER entries
+
+    // ESP32 is a multi core / multi processing chip. Protects the counters against the ISR running on the other core
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif    // ISR_STATIC_SCHEDULE_GENERIC_H
@@ -46,6 +46,8 @@
 
 #include <string.h>
 
+#include "ESP32_S2_TimerInterrupt.h"
+
 ////////////////////////////////////////
 
 ESP32_ISR_Timer::ESP32_ISR_Timer()
@@ -57,7 +59,7 @@ ESP32_ISR_Timer::ESP32_ISR_Timer()
 
 void ESP32_ISR_Timer::init()
 {
-  unsigned long current_millis = millis();   //elapsed();
+  unsigned long current_millis = ISR_TIMER_MILLIS();   //elapsed();
 
   for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
   {
@@ -65,6 +67,15 @@ void ESP32_ISR_Timer::init()
     timer[i].prev_millis = current_millis;
   }
 
+  // only domain 0, real time
+  for (uint8_t d = 0; d < MAX_TIME_DOMAINS; d++)
+  {
+    memset((void*) &domains[d], 0, sizeof (timer_domain_t));
+    domains[d].rate = TIMER_DOMAIN_RATE_ONE;
+  }
+
+  domains[TIMER_DOMAIN_REALTIME].name = "realtime";
+
   numTimers = 0;
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
@@ -73,31 +84,75 @@ void ESP32_ISR_Timer::init()
 
 ////////////////////////////////////////
 
-void IRAM_ATTR ESP32_ISR_Timer::run()
+bool IRAM_ATTR ESP32_ISR_Timer::run()
 {
   uint8_t i;
   unsigned long current_millis;
 
   // get current time
-  current_millis = millis();   //elapsed();
+  current_millis = ISR_TIMER_MILLIS();   //elapsed();
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   portENTER_CRITICAL_ISR(&timerMux);
 
+  // current time of each domain, computed once per run()
+  unsigned long now[MAX_TIME_DOMAINS];
+
+  now[TIMER_DOMAIN_REALTIME] = current_millis;
+
+  for (uint8_t d = 1; d < MAX_TIME_DOMAINS; d++)
+  {
+    // keeps the real time elapsed since the base far from wrapping around
+    if ( !domains[d].paused && ((current_millis - domains[d].baseReal) >= 0x40000000UL) )
+      rebaseDomain(d, current_millis);
+
+    now[d] = domainMillis(d, current_millis);
+  }
+
+  // deferred function calls, TIMER_DEFCALL_xxx
+  uint8_t toBeCalled[MAX_NUMBER_TIMERS];
+
+  // task notifications of this run(), one per task
+  TaskHandle_t  notifyTask[MAX_ISR_TIMER_NOTIFY_TASKS];
+  uint32_t      notifyBits[MAX_ISR_TIMER_NOTIFY_TASKS];
+  uint8_t       numNotify   = 0;
+  bool          moreNotify  = false;
+  BaseType_t    woken       = pdFALSE;
+  bool          inISR       = xPortInIsrContext();
+
   for (i = 0; i < MAX_NUMBER_TIMERS; i++)
   {
 
-    timer[i].toBeCalled = TIMER_DEFCALL_DONTRUN;
+    toBeCalled[i] = TIMER_DEFCALL_DONTRUN;
 
     // no callback == no timer, i.e. jump over empty slots
     if (timer[i].callback != NULL)
     {
+      // a paused domain's time doesn't move, so its timers are never due
+      current_millis = now[timer[i].domain];
+
       // is it time to process this timer ?
       // see http://arduino.cc/forum/index.php/topic,124048.msg932592.html#msg932592
 
       if ((current_millis - timer[i].prev_millis) >= timer[i].delay)
       {
-        unsigned long skipTimes = (current_millis - timer[i].prev_millis) / timer[i].delay;
+        // lazy timeout (always in real time) kicked since it was armed: re-armed from the last kick(), without any call.
+        // Signed, as a kick() on the other core can be later than current_millis
+        if (timer[i].type == TIMER_TYPE_TIMEOUT)
+        {
+          unsigned long lastActivity = ((ESP32_ISR_Timeout*) timer[i].param)->lastActivity;
+
+          if ( (long) (current_millis - lastActivity) < (long) timer[i].delay )
+          {
+            timer[i].prev_millis = lastActivity;
+
+            continue;
+          }
+        }
+
+        // a late sequence step is never skipped, the next ones catch up
+        unsigned long skipTimes = (timer[i].type == TIMER_TYPE_SEQUENCE) ? 1 :
+                                  (current_millis - timer[i].prev_millis) / timer[i].delay;
 
         // update time
         timer[i].prev_millis += timer[i].delay * skipTimes;
@@ -109,18 +164,23 @@ void IRAM_ATTR ESP32_ISR_Timer::run()
           // "run forever" timers must always be executed
           if (timer[i].maxNumRuns == TIMER_RUN_FOREVER)
           {
-            timer[i].toBeCalled = TIMER_DEFCALL_RUNONLY;
+            toBeCalled[i] = TIMER_DEFCALL_RUNONLY;
+          }
+          // sequence runs are counted by runSequenceStep()
+          else if (timer[i].type == TIMER_TYPE_SEQUENCE)
+          {
+            toBeCalled[i] = TIMER_DEFCALL_RUNONLY;
           }
           // other timers get executed the specified number of times
           else if (timer[i].numRuns < timer[i].maxNumRuns)
           {
-            timer[i].toBeCalled = TIMER_DEFCALL_RUNONLY;
+            toBeCalled[i] = TIMER_DEFCALL_RUNONLY;
             timer[i].numRuns++;
 
             // after the last run, delete the timer
             if (timer[i].numRuns >= timer[i].maxNumRuns)
             {
-              timer[i].toBeCalled = TIMER_DEFCALL_RUNANDDEL;
+              toBeCalled[i] = TIMER_DEFCALL_RUNANDDEL;
             }
           }
         }
@@ -128,23 +188,298 @@ void IRAM_ATTR ESP32_ISR_Timer::run()
     }
   }
 
+  // build the dispatch order of the due timers. Slot order needs no sorting
+  uint8_t order[MAX_NUMBER_TIMERS];
+  uint8_t numDue = 0;
+
   for (i = 0; i < MAX_NUMBER_TIMERS; i++)
   {
-    if (timer[i].toBeCalled == TIMER_DEFCALL_DONTRUN)
+    if (toBeCalled[i] == TIMER_DEFCALL_DONTRUN)
+      continue;
+
+    // insertion sort, at most MAX_NUMBER_TIMERS entries
+    uint8_t pos = numDue++;
+
+    if (dispatchOrder != TIMER_DISPATCH_SLOT)
+    {
+      while ( (pos > 0) && dispatchBefore(i, order[pos - 1], now) )
+      {
+        order[pos] = order[pos - 1];
+        pos--;
+      }
+    }
+
+    order[pos] = i;
+  }
+
+  for (uint8_t k = 0; k < numDue; k++)
+  {
+    i = order[k];
+
+#if USING_ISR_TIMER_CPU_BUDGET
+
+    // demoted timers are only queued here, and called later by runDeferred()
+    if (stats[i].demoted)
+    {
+      stats[i].pendingCalls++;
+
+      if (toBeCalled[i] == TIMER_DEFCALL_RUNANDDEL)
+        stats[i].deleteWhenDone = true;
+
       continue;
+    }
+
+    uint32_t startCycles = TISR_GET_CYCLE_COUNT();
+#endif
 
-    if (timer[i].hasParam)
+    if (timer[i].type == TIMER_TYPE_SEQUENCE)
+    {
+      // after the last run, delete the timer
+      if ( runSequenceStep(i) && (timer[i].maxNumRuns != TIMER_RUN_FOREVER) &&
+           (++timer[i].numRuns >= timer[i].maxNumRuns) )
+      {
+        toBeCalled[i] = TIMER_DEFCALL_RUNANDDEL;
+      }
+    }
+    else if (timer[i].type == TIMER_TYPE_PARAM)
       (*(timer_callback_p)timer[i].callback)(timer[i].param);
+    else if (timer[i].type == TIMER_TYPE_TIMEOUT)
+      (*(timer_callback_p)timer[i].callback)(((ESP32_ISR_Timeout*) timer[i].param)->param);
+    else if (timer[i].type == TIMER_TYPE_NOTIFY)
+    {
+      TaskHandle_t  task  = (TaskHandle_t) timer[i].param;
+      uint32_t      bits  = (uint32_t) (uintptr_t) timer[i].callback;
+      uint8_t       k     = 0;
+
+      while ( (k < numNotify) && (notifyTask[k] != task) )
+        k++;
+
+      if (k < numNotify)
+        notifyBits[k] |= bits;
+      else if (numNotify < MAX_ISR_TIMER_NOTIFY_TASKS)
+      {
+        notifyTask[numNotify] = task;
+        notifyBits[numNotify] = bits;
+        numNotify++;
+      }
+      else
+      {
+        // more tasks than MAX_ISR_TIMER_NOTIFY_TASKS: notified after this pass, and deleted then
+        toBeCalled[i] = (toBeCalled[i] == TIMER_DEFCALL_RUNANDDEL) ? TIMER_DEFCALL_NOTIFYDEL : TIMER_DEFCALL_NOTIFY;
+        moreNotify    = true;
+      }
+    }
     else
       (*(timer_callback)timer[i].callback)();
 
-    if (timer[i].toBeCalled == TIMER_DEFCALL_RUNANDDEL)
-      deleteTimer(i);
+#if USING_ISR_TIMER_CPU_BUDGET
+    accountCycles(i, TISR_GET_CYCLE_COUNT() - startCycles, true);
+#endif
+
+    // the automatic tick is only marked for update here, in ISR
+    if (toBeCalled[i] == TIMER_DEFCALL_RUNANDDEL)
+      removeTimer(i);
   }
 
+  // the ones asked by the callbacks, notifyFromRun()
+  if (takeRunNotify(notifyTask, notifyBits, numNotify))
+    moreNotify = true;
+
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   portEXIT_CRITICAL_ISR(&timerMux);
 
+  // one notification per task, and only one yield request for all of them. Never sent under the lock
+  do
+  {
+    for (uint8_t k = 0; k < numNotify; k++)
+    {
+      if (inISR)
+        xTaskNotifyFromISR(notifyTask[k], notifyBits[k], eSetBits, &woken);
+      else
+        xTaskNotify(notifyTask[k], notifyBits[k], eSetBits);
+    }
+
+    if (!moreNotify)
+      break;
+
+    // next batch of the notifications which didn't fit
+    moreNotify  = false;
+    numNotify   = 0;
+
+    portENTER_CRITICAL_ISR(&timerMux);
+
+    for (uint8_t k = 0; k < numDue; k++)
+    {
+      i = order[k];
+
+      if ( (toBeCalled[i] != TIMER_DEFCALL_NOTIFY) && (toBeCalled[i] != TIMER_DEFCALL_NOTIFYDEL) )
+        continue;
+
+      // deleted meanwhile
+      if ( (timer[i].callback == NULL) || (timer[i].type != TIMER_TYPE_NOTIFY) )
+      {
+        toBeCalled[i] = TIMER_DEFCALL_DONTRUN;
+        continue;
+      }
+
+      TaskHandle_t  task  = (TaskHandle_t) timer[i].param;
+      uint8_t       n     = 0;
+
+      while ( (n < numNotify) && (notifyTask[n] != task) )
+        n++;
+
+      if (n == numNotify)
+      {
+        if (numNotify == MAX_ISR_TIMER_NOTIFY_TASKS)
+        {
+          moreNotify = true;
+          continue;
+        }
+
+        notifyTask[numNotify] = task;
+        notifyBits[numNotify] = 0;
+        numNotify++;
+      }
+
+      notifyBits[n] |= (uint32_t) (uintptr_t) timer[i].callback;
+
+      if (toBeCalled[i] == TIMER_DEFCALL_NOTIFYDEL)
+        removeTimer(i);
+
+      toBeCalled[i] = TIMER_DEFCALL_DONTRUN;
+    }
+
+    if (takeRunNotify(notifyTask, notifyBits, numNotify))
+      moreNotify = true;
+
+    portEXIT_CRITICAL_ISR(&timerMux);
+  } while (true);
+
+  // a callback woke a task itself, requestYield()
+  if (yieldRequested)
+  {
+    yieldRequested  = false;
+    woken           = pdTRUE;
+  }
+
+  return (woken == pdTRUE);
+}
+
+////////////////////////////////////////
+
+bool IRAM_ATTR ESP32_ISR_Timer::notifyFromRun(TaskHandle_t task, const uint32_t& bits)
+{
+  // only from a callback, under timerMux
+  uint8_t k = 0;
+
+  while ( (k < numRunNotify) && (runNotifyTask[k] != task) )
+    k++;
+
+  if (k == numRunNotify)
+  {
+    if (numRunNotify == MAX_ISR_TIMER_NOTIFY_TASKS)
+      return false;
+
+    runNotifyTask[numRunNotify] = task;
+    runNotifyBits[numRunNotify] = 0;
+    numRunNotify++;
+  }
+
+  runNotifyBits[k] |= bits;
+
+  return true;
+}
+
+////////////////////////////////////////
+
+// moves the notifyFromRun() requests to the notifications of this run(), under timerMux. Returns true if some didn't
+// fit, and are kept for the next batch
+bool IRAM_ATTR ESP32_ISR_Timer::takeRunNotify(TaskHandle_t* notifyTask, uint32_t* notifyBits, uint8_t& numNotify)
+{
+  uint8_t left = 0;
+
+  for (uint8_t r = 0; r < numRunNotify; r++)
+  {
+    uint8_t k = 0;
+
+    while ( (k < numNotify) && (notifyTask[k] != runNotifyTask[r]) )
+      k++;
+
+    if (k == numNotify)
+    {
+      if (numNotify == MAX_ISR_TIMER_NOTIFY_TASKS)
+      {
+        runNotifyTask[left] = runNotifyTask[r];
+        runNotifyBits[left] = runNotifyBits[r];
+        left++;
+
+        continue;
+      }
+
+      notifyTask[numNotify] = runNotifyTask[r];
+      notifyBits[numNotify] = 0;
+      numNotify++;
+    }
+
+    notifyBits[k] |= runNotifyBits[r];
+  }
+
+  numRunNotify = left;
+
+  return (left > 0);
+}
+
+////////////////////////////////////////
+
+bool IRAM_ATTR ESP32_ISR_Timer::runSequenceStep(const uint8_t& i)
+{
+  timer_sequence_t* seq = (timer_sequence_t*) timer[i].param;
+
+  do
+  {
+    const timer_step_t* step = &seq->steps[seq->curStep];
+
+    if (step->callback)
+      (*step->callback)(step->param);
+
+    if (++seq->curStep >= seq->numSteps)
+    {
+      // end of this run. The first step is armed from now, even with delay = 0
+      seq->curStep    = 0;
+      timer[i].delay  = seq->steps[0].delay;
+
+      return true;
+    }
+  } while (seq->steps[seq->curStep].delay == 0);
+
+  // arm the next step, from the due time of this one
+  timer[i].delay = seq->steps[seq->curStep].delay;
+
+  return false;
+}
+
+////////////////////////////////////////
+
+// true if due timer i must be dispatched before due timer j. Only called from run() with i > j (slot order),
+// so returning false on a complete tie keeps the lower slot index first
+bool IRAM_ATTR ESP32_ISR_Timer::dispatchBefore(const uint8_t& i, const uint8_t& j, const unsigned long* now)
+{
+  if (timer[i].priority != timer[j].priority)
+  {
+    return (timer[i].priority > timer[j].priority);
+  }
+
+  if (dispatchOrder == TIMER_DISPATCH_EDF)
+  {
+    // prev_millis was already advanced by run(), so prev_millis + delay is the end of the current period.
+    // Deadlines in different domains are compared as if all domains ran at real time
+    unsigned long deadline_i = timer[i].prev_millis + timer[i].delay - now[timer[i].domain];
+    unsigned long deadline_j = timer[j].prev_millis + timer[j].delay - now[timer[j].domain];
+
+    return (deadline_i < deadline_j);
+  }
+
+  return false;
 }
 
 ////////////////////////////////////////
@@ -174,7 +509,7 @@ int ESP32_ISR_Timer::findFirstFreeSlot()
 
 ////////////////////////////////////////
 
-int ESP32_ISR_Timer::setupTimer(const unsigned long& d, void* f, void* p, bool h, const unsigned& n)
+int ESP32_ISR_Timer::setupTimer(const unsigned long& d, void* f, void* p, const uint8_t& type, const unsigned& n)
 {
   int freeTimer;
 
@@ -195,16 +530,51 @@ int ESP32_ISR_Timer::setupTimer(const unsigned long& d, void* f, void* p, bool h
     return -1;
   }
 
+  if ( (d > TIMER_MAX_DELAY) || (n > TIMER_MAX_NUM_RUNS) )
+  {
+    TISR_LOGERROR3(F("ESP32_ISR_Timer: delay must be <= "), TIMER_MAX_DELAY, F(", runs <= "), TIMER_MAX_NUM_RUNS);
+
+    return -1;
+  }
+
+#if USING_ESP32_S2_TIMER_IRAM
+
+  // the callback is called from run(), which must keep working while the flash cache is disabled.
+  // Sequence steps are checked by setSequence(). A notification has no callback
+  if ( (type != TIMER_TYPE_SEQUENCE) && (type != TIMER_TYPE_NOTIFY) && !esp_ptr_in_iram(f) )
+  {
+    TISR_LOGERROR(F("ESP32_ISR_Timer: USING_ESP32_S2_TIMER_IRAM needs an IRAM_ATTR callback"));
+
+    return -1;
+  }
+
+#endif
+
+  unsigned long current_millis = ISR_TIMER_MILLIS();
+  unsigned long advance = 0;
+
+  // before filling the slot, not to count the new timer twice
+  if ( staggerEnabled && staggerable(type, TIMER_DOMAIN_REALTIME, n) )
+    advance = staggerAdvance(d, current_millis);
+
   timer[freeTimer].delay = d;
   timer[freeTimer].callback = f;
   timer[freeTimer].param = p;
-  timer[freeTimer].hasParam = h;
+  timer[freeTimer].type = type;
+  timer[freeTimer].priority = TIMER_PRIORITY_NORMAL;
+  timer[freeTimer].domain = TIMER_DOMAIN_REALTIME;
   timer[freeTimer].maxNumRuns = n;
   timer[freeTimer].enabled = true;
-  timer[freeTimer].prev_millis = millis();
+  timer[freeTimer].prev_millis = current_millis - advance;
+
+#if USING_ISR_TIMER_CPU_BUDGET
+  memset((void*) &stats[freeTimer], 0, sizeof (timer_stats_t));
+#endif
 
   numTimers++;
 
+  timersChanged();
+
   return freeTimer;
 }
 
@@ -212,49 +582,108 @@ int ESP32_ISR_Timer::setupTimer(const unsigned long& d, void* f, void* p, bool h
 
 int ESP32_ISR_Timer::setTimer(const unsigned long& d, timer_callback f, const unsigned& n)
 {
-  return setupTimer(d, (void *)f, NULL, false, n);
+  return setupTimer(d, (void *)f, NULL, TIMER_TYPE_NOPARAM, n);
 }
 
 ////////////////////////////////////////
 
 int ESP32_ISR_Timer::setTimer(const unsigned long& d, timer_callback_p f, void* p, const unsigned& n)
 {
-  return setupTimer(d, (void *)f, p, true, n);
+  return setupTimer(d, (void *)f, p, TIMER_TYPE_PARAM, n);
 }
 
 ////////////////////////////////////////
 
 int ESP32_ISR_Timer::setInterval(const unsigned long& d, timer_callback f)
 {
-  return setupTimer(d, (void *)f, NULL, false, TIMER_RUN_FOREVER);
+  return setupTimer(d, (void *)f, NULL, TIMER_TYPE_NOPARAM, TIMER_RUN_FOREVER);
 }
 
 ////////////////////////////////////////
 
 int ESP32_ISR_Timer::setInterval(const unsigned long& d, timer_callback_p f, void* p)
 {
-  return setupTimer(d, (void *)f, p, true, TIMER_RUN_FOREVER);
+  return setupTimer(d, (void *)f, p, TIMER_TYPE_PARAM, TIMER_RUN_FOREVER);
 }
 
 ////////////////////////////////////////
 
 int ESP32_ISR_Timer::setTimeout(const unsigned long& d, timer_callback f)
 {
-  return setupTimer(d, (void *)f, NULL, false, TIMER_RUN_ONCE);
+  return setupTimer(d, (void *)f, NULL, TIMER_TYPE_NOPARAM, TIMER_RUN_ONCE);
 }
 
 ////////////////////////////////////////
 
 int ESP32_ISR_Timer::setTimeout(const unsigned long& d, timer_callback_p f, void* p)
 {
-  return setupTimer(d, (void *)f, p, true, TIMER_RUN_ONCE);
+  return setupTimer(d, (void *)f, p, TIMER_TYPE_PARAM, TIMER_RUN_ONCE);
+}
+
+////////////////////////////////////////
+
+int ESP32_ISR_Timer::setSequence(timer_sequence_t& seq, const unsigned& n)
+{
+  if ( (seq.steps == NULL) || (seq.numSteps == 0) )
+  {
+    return -1;
+  }
+
+  for (uint8_t k = 0; k < seq.numSteps; k++)
+  {
+#if USING_ESP32_S2_TIMER_IRAM
+
+    // the steps are run from run(), which must keep working while the flash cache is disabled
+    if ( (seq.steps[k].callback != NULL) && !esp_ptr_in_iram((const void *) seq.steps[k].callback) )
+    {
+      TISR_LOGERROR(F("ESP32_ISR_Timer: USING_ESP32_S2_TIMER_IRAM needs IRAM_ATTR step callbacks"));
+
+      return -1;
+    }
+
+#endif
+
+    if (seq.steps[k].delay > TIMER_MAX_DELAY)
+    {
+      return -1;
+    }
+  }
+
+  seq.curStep = 0;
+
+  return setupTimer(seq.steps[0].delay, (void *) seq.steps, (void *) &seq, TIMER_TYPE_SEQUENCE, n);
+}
+
+////////////////////////////////////////
+
+int ESP32_ISR_Timer::setLazyTimeout(ESP32_ISR_Timeout& timeout, const unsigned long& d, timer_callback_p f, void* p,
+                                    const unsigned& n)
+{
+  // the slot is armed from now, so the timeout too
+  timeout.param = p;
+  timeout.kick();
+
+  timeout.numTimer = setupTimer(d, (void *)f, (void *) &timeout, TIMER_TYPE_TIMEOUT, n);
+
+  return timeout.numTimer;
+}
+
+////////////////////////////////////////
+
+int ESP32_ISR_Timer::setTaskNotify(const unsigned long& d, TaskHandle_t task, const uint32_t& bits, const unsigned& n)
+{
+  if (task == NULL)
+    task = xTaskGetCurrentTaskHandle();
+
+  // bits stored in place of the callback, so bits == 0 is rejected as a NULL callback
+  return setupTimer(d, (void *) (uintptr_t) bits, (void *) task, TIMER_TYPE_NOTIFY, n);
 }
 
 ////////////////////////////////////////
 
 bool IRAM_ATTR ESP32_ISR_Timer::changeInterval(const unsigned& numTimer, const unsigned long& d)
 {
-  if (numTimer >= MAX_NUMBER_TIMERS)
+  if ( (numTimer >= MAX_NUMBER_TIMERS) || (d > TIMER_MAX_DELAY) || (timer[numTimer].type == TIMER_TYPE_SEQUENCE) )
   {
     return false;
   }
@@ -266,11 +695,15 @@ bool IRAM_ATTR ESP32_ISR_Timer::changeInterval(const unsigned& numTimer, const u
     portENTER_CRITICAL(&timerMux);
 
     timer[numTimer].delay = d;
-    timer[numTimer].prev_millis = millis();
+    timer[numTimer].prev_millis = domainMillis(timer[numTimer].domain, ISR_TIMER_MILLIS());
 
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
     portEXIT_CRITICAL(&timerMux);
 
+    // an exempt timer, re-armed at each run by ESP32_ISR_LongTimer, doesn't move the tick
+    if (!isAutoTickExempt(numTimer))
+      timersChanged();
+
     return true;
   }
 
@@ -280,17 +713,27 @@ bool IRAM_ATTR ESP32_ISR_Timer::changeInterval(const unsigned& numTimer, const u
 
 ////////////////////////////////////////
 
-void ESP32_ISR_Timer::deleteTimer(const unsigned& timerId)
+void IRAM_ATTR ESP32_ISR_Timer::deleteTimer(const unsigned& timerId)
+{
+  if (removeTimer(timerId))
+  {
+    timersChanged();
+  }
+}
+
+////////////////////////////////////////
+
+bool IRAM_ATTR ESP32_ISR_Timer::removeTimer(const unsigned& timerId)
 {
   if (timerId >= MAX_NUMBER_TIMERS)
   {
-    return;
+    return false;
   }
 
   // nothing to delete if no timers are in use
   if (numTimers == 0)
   {
-    return;
+    return false;
   }
 
   // don't decrease the number of timers if the specified slot is already empty
@@ -299,22 +742,31 @@ void ESP32_ISR_Timer::deleteTimer(const unsigned& timerId)
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
     portENTER_CRITICAL(&timerMux);
 
+    if (timer[timerId].type == TIMER_TYPE_TIMEOUT)
+      ((ESP32_ISR_Timeout*) timer[timerId].param)->numTimer = -1;
+
     memset((void*) &timer[timerId], 0, sizeof (timer_t));
-    timer[timerId].prev_millis = millis();
+    timer[timerId].prev_millis = ISR_TIMER_MILLIS();
+    autoTickExempt[timerId >> 3] &= ~(1 << (timerId & 7));
 
     // update number of timers
     numTimers--;
 
+    autoTickDirty = true;
+
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
     portEXIT_CRITICAL(&timerMux);
 
+    return true;
   }
+
+  return false;
 }
 
 ////////////////////////////////////////
 
 // function contributed by code@rowansimms.com
-void ESP32_ISR_Timer::restartTimer(const unsigned& numTimer)
+void IRAM_ATTR ESP32_ISR_Timer::restartTimer(const unsigned& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -324,7 +776,20 @@ void ESP32_ISR_Timer::restartTimer(const unsigned& numTimer)
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portENTER_CRITICAL(&timerMux);
 
-  timer[numTimer].prev_millis = millis();
+  timer[numTimer].prev_millis = domainMillis(timer[numTimer].domain, ISR_TIMER_MILLIS());
+
+  // a sequence restarts from its first step
+  if (timer[numTimer].type == TIMER_TYPE_SEQUENCE)
+  {
+    timer_sequence_t* seq = (timer_sequence_t*) timer[numTimer].param;
+
+    seq->curStep          = 0;
+    timer[numTimer].delay = seq->steps[0].delay;
+  }
+  else if (timer[numTimer].type == TIMER_TYPE_TIMEOUT)
+  {
+    ((ESP32_ISR_Timeout*) timer[numTimer].param)->lastActivity = timer[numTimer].prev_millis;
+  }
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portEXIT_CRITICAL(&timerMux);
@@ -344,7 +809,19 @@ bool ESP32_ISR_Timer::isEnabled(const unsigned& numTimer)
 
 ////////////////////////////////////////
 
-void ESP32_ISR_Timer::enable(const unsigned& numTimer)
+bool IRAM_ATTR ESP32_ISR_Timer::isUsed(const unsigned& numTimer)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return false;
+  }
+
+  return (timer[numTimer].callback != NULL);
+}
+
+////////////////////////////////////////
+
+void IRAM_ATTR ESP32_ISR_Timer::enable(const unsigned& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -356,7 +833,7 @@ void ESP32_ISR_Timer::enable(const unsigned& numTimer)
 
 ////////////////////////////////////////
 
-void ESP32_ISR_Timer::disable(const unsigned& numTimer)
+void IRAM_ATTR ESP32_ISR_Timer::disable(const unsigned& numTimer)
 {
   if (numTimer >= MAX_NUMBER_TIMERS)
   {
@@ -430,5 +907,1120 @@ unsigned ESP32_ISR_Timer::getNumTimers()
 
 ////////////////////////////////////////
 
+bool ESP32_ISR_Timer::setPriority(const unsigned& numTimer, const uint8_t& priority)
+{
+  if ( (numTimer >= MAX_NUMBER_TIMERS) || (priority > TIMER_PRIORITY_CRITICAL) || (timer[numTimer].callback == NULL) )
+  {
+    return false;
+  }
+
+  timer[numTimer].priority = priority;
+
+  return true;
+}
+
+////////////////////////////////////////
+
+uint8_t ESP32_ISR_Timer::getPriority(const unsigned& numTimer)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return TIMER_PRIORITY_LOW;
+  }
+
+  return timer[numTimer].priority;
+}
+
+////////////////////////////////////////
+
+void ESP32_ISR_Timer::setDispatchOrder(const uint8_t& order)
+{
+  if (order <= TIMER_DISPATCH_EDF)
+  {
+    dispatchOrder = order;
+  }
+}
+
+////////////////////////////////////////
+
+unsigned long IRAM_ATTR ESP32_ISR_Timer::domainMillis(const uint8_t domain, const unsigned long& realMillis)
+{
+  if (domain == TIMER_DOMAIN_REALTIME)
+  {
+    return realMillis;
+  }
+
+  if (domains[domain].paused)
+  {
+    return domains[domain].baseVirtual;
+  }
+
+  // 64-bit product: the real time elapsed since the base is kept below 2^30 ms by run()
+  return domains[domain].baseVirtual +
+         (unsigned long) ( ( (uint64_t) (realMillis - domains[domain].baseReal) * domains[domain].rate ) >> 16 );
+}
+
+////////////////////////////////////////
+
+void IRAM_ATTR ESP32_ISR_Timer::rebaseDomain(const uint8_t& domain, const unsigned long& realMillis)
+{
+  domains[domain].baseVirtual = domainMillis(domain, realMillis);
+  domains[domain].baseReal    = realMillis;
+}
+
+////////////////////////////////////////
+
+int ESP32_ISR_Timer::addTimeDomain(const char* name)
+{
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  if (name == NULL)
+  {
+    return -1;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  for (uint8_t d = 1; d < MAX_TIME_DOMAINS; d++)
+  {
+    if (domains[d].name == NULL)
+    {
+      domains[d].name         = name;
+      domains[d].baseVirtual  = ISR_TIMER_MILLIS();
+      domains[d].baseReal     = domains[d].baseVirtual;
+      domains[d].rate         = TIMER_DOMAIN_RATE_ONE;
+      domains[d].paused       = false;
+
+      portEXIT_CRITICAL(&timerMux);
+
+      return d;
+    }
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  TISR_LOGERROR1(F("ESP32_ISR_Timer: no free time domain, MAX_TIME_DOMAINS ="), MAX_TIME_DOMAINS);
+
+  return -1;
+}
+
+////////////////////////////////////////
+
+int ESP32_ISR_Timer::findTimeDomain(const char* name)
+{
+  if ( (numTimers < 0) || (name == NULL) )
+  {
+    return -1;
+  }
+
+  for (uint8_t d = 0; d < MAX_TIME_DOMAINS; d++)
+  {
+    if ( (domains[d].name != NULL) && (strcmp(domains[d].name, name) == 0) )
+    {
+      return d;
+    }
+  }
+
+  return -1;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::setTimerDomain(const unsigned& numTimer, const uint8_t& domain)
+{
+  if ( (numTimer >= MAX_NUMBER_TIMERS) || (domain >= MAX_TIME_DOMAINS) || (timer[numTimer].callback == NULL) ||
+       (domains[domain].name == NULL) || (timer[numTimer].type == TIMER_TYPE_TIMEOUT) )
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  unsigned long realMillis = ISR_TIMER_MILLIS();
+
+  // same time since the previous run, now counted in the new domain
+  unsigned long elapsed = domainMillis(timer[numTimer].domain, realMillis) - timer[numTimer].prev_millis;
+
+  timer[numTimer].prev_millis = domainMillis(domain, realMillis) - elapsed;
+  timer[numTimer].domain      = domain;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+////////////////////////////////////////
+
+uint8_t ESP32_ISR_Timer::getTimerDomain(const unsigned& numTimer)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return TIMER_DOMAIN_REALTIME;
+  }
+
+  return timer[numTimer].domain;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::pauseDomain(const uint8_t& domain)
+{
+  if ( (domain == TIMER_DOMAIN_REALTIME) || (domain >= MAX_TIME_DOMAINS) || (domains[domain].name == NULL) )
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  if (!domains[domain].paused)
+  {
+    rebaseDomain(domain, ISR_TIMER_MILLIS());
+    domains[domain].paused = true;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::resumeDomain(const uint8_t& domain)
+{
+  if ( (domain == TIMER_DOMAIN_REALTIME) || (domain >= MAX_TIME_DOMAINS) || (domains[domain].name == NULL) )
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  if (domains[domain].paused)
+  {
+    // baseVirtual still holds the time frozen by pauseDomain()
+    domains[domain].baseReal  = ISR_TIMER_MILLIS();
+    domains[domain].paused    = false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::isDomainPaused(const uint8_t& domain)
+{
+  if (domain >= MAX_TIME_DOMAINS)
+  {
+    return false;
+  }
+
+  return domains[domain].paused;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::setDomainRate(const uint8_t& domain, const float& rate)
+{
+  if ( (domain == TIMER_DOMAIN_REALTIME) || (domain >= MAX_TIME_DOMAINS) || (domains[domain].name == NULL) ||
+       (rate < 0.0f) || (rate > 65535.0f) )
+  {
+    return false;
+  }
+
+  // float to Q16 here, in task context, so run() only multiplies integers
+  uint32_t rateQ16 = (uint32_t) (rate * TIMER_DOMAIN_RATE_ONE + 0.5f);
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  // the time already elapsed keeps the old rate
+  if (!domains[domain].paused)
+  {
+    rebaseDomain(domain, ISR_TIMER_MILLIS());
+  }
+
+  domains[domain].rate = rateQ16;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  // the real intervals of the domain's timers changed
+  timersChanged();
+
+  return true;
+}
+
+////////////////////////////////////////
+
+unsigned long ESP32_ISR_Timer::getDomainMillis(const uint8_t& domain)
+{
+  if ( (domain >= MAX_TIME_DOMAINS) || (numTimers < 0) )
+  {
+    return ISR_TIMER_MILLIS();
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  unsigned long domainTime = domainMillis(domain, ISR_TIMER_MILLIS());
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return domainTime;
+}
+
+////////////////////////////////////////
+
+int ESP32_ISR_Timer::saveSnapshot(timer_snapshot_t& snapshot, const timer_registry_t* registry, const uint8_t& numEntries)
+{
+  // invalid until complete
+  snapshot.magic      = 0;
+  snapshot.numEntries = 0;
+
+  if ( (numTimers < 0) || (registry == NULL) )
+  {
+    return -1;
+  }
+
+  uint8_t n = 0;
+  int     missing = -1;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  unsigned long realMillis = ISR_TIMER_MILLIS();
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (timer[i].callback == NULL) || (timer[i].type == TIMER_TYPE_TIMEOUT) || (timer[i].type == TIMER_TYPE_NOTIFY) )
+      continue;
+
+    // done, but not deleted yet (deferred last run of a demoted timer). Would be restored as a run forever timer
+    if ( (timer[i].maxNumRuns != TIMER_RUN_FOREVER) && (timer[i].numRuns >= timer[i].maxNumRuns) )
+      continue;
+
+    uint8_t id = 0;
+
+    while ( (id < numEntries) && ( (registry[id].callback != timer[i].callback) || (registry[id].param != timer[i].param) ) )
+      id++;
+
+    if (id >= numEntries)
+    {
+      missing = i;
+
+      break;
+    }
+
+    timer_snapshot_entry_t* entry = &snapshot.entries[n++];
+
+    unsigned long elapsed = domainMillis(timer[i].domain, realMillis) - timer[i].prev_millis;
+
+    entry->remaining  = (elapsed < timer[i].delay) ? (timer[i].delay - elapsed) : 0;
+    entry->delay      = timer[i].delay;
+    entry->runsLeft   = (timer[i].maxNumRuns == TIMER_RUN_FOREVER) ? TIMER_RUN_FOREVER :
+                        (timer[i].maxNumRuns - timer[i].numRuns);
+    entry->slot       = i;
+    entry->id         = id;
+    entry->domain     = timer[i].domain;
+    entry->curStep    = (timer[i].type == TIMER_TYPE_SEQUENCE) ? ((timer_sequence_t*) timer[i].param)->curStep : 0;
+    entry->type       = timer[i].type;
+    entry->priority   = timer[i].priority;
+    entry->enabled    = timer[i].enabled;
+  }
+
+  for (uint8_t d = 0; d < MAX_TIME_DOMAINS; d++)
+  {
+    snapshot.domainPaused[d]  = domains[d].paused;
+    snapshot.domainRate[d]    = domains[d].rate;
+  }
+
+  snapshot.dispatchOrder = dispatchOrder;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  if (missing >= 0)
+  {
+    TISR_LOGERROR1(F("ESP32_ISR_Timer: callback not in registry, timer ="), missing);
+
+    return -1;
+  }
+
+  snapshot.numEntries = n;
+  snapshot.magic      = TIMER_SNAPSHOT_MAGIC;
+
+  return n;
+}
+
+////////////////////////////////////////
+
+int ESP32_ISR_Timer::restoreSnapshot(const timer_snapshot_t& snapshot, const timer_registry_t* registry,
+                                     const uint8_t& numEntries, const unsigned long& elapsedMs)
+{
+  if ( (snapshot.magic != TIMER_SNAPSHOT_MAGIC) || (snapshot.numEntries > MAX_NUMBER_TIMERS) || (registry == NULL) )
+  {
+    TISR_LOGERROR(F("ESP32_ISR_Timer: invalid snapshot"));
+
+    return -1;
+  }
+
+  // check everything first, so an invalid snapshot leaves the current timers untouched
+  for (uint8_t k = 0; k < snapshot.numEntries; k++)
+  {
+    const timer_snapshot_entry_t* entry = &snapshot.entries[k];
+
+    bool valid = (entry->slot < MAX_NUMBER_TIMERS) && (entry->id < numEntries) && (entry->type < TIMER_TYPE_TIMEOUT) &&
+                 (entry->priority <= TIMER_PRIORITY_CRITICAL) && (entry->delay <= TIMER_MAX_DELAY) &&
+                 (entry->runsLeft <= TIMER_MAX_NUM_RUNS) && (registry[entry->id].callback != NULL);
+
+    // a sequence entry is TIMER_REGISTRY_SEQUENCE(steps, seq): its callback must be the steps of its sequence
+    if (valid && (entry->type == TIMER_TYPE_SEQUENCE))
+    {
+      const timer_sequence_t* seq = (const timer_sequence_t*) registry[entry->id].param;
+
+      valid = (seq != NULL) && (registry[entry->id].callback == (void*) seq->steps) && (entry->curStep < seq->numSteps);
+    }
+
+#if USING_ESP32_S2_TIMER_IRAM
+    if (valid && (entry->type != TIMER_TYPE_SEQUENCE))
+    {
+      valid = esp_ptr_in_iram(registry[entry->id].callback);
+    }
+#endif
+
+    if (!valid)
+    {
+      TISR_LOGERROR1(F("ESP32_ISR_Timer: invalid snapshot entry ="), k);
+
+      return -1;
+    }
+  }
+
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  unsigned long realMillis = ISR_TIMER_MILLIS();
+
+  // the domains added again get their saved state back
+  for (uint8_t d = 1; d < MAX_TIME_DOMAINS; d++)
+  {
+    if (domains[d].name != NULL)
+    {
+      rebaseDomain(d, realMillis);
+
+      domains[d].rate   = snapshot.domainRate[d];
+      domains[d].paused = snapshot.domainPaused[d];
+    }
+  }
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (timer[i].callback != NULL) && (timer[i].type == TIMER_TYPE_TIMEOUT) )
+      ((ESP32_ISR_Timeout*) timer[i].param)->numTimer = -1;
+
+    memset((void*) &timer[i], 0, sizeof (timer_t));
+    timer[i].prev_millis = realMillis;
+  }
+
+  numTimers = 0;
+
+  if (snapshot.dispatchOrder <= TIMER_DISPATCH_EDF)
+  {
+    dispatchOrder = snapshot.dispatchOrder;
+  }
+
+  for (uint8_t k = 0; k < snapshot.numEntries; k++)
+  {
+    const timer_snapshot_entry_t* entry = &snapshot.entries[k];
+    uint8_t i = entry->slot;
+
+    // duplicated slot, only in a corrupted snapshot
+    if (timer[i].callback != NULL)
+      continue;
+
+    // a domain not added again falls back to real time
+    uint8_t domain = ( (entry->domain < MAX_TIME_DOMAINS) && (domains[entry->domain].name != NULL) ) ?
+                     entry->domain : TIMER_DOMAIN_REALTIME;
+
+    // elapsed time in the domain, which didn't move if it was paused
+    unsigned long elapsed = elapsedMs;
+
+    if (domain != TIMER_DOMAIN_REALTIME)
+    {
+      elapsed = snapshot.domainPaused[domain] ? 0 :
+                (unsigned long) ( ( (uint64_t) elapsedMs * snapshot.domainRate[domain] ) >> 16 );
+    }
+
+    unsigned long now = domainMillis(domain, realMillis);
+
+    if (elapsed < entry->remaining)
+    {
+      timer[i].prev_millis = now + (entry->remaining - elapsed) - entry->delay;
+    }
+    else
+    {
+      // due now. The missed runs are coalesced, the phase is kept
+      unsigned long late = (entry->delay > 0) ? ( (elapsed - entry->remaining) % entry->delay ) : 0;
+
+      timer[i].prev_millis = now - late - entry->delay;
+    }
+
+    timer[i].delay      = entry->delay;
+    timer[i].callback   = registry[entry->id].callback;
+    timer[i].param      = registry[entry->id].param;
+    timer[i].type       = entry->type;
+    timer[i].priority   = entry->priority;
+    timer[i].domain     = domain;
+    timer[i].maxNumRuns = entry->runsLeft;
+    timer[i].enabled    = entry->enabled;
+
+    if (entry->type == TIMER_TYPE_SEQUENCE)
+    {
+      ((timer_sequence_t*) timer[i].param)->curStep = entry->curStep;
+    }
+
+#if USING_ISR_TIMER_CPU_BUDGET
+    memset((void*) &stats[i], 0, sizeof (timer_stats_t));
+#endif
+
+    numTimers++;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  timersChanged();
+
+  return numTimers;
+}
+
+////////////////////////////////////////
+
+void IRAM_ATTR ESP32_ISR_Timer::timersChanged()
+{
+  autoTickDirty = true;
+
+  if ( (autoTickTimer != NULL) && !xPortInIsrContext() )
+  {
+    updateAutoTick();
+  }
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::tickServes(const unsigned long& tick, const unsigned long& interval)
+{
+  // runs at each tick anyway
+  if (interval == 0)
+    return true;
+
+  if (interval < tick)
+    return false;
+
+  unsigned long remainder = interval % tick;
+  unsigned long error     = (remainder < (tick - remainder)) ? remainder : (tick - remainder);
+
+  return ( (uint64_t) error * 100 <= (uint64_t) interval * autoTickTolerance );
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::tickServesAll(const unsigned long& tick, const auto_tick_slot_t* slots, const uint8_t& numSlots)
+{
+  for (uint8_t i = 0; i < numSlots; i++)
+  {
+    const auto_tick_slot_t* slot = &slots[i];
+    uint8_t numSteps = slot->seq ? slot->seq->numSteps : 1;
+
+    for (uint8_t k = 0; k < numSteps; k++)
+    {
+      unsigned long delay = slot->seq ? slot->seq->steps[k].delay : slot->delay;
+
+      if (!tickServes(tick, (unsigned long) ( ( (uint64_t) delay * TIMER_DOMAIN_RATE_ONE ) / slot->rate )))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////
+
+unsigned long ESP32_ISR_Timer::largestDivisor(const unsigned long& n, const unsigned long& maxDivisor)
+{
+  if (n <= maxDivisor)
+    return n;
+
+  // the smallest co-divisor d >= n / maxDivisor gives the largest divisor n / d <= maxDivisor. At most sqrt(n) tries
+  unsigned long d = (n + maxDivisor - 1) / maxDivisor;
+
+  for ( ; d <= n / d; d++)
+  {
+    if (n % d == 0)
+      return n / d;
+  }
+
+  // all the divisors above sqrt(n) are too large, the largest one below. d - 1 <= sqrt(n) here
+  for (d = (d - 1 < maxDivisor) ? d - 1 : maxDivisor; d > 1; d--)
+  {
+    if (n % d == 0)
+      return d;
+  }
+
+  return 1;
+}
+
+////////////////////////////////////////
+
+unsigned long ESP32_ISR_Timer::computeAutoTick()
+{
+  // Snapshot under the lock, as run() deletes timers and moves sequences to their next step meanwhile. The steps of a
+  // sequence are constant, and read after
+  auto_tick_slot_t  slots[MAX_NUMBER_TIMERS];
+  uint8_t           numSlots = 0;
+
+  portENTER_CRITICAL(&timerMux);
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (timer[i].callback == NULL) || isAutoTickExempt(i) )
+      continue;
+
+    // a paused domain doesn't need any tick, a rate-scaled one needs its intervals in real time
+    uint32_t rate = domains[timer[i].domain].rate;
+
+    if ( (timer[i].domain != TIMER_DOMAIN_REALTIME) && (domains[timer[i].domain].paused || (rate == 0)) )
+      continue;
+
+    slots[numSlots].delay = timer[i].delay;
+    slots[numSlots].rate  = rate;
+    slots[numSlots].seq   = (timer[i].type == TIMER_TYPE_SEQUENCE) ? (const timer_sequence_t*) timer[i].param : NULL;
+    numSlots++;
+  }
+
+  portEXIT_CRITICAL(&timerMux);
+
+  // GCD of all the intervals in real time: its divisors serve all the timers exactly
+  unsigned long period   = 0;
+  unsigned long shortest = 0;
+
+  for (uint8_t i = 0; i < numSlots; i++)
+  {
+    uint8_t numSteps = slots[i].seq ? slots[i].seq->numSteps : 1;
+
+    for (uint8_t k = 0; k < numSteps; k++)
+    {
+      unsigned long a = slots[i].seq ? slots[i].seq->steps[k].delay : slots[i].delay;
+
+      a = (unsigned long) ( ( (uint64_t) a * TIMER_DOMAIN_RATE_ONE ) / slots[i].rate );
+
+      // runs at each tick anyway
+      if (a == 0)
+        continue;
+
+      if ( (shortest == 0) || (a < shortest) )
+        shortest = a;
+
+      unsigned long b = period;
+
+      while (b != 0)
+      {
+        unsigned long r = a % b;
+
+        a = b;
+        b = r;
+      }
+
+      period = a;
+    }
+  }
+
+  if (period == 0)
+    return autoTickMax;
+
+  unsigned long tick = largestDivisor(period, autoTickMax);
+
+  if (autoTickTolerance == 0)
+    return tick;
+
+  // A tolerance allows coarser, inexact ticks. A tick serving the shortest interval p in m ticks is within
+  // p * (100 -/+ tolerance) / (100 * m). These ranges are tried for m = 1, 2, ..., each from its coarsest tick, and
+  // only ISR_TIMER_AUTO_TICK_CANDIDATES ticks in all, to bound the time of an update
+  unsigned tried = 0;
+
+  for (unsigned long m = 1; tried < ISR_TIMER_AUTO_TICK_CANDIDATES; m++)
+  {
+    unsigned long hi = (unsigned long) ( ( (uint64_t) shortest * (100 + autoTickTolerance) ) / (100 * m) );
+    unsigned long lo = (unsigned long) ( ( (uint64_t) shortest * (100 - autoTickTolerance) + 100 * m - 1 ) / (100 * m) );
+
+    if (hi > autoTickMax)
+      hi = autoTickMax;
+
+    if (hi > shortest)
+      hi = shortest;
+
+    // the ranges only get finer with m
+    if (hi <= tick)
+      break;
+
+    if (lo <= tick)
+      lo = tick + 1;
+
+    for (unsigned long t = hi; (t >= lo) && (tried < ISR_TIMER_AUTO_TICK_CANDIDATES); t--, tried++)
+    {
+      if (tickServesAll(t, slots, numSlots))
+      {
+        tick = t;
+
+        break;
+      }
+    }
+  }
+
+  return tick;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::setAutoTickExempt(const unsigned& numTimer, const bool& exempt)
+{
+  if ( (numTimer >= MAX_NUMBER_TIMERS) || (timer[numTimer].callback == NULL) )
+  {
+    return false;
+  }
+
+  if (exempt)
+    autoTickExempt[numTimer >> 3] |= (1 << (numTimer & 7));
+  else
+    autoTickExempt[numTimer >> 3] &= ~(1 << (numTimer & 7));
+
+  timersChanged();
+
+  return true;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::enableAutoTick(ESP32TimerInterrupt& timer, const unsigned long& maxTickMs,
+                                     const uint8_t& tolerancePercent)
+{
+  if ( (maxTickMs == 0) || (maxTickMs > 3600000UL) || (tolerancePercent > 50) )
+  {
+    TISR_LOGERROR3(F("ESP32_ISR_Timer: invalid auto tick, max = "), maxTickMs, F(", tolerance = "), tolerancePercent);
+
+    return false;
+  }
+
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  autoTickMax       = maxTickMs;
+  autoTickTolerance = tolerancePercent;
+  autoTickMs        = 0;
+  autoTickTimer     = &timer;
+
+  timersChanged();
+
+  return true;
+}
+
+////////////////////////////////////////
+
+void ESP32_ISR_Timer::disableAutoTick()
+{
+  autoTickTimer = NULL;
+  autoTickMs    = 0;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::updateAutoTick()
+{
+  if ( (autoTickTimer == NULL) || !autoTickDirty )
+  {
+    return false;
+  }
+
+  autoTickDirty = false;
+
+  unsigned long tick = computeAutoTick();
+
+  if ( (tick == autoTickMs) || !autoTickTimer->changeInterval(tick * 1000UL) )
+  {
+    return false;
+  }
+
+  TISR_LOGINFO1(F("ESP32_ISR_Timer: auto tick (ms) = "), tick);
+
+  autoTickMs = tick;
+
+  return true;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::staggerable(const uint8_t type, const uint8_t domain, const unsigned maxNumRuns)
+{
+  return ( (domain == TIMER_DOMAIN_REALTIME) && (maxNumRuns != TIMER_RUN_ONCE) &&
+           ( (type == TIMER_TYPE_NOPARAM) || (type == TIMER_TYPE_PARAM) || (type == TIMER_TYPE_NOTIFY) ) );
+}
+
+////////////////////////////////////////
+
+unsigned ESP32_ISR_Timer::phaseHistogram(uint8_t* bins, unsigned& numBins, unsigned long& period,
+                                         unsigned long& width, const unsigned long& newDelay)
+{
+  unsigned long resolution = (autoTickMs > staggerResolution) ? autoTickMs : staggerResolution;
+  unsigned      everyRun   = 0;
+
+  // two timers of periods p1 and p2 are due together only if their phases are equal modulo gcd(p1, p2), so phases
+  // modulo the GCD of all the periods give an upper bound of the load over the whole hyperperiod
+  period = (newDelay >= 2 * resolution) ? newDelay : 0;
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (timer[i].callback == NULL) || !staggerable(timer[i].type, timer[i].domain, timer[i].maxNumRuns) )
+      continue;
+
+    unsigned long a = timer[i].delay;
+
+    if (a < 2 * resolution)
+    {
+      everyRun++;
+
+      continue;
+    }
+
+    unsigned long b = period;
+
+    while (b != 0)
+    {
+      unsigned long r = a % b;
+
+      a = b;
+      b = r;
+    }
+
+    period = a;
+  }
+
+  // fewer than 2 bins, no phase to choose
+  if (period < 2 * resolution)
+  {
+    numBins = 0;
+
+    return everyRun;
+  }
+
+  width = resolution;
+
+  if (period / width > ISR_TIMER_STAGGER_BINS)
+    width = (period + ISR_TIMER_STAGGER_BINS - 1) / ISR_TIMER_STAGGER_BINS;
+
+  numBins = (period + width - 1) / width;
+
+  memset(bins, 0, numBins);
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    if ( (timer[i].callback == NULL) || !staggerable(timer[i].type, timer[i].domain, timer[i].maxNumRuns) ||
+         (timer[i].delay < 2 * resolution) )
+      continue;
+
+    // prev_millis only moves by whole periods in run(), so the phase is read without locking
+    unsigned long phase = (timer[i].prev_millis + timer[i].delay - staggerOrigin) % period;
+    uint8_t*      bin   = &bins[phase / width];
+
+    if (*bin < 255)
+      (*bin)++;
+  }
+
+  return everyRun;
+}
+
+////////////////////////////////////////
+
+unsigned long ESP32_ISR_Timer::staggerAdvance(const unsigned long& d, const unsigned long& now)
+{
+  uint8_t       bins[ISR_TIMER_STAGGER_BINS];
+  unsigned      numBins;
+  unsigned long period;
+  unsigned long width;
+
+  phaseHistogram(bins, numBins, period, width, d);
+
+  // d too short to be staggered
+  if ( (numBins == 0) || (d < period) )
+    return 0;
+
+  // the least loaded bin, looking back from the phase of an unstaggered start, so that ties keep the first run as
+  // late as possible. The advance is always < period <= d, the first run stays in the future
+  unsigned long phase = (now + d - staggerOrigin) % period;
+  unsigned      start = phase / width;
+  unsigned      best  = start;
+
+  for (unsigned k = 1; k < numBins; k++)
+  {
+    unsigned bin = (start + numBins - k) % numBins;
+
+    if (bins[bin] < bins[best])
+      best = bin;
+  }
+
+  if (best == start)
+    return 0;
+
+  unsigned long advance = (phase + period - best * width) % period;
+
+  TISR_LOGDEBUG3(F("ESP32_ISR_Timer: staggered by (ms) "), advance, F(", bin load = "), bins[best]);
+
+  return advance;
+}
+
+////////////////////////////////////////
+
+void ESP32_ISR_Timer::enablePhaseStagger(const unsigned long& resolutionMs)
+{
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  staggerResolution = (resolutionMs > 0) ? resolutionMs : 1;
+  staggerOrigin     = ISR_TIMER_MILLIS();
+  staggerEnabled    = true;
+}
+
+////////////////////////////////////////
+
+unsigned ESP32_ISR_Timer::getPeakLoad()
+{
+  uint8_t       bins[ISR_TIMER_STAGGER_BINS];
+  unsigned      numBins;
+  unsigned long period;
+  unsigned long width;
+  unsigned      peak = 0;
+
+  if (numTimers < 0)
+    return 0;
+
+  unsigned everyRun = phaseHistogram(bins, numBins, period, width, 0);
+
+  for (unsigned k = 0; k < numBins; k++)
+  {
+    if (bins[k] > peak)
+      peak = bins[k];
+  }
+
+  return everyRun + peak;
+}
+
+#if USING_ISR_TIMER_CPU_BUDGET
+
+void IRAM_ATTR ESP32_ISR_Timer::accountCycles(const uint8_t& i, const uint32_t& cycles, const bool& inISR)
+{
+  stats[i].numCalls++;
+  stats[i].totalCycles += cycles;
+  stats[i].lastCycles = cycles;
+
+  if (cycles > stats[i].maxCycles)
+  {
+    stats[i].maxCycles = cycles;
+  }
+
+  // deferred calls no longer compete with the ISR, so they don't trigger the policy again
+  if ( !inISR || (stats[i].budgetCycles == 0) || (cycles <= stats[i].budgetCycles) )
+  {
+    return;
+  }
+
+  stats[i].numOverruns++;
+
+  if (stats[i].policy == TIMER_BUDGET_DEFER)
+  {
+    stats[i].demoted = true;
+  }
+  else if (stats[i].policy == TIMER_BUDGET_DISABLE)
+  {
+    timer[i].enabled = false;
+  }
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::setBudget(const unsigned& numTimer, const unsigned long& budgetUs, const uint8_t& policy)
+{
+  if ( (numTimer >= MAX_NUMBER_TIMERS) || (policy > TIMER_BUDGET_DISABLE) || (timer[numTimer].callback == NULL) )
+  {
+    return false;
+  }
+
+  // the steps of a sequence can't be deferred one by one, and a notification has no callback to defer
+  if ( (policy == TIMER_BUDGET_DEFER) &&
+       ( (timer[numTimer].type == TIMER_TYPE_SEQUENCE) || (timer[numTimer].type == TIMER_TYPE_NOTIFY) ) )
+  {
+    return false;
+  }
+
+  // the budget is kept in 32-bit cycles, the range of the cycle counter: ~17.9 s at 240 MHz
+  uint32_t cpuMHz = getCpuFrequencyMhz();
+
+  if (budgetUs > UINT32_MAX / cpuMHz)
+  {
+    TISR_LOGERROR1(F("setBudget: budget too long (us) = "), budgetUs);
+
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  stats[numTimer].budgetCycles  = budgetUs * cpuMHz;
+  stats[numTimer].policy        = policy;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+////////////////////////////////////////
+
+bool ESP32_ISR_Timer::getTimerStats(const unsigned& numTimer, timer_stats_t& timerStats)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  memcpy(&timerStats, (void*) &stats[numTimer], sizeof (timer_stats_t));
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+////////////////////////////////////////
+
+void ESP32_ISR_Timer::resetTimerStats(const unsigned& numTimer)
+{
+  if (numTimer >= MAX_NUMBER_TIMERS)
+  {
+    return;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  // keep the budget settings and the calls still waiting for runDeferred()
+  stats[numTimer].numCalls          = 0;
+  stats[numTimer].totalCycles       = 0;
+  stats[numTimer].maxCycles         = 0;
+  stats[numTimer].lastCycles        = 0;
+  stats[numTimer].numOverruns       = 0;
+  stats[numTimer].reportedOverruns  = 0;
+  stats[numTimer].demoted           = false;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+}
+
+////////////////////////////////////////
+
+unsigned ESP32_ISR_Timer::runDeferred()
+{
+  unsigned numCalled = 0;
+
+  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  {
+    // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+    portENTER_CRITICAL(&timerMux);
+
+    uint16_t  pendingCalls    = stats[i].pendingCalls;
+    bool      deleteWhenDone  = stats[i].deleteWhenDone;
+    uint32_t  newOverruns     = stats[i].numOverruns - stats[i].reportedOverruns;
+    void*     callback        = timer[i].callback;
+    void*     param           = timer[i].param;
+    uint8_t   type            = timer[i].type;
+
+    stats[i].pendingCalls     = 0;
+    stats[i].deleteWhenDone   = false;
+    stats[i].reportedOverruns = stats[i].numOverruns;
+
+    // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+    portEXIT_CRITICAL(&timerMux);
+
+    if (newOverruns)
+    {
+      TISR_LOGWARN3(F("ESP32_ISR_Timer: budget overruns, timer = "), i, F(", count = "), newOverruns);
+    }
+
+    if (callback == NULL)
+      continue;
+
+    for (uint16_t k = 0; k < pendingCalls; k++)
+    {
+      uint32_t startCycles = TISR_GET_CYCLE_COUNT();
+
+      if (type == TIMER_TYPE_PARAM)
+        (*(timer_callback_p)callback)(param);
+      else if (type == TIMER_TYPE_TIMEOUT)
+        (*(timer_callback_p)callback)(((ESP32_ISR_Timeout*) param)->param);
+      else
+        (*(timer_callback)callback)();
+
+      accountCycles(i, TISR_GET_CYCLE_COUNT() - startCycles, false);
+
+      numCalled++;
+    }
+
+    if (deleteWhenDone)
+    {
+      // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&timerMux);
+
+      // unless deleted by the callbacks, and the slot taken by a new timer meanwhile
+      bool removed = (timer[i].callback == callback) && (timer[i].param == param) && (timer[i].type == type) &&
+                     removeTimer(i);
+
+      // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+      portEXIT_CRITICAL(&timerMux);
+
+      if (removed)
+        timersChanged();
+    }
+  }
+
+  return numCalled;
+}
+
+#endif    // USING_ISR_TIMER_CPU_BUDGET
+
+////////////////////////////////////////
+
 #endif    // ISR_TIMER_GENERIC_IMPL_H
 
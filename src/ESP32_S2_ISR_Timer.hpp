@@ -67,6 +67,15 @@
 
 ////////////////////////////////////////
 
+// Opt-in IRAM mode: the timer interrupt is allocated with ESP_INTR_FLAG_IRAM, so it keeps firing while the flash cache
+// is disabled (OTA, NVS, SPIFFS / LittleFS writes). The whole dispatch path, including all your callbacks and the data
+// they touch, must then be in IRAM / DRAM (IRAM_ATTR, DRAM_ATTR). Can't use Serial, millis(), digitalWrite(), etc.
+#ifndef USING_ESP32_S2_TIMER_IRAM
+  #define USING_ESP32_S2_TIMER_IRAM       false
+#endif
+
+////////////////////////////////////////
+
 #include "TimerInterrupt_Generic_Debug.h"
 
 ////////////////////////////////////////
@@ -93,28 +102,286 @@
 
 ////////////////////////////////////////
 
+// Time source of run() and of all prev_millis updates. millis() is flash-resident, unless CONFIG_ARDUINO_ISR_IRAM,
+// so the IRAM mode uses the IRAM-resident esp_timer_get_time() instead (the 64-bit division is in ROM libgcc)
+#if USING_ESP32_S2_TIMER_IRAM
+  #include <esp_timer.h>
+
+  #if ( defined(ESP_IDF_VERSION_MAJOR) && (ESP_IDF_VERSION_MAJOR >= 5) )
+    #include <esp_memory_utils.h>
+  #else
+    #include <soc/soc_memory_layout.h>
+  #endif
+
+  #define ISR_TIMER_MILLIS()      ( (unsigned long) (esp_timer_get_time() / 1000LL) )
+#else
+  #define ISR_TIMER_MILLIS()      millis()
+#endif
+
+////////////////////////////////////////
+
+// Measure each callback's execution time with the CPU cycle counter in run(), and enforce per-timer CPU budgets
+#ifndef USING_ISR_TIMER_CPU_BUDGET
+  #define USING_ISR_TIMER_CPU_BUDGET      false
+#endif
+
+////////////////////////////////////////
+
+// Bit-packed timer record for RAM-constrained builds: 20 instead of 32 bytes per slot on ESP32_S2, at the cost of
+// delays limited to TIMER_MAX_DELAY (24 bits, ~4.6 hours) and run counts to TIMER_MAX_NUM_RUNS (16 bits).
+// Use getTimerRecordSize() to check the actual size
+#ifndef USING_ISR_TIMER_COMPACT
+  #define USING_ISR_TIMER_COMPACT         false
+#endif
+
+#if USING_ISR_TIMER_COMPACT
+  #define TIMER_MAX_DELAY                 0x00FFFFFFUL
+  #define TIMER_MAX_NUM_RUNS              0xFFFFU
+#else
+  #define TIMER_MAX_DELAY                 0xFFFFFFFFUL
+  #define TIMER_MAX_NUM_RUNS              0xFFFFFFFFU
+#endif
+
+////////////////////////////////////////
+
+// maximum number of timers. Can be raised, e.g. with USING_ISR_TIMER_COMPACT, up to 255
+#ifndef MAX_NUMBER_TIMERS
+  #define MAX_NUMBER_TIMERS               16
+#endif
+
+#if (MAX_NUMBER_TIMERS > 255)
+  #error MAX_NUMBER_TIMERS must be <= 255
+#endif
+
+////////////////////////////////////////
+
+// Number of different tasks notified together by TIMER_TYPE_NOTIFY timers, after the dispatch of run(). More tasks are
+// notified in further batches, each collected under the lock again
+#ifndef MAX_ISR_TIMER_NOTIFY_TASKS
+  #define MAX_ISR_TIMER_NOTIFY_TASKS      4
+#endif
+
+////////////////////////////////////////
+
+// Number of time domains, including domain 0 (TIMER_DOMAIN_REALTIME), the real time of ISR_TIMER_MILLIS().
+// The compact timer record has room for up to 4
+#ifndef MAX_TIME_DOMAINS
+  #define MAX_TIME_DOMAINS                4
+#endif
+
+#if ( (MAX_TIME_DOMAINS < 1) || (MAX_TIME_DOMAINS > 255) )
+  #error MAX_TIME_DOMAINS must be between 1 and 255
+#elif ( USING_ISR_TIMER_COMPACT && (MAX_TIME_DOMAINS > 4) )
+  #error MAX_TIME_DOMAINS must be <= 4 with USING_ISR_TIMER_COMPACT
+#endif
+
+#define TIMER_DOMAIN_REALTIME             0
+#define TIMER_DOMAIN_RATE_ONE             65536UL       // Q16 domain rate of real time
+
+////////////////////////////////////////
+
+// Coarser ticks tried by enableAutoTick() with a tolerance, beyond the exact GCD based tick. Bounds the time of each
+// update, in task context, to ISR_TIMER_AUTO_TICK_CANDIDATES times the number of intervals
+#ifndef ISR_TIMER_AUTO_TICK_CANDIDATES
+  #define ISR_TIMER_AUTO_TICK_CANDIDATES  256
+#endif
+
+////////////////////////////////////////
+
+// Number of phase bins of enablePhaseStagger() and getPeakLoad(), over the GCD of the periods. One byte each, on the
+// stack of the registering task. Bins are widened when the GCD is longer than ISR_TIMER_STAGGER_BINS ticks
+#ifndef ISR_TIMER_STAGGER_BINS
+  #define ISR_TIMER_STAGGER_BINS          128
+#endif
+
+#if ( (ISR_TIMER_STAGGER_BINS < 2) || (ISR_TIMER_STAGGER_BINS > 1024) )
+  #error ISR_TIMER_STAGGER_BINS must be between 2 and 1024
+#endif
+
+////////////////////////////////////////
+
 typedef void (*timer_callback)();
 typedef void (*timer_callback_p)(void *);
 
 ////////////////////////////////////////
 
+// One step of a timer sequence: after delay ms (counted from the previous step), call callback(param).
+// A step with delay = 0 runs in the same run() as the previous step. callback can be NULL for a pure wait
+typedef struct
+{
+  unsigned long     delay;
+  timer_callback_p  callback;
+  void*             param;
+} timer_step_t;
+
+// A sequence of steps run in one ESP32_ISR_Timer slot, e.g. "pulse A, wait 3 ms, pulse B, wait 10 ms, repeat".
+// steps can be const / in flash (DRAM_ATTR with USING_ESP32_S2_TIMER_IRAM). The object must stay valid while the
+// sequence runs: global or static
+typedef struct
+{
+  const timer_step_t* steps;
+  uint8_t             numSteps;
+  volatile uint8_t    curStep;            // next step to run, managed by ESP32_ISR_Timer
+} timer_sequence_t;
+
+////////////////////////////////////////
+
+// Registration table entry for schedule snapshots: a callback and its param, as given to setInterval(), setTimer(), etc.
+// A snapshot only stores the index of the entry (the callback id), so it stays valid across deep sleep and firmware
+// updates, as long as the table keeps its order
+typedef struct
+{
+  void*   callback;
+  void*   param;
+} timer_registry_t;
+
+#define TIMER_REGISTRY_ENTRY(f)                 { (void *) (f), NULL }
+#define TIMER_REGISTRY_ENTRY_P(f, p)            { (void *) (f), (void *) (p) }
+#define TIMER_REGISTRY_SEQUENCE(steps, seq)     { (void *) (steps), (void *) &(seq) }
+
+// One timer of a snapshot, 20 bytes
+typedef struct
+{
+  uint32_t  remaining;          // ms to the next run when saved, in the time of its domain
+  uint32_t  delay;
+  uint32_t  runsLeft;           // TIMER_RUN_FOREVER for ever
+  uint8_t   slot;               // timer number, restored unchanged
+  uint8_t   id;                 // callback id, index in the registration table
+  uint8_t   domain;
+  uint8_t   curStep;            // next step of a sequence
+  uint8_t   type;
+  uint8_t   priority;
+  bool      enabled;
+} timer_snapshot_entry_t;
+
+static_assert(sizeof(timer_snapshot_entry_t) == 20, "timer_snapshot_entry_t must be 20 bytes");
+
+// Serialized schedule of an ESP32_ISR_Timer, position independent: can be kept in RTC memory (RTC_DATA_ATTR) during
+// deep sleep. The magic number includes MAX_NUMBER_TIMERS and MAX_TIME_DOMAINS, so a snapshot of another layout is
+// rejected
+#define TIMER_SNAPSHOT_MAGIC            ( 0x54530000UL | (MAX_NUMBER_TIMERS << 8) | MAX_TIME_DOMAINS )
+
+typedef struct
+{
+  uint32_t                magic;
+  uint8_t                 numEntries;
+  uint8_t                 dispatchOrder;
+  uint8_t                 domainPaused[MAX_TIME_DOMAINS];
+  uint32_t                domainRate[MAX_TIME_DOMAINS];
+  timer_snapshot_entry_t  entries[MAX_NUMBER_TIMERS];
+} timer_snapshot_t;
+
+////////////////////////////////////////
+
+#if USING_ISR_TIMER_CPU_BUDGET
+
+// Per-timer execution time statistics, in CPU cycles (divide by getCpuFrequencyMhz() for microseconds)
+typedef struct
+{
+  uint32_t      numCalls;               // number of callback executions, in ISR and deferred
+  uint64_t      totalCycles;            // running total of execution time
+  uint32_t      maxCycles;              // longest execution
+  uint32_t      lastCycles;             // last execution
+  uint32_t      budgetCycles;           // budget, 0 = no budget
+  uint32_t      numOverruns;            // number of executions longer than budgetCycles
+  uint8_t       policy;                 // TIMER_BUDGET_xxx
+  bool          demoted;                // true once TIMER_BUDGET_DEFER has moved the timer to runDeferred()
+  uint16_t      pendingCalls;           // deferred calls waiting for runDeferred()
+  bool          deleteWhenDone;         // last deferred run of a TIMER_RUN_ONCE / setTimer() timer
+  uint32_t      reportedOverruns;       // numOverruns already logged by runDeferred()
+} timer_stats_t;
+
+#endif
+
+////////////////////////////////////////
+
+// the driving hardware timer of the automatic base tick, in ESP32_S2_TimerInterrupt.h
+class ESP32TimerInterrupt;
+
+////////////////////////////////////////
+
+// Lazy-reset timeout, for watchdog / keepalive patterns re-armed at a high rate. kick() is only one store of the
+// activity time: the timer slot isn't touched, and only checks this time when the timeout is due, to either fire or
+// re-arm itself from the last kick(). The object must stay valid while its timer runs: global or static
+class ESP32_ISR_Timeout
+{
+  public:
+
+    ESP32_ISR_Timeout()
+    {
+      lastActivity  = 0;
+      param         = NULL;
+      numTimer      = -1;
+    };
+
+    // keeps the timeout from expiring for its whole delay, from now. Safe in ISR and from any task or core
+    inline void IRAM_ATTR kick() __attribute__((always_inline))
+    {
+      lastActivity = ISR_TIMER_MILLIS();
+    };
+
+    // timer number of this timeout, -1 if not set or deleted
+    int getTimer()
+    {
+      return numTimer;
+    };
+
+  private:
+
+    friend class ESP32_ISR_Timer;
+
+    volatile unsigned long  lastActivity;     // ISR_TIMER_MILLIS() of the last kick()
+    void*                   param;            // callback parameter
+    volatile int            numTimer;
+};
+
+////////////////////////////////////////
+
 class ESP32_ISR_Timer 
 {
 
   public:
-    // maximum number of timers
 
-#define MAX_NUMBER_TIMERS         16
 #define TIMER_RUN_FOREVER         0
 #define TIMER_RUN_ONCE            1
 
+    // priority classes, higher runs first when several timers are due in the same run()
+#define TIMER_PRIORITY_LOW        0
+#define TIMER_PRIORITY_NORMAL     1       // default
+#define TIMER_PRIORITY_HIGH       2
+#define TIMER_PRIORITY_CRITICAL   3
+
+    // dispatch order of the timers due in the same run(). Ties are always broken by the lower slot index, so the
+    // order is deterministic:
+    // TIMER_DISPATCH_SLOT     : slot index order (default, as before)
+    // TIMER_DISPATCH_PRIORITY : higher priority class first, then slot index
+    // TIMER_DISPATCH_EDF      : higher priority class first, then earliest deadline first (deadline = end of the
+    //                           current period, i.e. prev_millis + delay), then slot index
+#define TIMER_DISPATCH_SLOT       0
+#define TIMER_DISPATCH_PRIORITY   1
+#define TIMER_DISPATCH_EDF        2
+
     // constructor
     ESP32_ISR_Timer();
 
     void init();
 
-    // this function must be called inside loop()
-    void IRAM_ATTR run();
+    // this function must be called inside loop(), or from an ESP32TimerInterrupt callback.
+    // returns true if a task notification woke a higher priority task: return it from the ESP32TimerInterrupt callback
+    // to switch to that task right after the ISR
+    bool IRAM_ATTR run();
+
+    // to be called by a callback run by run(), which returns void, that woke a higher priority task, e.g. with
+    // xTaskNotifyFromISR() or ESP32_CoScheduler::tick(): run() then returns true as well
+    void IRAM_ATTR requestYield()
+    {
+      yieldRequested = true;
+    };
+
+    // to be called by a callback run by run(): 'task' is notified (eSetBits) after all the callbacks, out of the lock,
+    // together with the TIMER_TYPE_NOTIFY timers. Returns false if MAX_ISR_TIMER_NOTIFY_TASKS other tasks are already
+    // waiting for such a notification
+    bool IRAM_ATTR notifyFromRun(TaskHandle_t task, const uint32_t& bits);
 
     // Timer will call function 'f' every 'd' milliseconds forever
     // returns the timer number (numTimer) on success or
@@ -146,23 +413,48 @@ class ESP32_ISR_Timer
     // -1 on failure (f == NULL) or no free timers
     int setTimer(const unsigned long& d, timer_callback_p f, void* p, const unsigned& n);
 
-    // updates interval of the specified timer
+    // Timer will run the steps of sequence 'seq' one after the other, the whole sequence 'n' times
+    // (TIMER_RUN_FOREVER by default), in only one timer slot. A completed step arms the next one, without any
+    // setTimeout() or slot scan
+    // returns the timer number (numTimer) on success or
+    // -1 on failure (invalid sequence) or no free timers
+    int setSequence(timer_sequence_t& seq, const unsigned& n = TIMER_RUN_FOREVER);
+
+    // Timer will call function 'f' with parameter 'p' when 'timeout' hasn't been kicked for 'd' milliseconds,
+    // 'n' times (TIMER_RUN_ONCE by default, TIMER_RUN_FOREVER to fire again every 'd' milliseconds while idle)
+    // returns the timer number (numTimer) on success or
+    // -1 on failure (f == NULL) or no free timers
+    int setLazyTimeout(ESP32_ISR_Timeout& timeout, const unsigned long& d, timer_callback_p f, void* p,
+                       const unsigned& n = TIMER_RUN_ONCE);
+
+    // Timer will set 'bits' in the notification value of 'task' (eSetBits) every 'd' milliseconds 'n' times
+    // (TIMER_RUN_FOREVER by default), without callback. The notifications of one run() are sent once per task,
+    // after all the callbacks. task = NULL for the calling task, which then waits with xTaskNotifyWait()
+    // returns the timer number (numTimer) on success or
+    // -1 on failure (bits == 0) or no free timers
+    int setTaskNotify(const unsigned long& d, TaskHandle_t task, const uint32_t& bits,
+                      const unsigned& n = TIMER_RUN_FOREVER);
+
+    // updates interval of the specified timer. Not for sequences
     bool changeInterval(const unsigned& numTimer, const unsigned long& d);
 
     // destroy the specified timer
-    void deleteTimer(const unsigned& numTimer);
+    void IRAM_ATTR deleteTimer(const unsigned& numTimer);
 
     // restart the specified timer
-    void restartTimer(const unsigned& numTimer);
+    void IRAM_ATTR restartTimer(const unsigned& numTimer);
 
     // returns true if the specified timer is enabled
     bool isEnabled(const unsigned& numTimer);
 
+    // returns true if the specified timer is used, enabled or not
+    bool IRAM_ATTR isUsed(const unsigned& numTimer);
+
     // enables the specified timer
-    void enable(const unsigned& numTimer);
+    void IRAM_ATTR enable(const unsigned& numTimer);
 
     // disables the specified timer
-    void disable(const unsigned& numTimer);
+    void IRAM_ATTR disable(const unsigned& numTimer);
 
     // enables all timers
     void enableAll();
@@ -176,6 +468,147 @@ class ESP32_ISR_Timer
     // returns the number of used timers
     unsigned getNumTimers();
 
+    // sets the priority class (TIMER_PRIORITY_LOW to TIMER_PRIORITY_CRITICAL) of the specified timer
+    // returns false for a non-used timer or an invalid priority
+    bool setPriority(const unsigned& numTimer, const uint8_t& priority);
+
+    // returns the priority class of the specified timer
+    uint8_t getPriority(const unsigned& numTimer);
+
+    // selects the dispatch order (TIMER_DISPATCH_SLOT, TIMER_DISPATCH_PRIORITY or TIMER_DISPATCH_EDF)
+    void setDispatchOrder(const uint8_t& order);
+
+    // returns the dispatch order
+    uint8_t getDispatchOrder()
+    {
+      return dispatchOrder;
+    };
+
+		////////////////////////////////////////
+
+    // Time domains: a domain is a virtual clock shared by a group of timers, e.g. all the timers of a subsystem,
+    // which can be paused, resumed and rate-scaled as a whole. Timers are in TIMER_DOMAIN_REALTIME by default.
+    // Pause, resume and rate changes only rebase the domain clock: O(1), whatever the number of timers
+
+    // creates a time domain. name is only kept as a pointer: use a literal
+    // returns the domain number on success or -1 if MAX_TIME_DOMAINS domains are already used
+    int addTimeDomain(const char* name);
+
+    // returns the number of the domain named 'name', or -1 if not found
+    int findTimeDomain(const char* name);
+
+    // moves the specified timer to 'domain', keeping its remaining time (counted in the new domain's time).
+    // returns false for a non-used timer, an unknown domain or a lazy timeout, always in real time
+    bool setTimerDomain(const unsigned& numTimer, const uint8_t& domain);
+
+    // returns the domain of the specified timer
+    uint8_t getTimerDomain(const unsigned& numTimer);
+
+    // freezes the clock of 'domain'. Its timers keep their remaining times until resumeDomain()
+    // returns false for an unknown domain or TIMER_DOMAIN_REALTIME
+    bool pauseDomain(const uint8_t& domain);
+
+    // restarts the clock of 'domain' from where pauseDomain() froze it
+    bool resumeDomain(const uint8_t& domain);
+
+    // returns true if 'domain' is paused
+    bool isDomainPaused(const uint8_t& domain);
+
+    // sets the clock rate of 'domain' relative to real time, e.g. 0.5 for half speed, 2.0 for double speed.
+    // Q16 fixed point internally: 0.0 to 65535.0, in steps of 1/65536. Timers keep their remaining domain time
+    bool setDomainRate(const uint8_t& domain, const float& rate);
+
+    // returns the current time of 'domain', in domain milliseconds
+    unsigned long getDomainMillis(const uint8_t& domain);
+
+		////////////////////////////////////////
+
+    // Automatic base tick: reprograms 'timer', the ESP32TimerInterrupt calling run(), to the coarsest tick in ms, up to
+    // maxTickMs, serving all the timers: each interval must be a multiple of the tick, within tolerancePercent of the
+    // interval. Without tolerance, it's the largest divisor <= maxTickMs of the GCD of the intervals. Updated whenever
+    // timers are added, changed or deleted from task context. Timers deleted by run() (last run of setTimeout() /
+    // setTimer()) are taken into account by the next update, or by updateAutoTick().
+    // The ticks keep their own phase: a timer runs at the first tick after it's due, i.e. up to one tick late, by the
+    // same amount at every run as its phase is kept. maxTickMs is then also the largest lateness accepted
+    // returns false for an invalid maxTickMs or tolerancePercent
+    bool enableAutoTick(ESP32TimerInterrupt& timer, const unsigned long& maxTickMs = 1000,
+                        const uint8_t& tolerancePercent = 0);
+
+    // stops updating the tick. The timer keeps its last interval
+    void disableAutoTick();
+
+    // updates the tick if timers changed since the last update, e.g. from loop(). Task context only
+    // returns true if the timer was reprogrammed
+    bool updateAutoTick();
+
+    // returns the current automatic tick in ms, 0 if not enabled
+    unsigned long getAutoTick()
+    {
+      return autoTickMs;
+    };
+
+    // leaves the timer out of the automatic tick, e.g. the slot of ESP32_ISR_LongTimer, re-armed with a different
+    // interval at each run. An exempt timer runs up to one tick late
+    // returns false for a non-used numTimer
+    bool setAutoTickExempt(const unsigned& numTimer, const bool& exempt = true);
+
+		////////////////////////////////////////
+
+    // Phase staggering: periodic timers registered from now on (setInterval(), setTimer() with more than one run,
+    // setTaskNotify()) get their first run moved earlier, by less than one period, to the phase where the fewest
+    // timers are due, so that aligned periods don't pile up their callbacks in the same run(). The periods don't
+    // change. Phases are compared modulo the GCD of the periods, in bins of resolutionMs (the automatic tick if
+    // coarser). Timeouts, one-shots, sequences and timers of other time domains are left as set
+    void enablePhaseStagger(const unsigned long& resolutionMs = 1);
+
+    void disablePhaseStagger()
+    {
+      staggerEnabled = false;
+    };
+
+    // upper bound of the number of periodic real time timers due in the same run(), at the staggering resolution.
+    // Timers of delay shorter than 2 bins count everywhere. Task context
+    unsigned getPeakLoad();
+
+		////////////////////////////////////////
+
+    // saves the schedule (remaining times, periods, run counts, callback ids) into 'snapshot', e.g. before deep sleep.
+    // Each timer's callback and param must be in 'registry'. Lazy timeouts, kick()-based, and task notifications,
+    // whose task handles change at each boot, are not saved, nor timers done but not deleted yet
+    // returns the number of timers saved, or -1 if some timers aren't in the registry (then none are saved)
+    int saveSnapshot(timer_snapshot_t& snapshot, const timer_registry_t* registry, const uint8_t& numEntries);
+
+    // replaces all timers with the ones of 'snapshot', in the same timer numbers, and with 'elapsedMs' (e.g. the deep
+    // sleep time) already elapsed. The phases are kept: the runs missed meanwhile are coalesced into one, as run() does
+    // for late timers. Time domains must be added again first, in the same order
+    // returns the number of timers restored, or -1 for an invalid snapshot or registry
+    int restoreSnapshot(const timer_snapshot_t& snapshot, const timer_registry_t* registry, const uint8_t& numEntries,
+                        const unsigned long& elapsedMs);
+
+#if USING_ISR_TIMER_CPU_BUDGET
+
+    // budget policies, applied when a callback runs longer than its budget
+#define TIMER_BUDGET_LOG          0       // count the overrun, logged later by runDeferred()
+#define TIMER_BUDGET_DEFER        1       // demote the timer: its callback is then only called from runDeferred()
+#define TIMER_BUDGET_DISABLE      2       // disable the timer, until enable()
+
+    // sets the CPU budget (microseconds per callback execution, 0 = none) and overrun policy of the specified timer
+    // returns false for a non-used timer, an invalid policy, or a budget over UINT32_MAX CPU cycles (~17.9 s at 240 MHz)
+    bool setBudget(const unsigned& numTimer, const unsigned long& budgetUs, const uint8_t& policy);
+
+    // copies the execution time statistics of the specified timer. Returns false for an invalid numTimer
+    bool getTimerStats(const unsigned& numTimer, timer_stats_t& timerStats);
+
+    // clears the statistics of the specified timer and promotes a demoted timer back to ISR dispatch
+    void resetTimerStats(const unsigned& numTimer);
+
+    // this function must be called from loop() or a task when any budget policy is used.
+    // Calls the deferred callbacks of demoted timers and logs new overruns.
+    // returns the number of callbacks called
+    unsigned runDeferred();
+
+#endif
+
 		////////////////////////////////////////
 
     // returns the number of available timers
@@ -186,42 +619,191 @@ class ESP32_ISR_Timer
 
 		////////////////////////////////////////
 
+    // returns the size in bytes of one timer record, 32 by default or 20 with USING_ISR_TIMER_COMPACT on ESP32_S2
+    static constexpr size_t getTimerRecordSize()
+    {
+      return sizeof(timer_t);
+    };
+
+		////////////////////////////////////////
+
   private:
+    // timer types
+#define TIMER_TYPE_NOPARAM      0       // callback is a timer_callback
+#define TIMER_TYPE_PARAM        1       // callback is a timer_callback_p, called with param
+#define TIMER_TYPE_SEQUENCE     2       // param is a timer_sequence_t*, callback its steps
+#define TIMER_TYPE_TIMEOUT      3       // param is an ESP32_ISR_Timeout*, callback a timer_callback_p
+#define TIMER_TYPE_NOTIFY       4       // param is a TaskHandle_t, callback the notification bits
+
     // deferred call constants
 #define TIMER_DEFCALL_DONTRUN   0       // don't call the callback function
 #define TIMER_DEFCALL_RUNONLY   1       // call the callback function but don't delete the timer
 #define TIMER_DEFCALL_RUNANDDEL 2       // call the callback function and delete the timer
+#define TIMER_DEFCALL_NOTIFY    3       // notify later, over MAX_ISR_TIMER_NOTIFY_TASKS, but don't delete the timer
+#define TIMER_DEFCALL_NOTIFYDEL 4       // notify later, over MAX_ISR_TIMER_NOTIFY_TASKS, and delete the timer
 
     // low level function to initialize and enable a new timer
     // returns the timer number (numTimer) on success or
     // -1 on failure (f == NULL) or no free timers
-    int setupTimer(const unsigned long& d, void* f, void* p, bool h, const unsigned& n);
+    int setupTimer(const unsigned long& d, void* f, void* p, const uint8_t& type, const unsigned& n);
+
+    // runs the due step of sequence timer i, plus the following steps with delay = 0, then arms the next step.
+    // returns true at the end of a sequence run
+    bool runSequenceStep(const uint8_t& i);
 
     // find the first available slot
     int findFirstFreeSlot();
 
+    // frees the slot of the specified timer. returns false if it wasn't used
+    bool IRAM_ATTR removeTimer(const unsigned& numTimer);
+
+    bool IRAM_ATTR takeRunNotify(TaskHandle_t* notifyTask, uint32_t* notifyBits, uint8_t& numNotify);
+
+    // marks the timers as changed, and updates the automatic tick unless called in ISR
+    void IRAM_ATTR timersChanged();
+
+    // timer as seen by computeAutoTick(), copied under timerMux
+    typedef struct
+    {
+      unsigned long           delay;
+      uint32_t                rate;     // Q16 rate of the timer domain
+      const timer_sequence_t* seq;      // steps to use instead of delay, or NULL
+    } auto_tick_slot_t;
+
+    // coarsest tick serving all the timers, for enableAutoTick()
+    unsigned long computeAutoTick();
+
+    // true if 'interval' is a multiple of 'tick', within autoTickTolerance
+    bool tickServes(const unsigned long& tick, const unsigned long& interval);
+
+    // true if 'tick' serves all the intervals of slots[]
+    bool tickServesAll(const unsigned long& tick, const auto_tick_slot_t* slots, const uint8_t& numSlots);
+
+    // largest divisor of n <= maxDivisor
+    unsigned long largestDivisor(const unsigned long& n, const unsigned long& maxDivisor);
+
+    inline bool IRAM_ATTR isAutoTickExempt(const unsigned& numTimer) __attribute__((always_inline))
+    {
+      return (autoTickExempt[numTimer >> 3] & (1 << (numTimer & 7)));
+    }
+
+    // true if the timer has a fixed period in real time, and can be staggered
+    bool staggerable(const uint8_t type, const uint8_t domain, const unsigned maxNumRuns);
+
+    // phase histogram of the staggerable timers, plus one of period 'newDelay' if not 0, for getPeakLoad() and
+    // setupTimer(). Returns the number of timers due at each run (delay < 2 bins)
+    unsigned phaseHistogram(uint8_t* bins, unsigned& numBins, unsigned long& period, unsigned long& width,
+                            const unsigned long& newDelay);
+
+    // how much earlier than 'now' to start a new timer of period d, to put it in the least loaded phase bin
+    unsigned long staggerAdvance(const unsigned long& d, const unsigned long& now);
+
+    // true if due timer i must be dispatched before due timer j, according to dispatchOrder
+    // now[] are the domain times of this run()
+    bool dispatchBefore(const uint8_t& i, const uint8_t& j, const unsigned long* now);
+
+    // time of 'domain' at real time realMillis
+    unsigned long domainMillis(const uint8_t domain, const unsigned long& realMillis);
+
+    // moves the base of 'domain' to realMillis, before a pause, resume or rate change
+    void rebaseDomain(const uint8_t& domain, const unsigned long& realMillis);
+
+#if USING_ISR_TIMER_CPU_BUDGET
+    // updates the statistics of timer i after a callback execution, and applies its budget policy
+    void accountCycles(const uint8_t& i, const uint32_t& cycles, const bool& inISR);
+#endif
+
 		////////////////////////////////////////
 
+#if USING_ISR_TIMER_COMPACT
+
+    // 20 bytes on ESP32_S2. Same field names as the full record, so run() and the API are unchanged
     typedef struct 
     {
-      unsigned long prev_millis;        // value returned by the millis() function in the previous run() call
+      unsigned long prev_millis;        // domain time (millis() in TIMER_DOMAIN_REALTIME) of the previous run
       void*         callback;           // pointer to the callback function
       void*         param;              // function parameter
-      bool          hasParam;           // true if callback takes a parameter
+      uint32_t      delay       : 24;   // delay value, up to TIMER_MAX_DELAY
+      uint32_t      priority    : 2;    // priority class, TIMER_PRIORITY_xxx
+      uint32_t      domain      : 2;    // time domain, up to 4
+      uint32_t      type        : 3;    // TIMER_TYPE_xxx
+      uint32_t      enabled     : 1;    // true if enabled
+      uint16_t      maxNumRuns;         // number of runs to be executed, up to TIMER_MAX_NUM_RUNS
+      uint16_t      numRuns;            // number of executed runs
+    } timer_t;
+
+    // on 32-bit targets. 64-bit pointers, e.g. in host builds, make it larger
+    static_assert( (sizeof(void*) != 4) || (sizeof(timer_t) == 20), "compact timer_t must be 20 bytes" );
+
+#else
+
+    // 32 bytes on ESP32_S2
+    typedef struct 
+    {
+      unsigned long prev_millis;        // domain time (millis() in TIMER_DOMAIN_REALTIME) of the previous run
+      void*         callback;           // pointer to the callback function
+      void*         param;              // function parameter
+      uint8_t       type;               // TIMER_TYPE_xxx
+      uint8_t       priority;           // priority class, TIMER_PRIORITY_xxx
+      uint8_t       domain;             // time domain
       unsigned long delay;              // delay value
       unsigned      maxNumRuns;         // number of runs to be executed
       unsigned      numRuns;            // number of executed runs
       bool          enabled;            // true if enabled
-      unsigned      toBeCalled;         // deferred function call (sort of) - N.B.: only used in run()
     } timer_t;
 
+    static_assert( (sizeof(void*) != 4) || (sizeof(timer_t) == 32), "timer_t must be 32 bytes" );
+
+#endif
+
 		////////////////////////////////////////
 
     volatile timer_t timer[MAX_NUMBER_TIMERS];
 
+    // time domain clock: time = baseVirtual + (ISR_TIMER_MILLIS() - baseReal) * rate, frozen at baseVirtual if paused
+    typedef struct
+    {
+      const char*   name;               // NULL for a free domain
+      unsigned long baseVirtual;        // domain time at baseReal
+      unsigned long baseReal;           // ISR_TIMER_MILLIS() of the last rebase
+      uint32_t      rate;               // Q16, TIMER_DOMAIN_RATE_ONE = real time
+      bool          paused;
+    } timer_domain_t;
+
+    volatile timer_domain_t domains[MAX_TIME_DOMAINS];
+
     // actual number of timers in use (-1 means uninitialized)
     volatile int numTimers;
 
+    // dispatch order of due timers, TIMER_DISPATCH_xxx
+    volatile uint8_t dispatchOrder = TIMER_DISPATCH_SLOT;
+
+    // set by requestYield(), returned and cleared by run()
+    volatile bool yieldRequested = false;
+
+    // notifyFromRun() requests, moved to the notifications of run() after its callbacks
+    TaskHandle_t  runNotifyTask[MAX_ISR_TIMER_NOTIFY_TASKS];
+    uint32_t      runNotifyBits[MAX_ISR_TIMER_NOTIFY_TASKS];
+    uint8_t       numRunNotify = 0;
+
+    // automatic base tick, enableAutoTick()
+    ESP32TimerInterrupt*  autoTickTimer     = NULL;
+    unsigned long         autoTickMax       = 0;
+    unsigned long         autoTickMs        = 0;
+    uint8_t               autoTickTolerance = 0;
+    volatile bool         autoTickDirty     = false;
+    uint8_t               autoTickExempt[(MAX_NUMBER_TIMERS + 7) / 8] = { 0 };
+
+    // phase staggering, enablePhaseStagger(). Phases are taken from staggerOrigin, so that they stay consistent
+    // when ISR_TIMER_MILLIS() wraps around
+    bool                  staggerEnabled    = false;
+    unsigned long         staggerResolution = 1;
+    unsigned long         staggerOrigin     = 0;
+
+#if USING_ISR_TIMER_CPU_BUDGET
+    volatile timer_stats_t stats[MAX_NUMBER_TIMERS];
+#endif
+
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
     portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED;
 };
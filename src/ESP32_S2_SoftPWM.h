@@ -0,0 +1,397 @@
+/****************************************************************************************************************************
+  ESP32_S2_SoftPWM.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_SoftPWM is a multi-channel software PWM on one ESP32TimerInterrupt. The edge times of each period are kept sorted,
+  and one-shot alarms are armed only at the actual edges, so the CPU cost is proportional to the number of distinct edges,
+  not to a tick rate. All edges at the same time are written with one register write, and new duty cycles are applied
+  atomically at the next period boundary.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef SOFT_PWM_GENERIC_H
+#define SOFT_PWM_GENERIC_H
+
+////////////////////////////////////////
+
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include <soc/gpio_struct.h>
+
+////////////////////////////////////////
+
+#ifndef MAX_SOFT_PWM_CHANNELS
+  #define MAX_SOFT_PWM_CHANNELS         16
+#endif
+
+#if (MAX_SOFT_PWM_CHANNELS > 64)
+  #error MAX_SOFT_PWM_CHANNELS must be <= 64
+#endif
+
+// Minimum time (counts, 1 count = 1us by default) between two edges, and minimum pulse width. Closer edges are merged.
+// An edge closer than this to the current time is merged as well: applied at once, up to this early, instead of armed
+#ifndef SOFT_PWM_MIN_EDGE_COUNTS
+  #define SOFT_PWM_MIN_EDGE_COUNTS      8
+#endif
+
+////////////////////////////////////////
+
+// Pins 0-31 are in the GPIO.out registers, pins 32+ in the GPIO.out1 registers
+typedef struct
+{
+  uint32_t      time;                   // counts from the period start
+  uint32_t      mask0;                  // pins 0-31 to clear
+  uint32_t      mask1;                  // pins 32+ to clear
+} soft_pwm_edge_t;
+
+typedef struct
+{
+  uint32_t        setMask0;             // pins set at the period start
+  uint32_t        setMask1;
+  uint8_t         numEdges;
+  soft_pwm_edge_t edges[MAX_SOFT_PWM_CHANNELS];
+} soft_pwm_schedule_t;
+
+////////////////////////////////////////
+
+class ESP32_SoftPWM
+{
+  public:
+
+    ////////////////////////////////////////
+
+    ESP32_SoftPWM()
+    {
+      _timer        = NULL;
+      _period       = 0;
+      _numChannels  = 0;
+      _event        = 0;
+      _active       = 0;
+      _pendingReady = false;
+
+      memset(_schedule, 0, sizeof(_schedule));
+    }
+
+    ////////////////////////////////////////
+
+    // Starts the PWM at frequency (Hz) on timer, which is then dedicated to it: its period is changed at each edge
+    bool begin(ESP32TimerInterrupt& timer, const float& frequency)
+    {
+      uint32_t period = (uint32_t) (TIMER_SCALE / frequency);
+
+      if (period < 4 * SOFT_PWM_MIN_EDGE_COUNTS)
+      {
+        TISR_LOGERROR1(F("ESP32_SoftPWM: frequency too high, max = "), TIMER_SCALE / (4 * SOFT_PWM_MIN_EDGE_COUNTS));
+
+        return false;
+      }
+
+      _timer  = &timer;
+      _period = period;
+      _event  = 0;
+
+      apply();
+
+      int8_t entryNum = timer.addCallback(pwmISR, this);
+
+      if (entryNum < 0)
+        return false;
+
+      if (!timer.setFrequency(frequency, NULL))
+      {
+        timer.removeCallback(entryNum);
+
+        return false;
+      }
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Adds a channel on pin, initially low. Returns the channel number, or -1
+    int8_t addChannel(const uint8_t& pin)
+    {
+      if ( (_numChannels >= MAX_SOFT_PWM_CHANNELS) || (pin >= 64) )
+      {
+        TISR_LOGERROR1(F("ESP32_SoftPWM: invalid pin or max channels = "), MAX_SOFT_PWM_CHANNELS);
+
+        return -1;
+      }
+
+      pinMode(pin, OUTPUT);
+      digitalWrite(pin, LOW);
+
+      _pin[_numChannels]  = pin;
+      _duty[_numChannels] = 0;
+
+      return _numChannels++;
+    }
+
+    ////////////////////////////////////////
+
+    // Duty cycle in counts, 0 (always low) to getPeriod() (always high). With applyNow = false, several channels
+    // can be changed and then applied together by apply(). Only after begin()
+    bool setDuty(const uint8_t& channel, const uint32_t& duty, const bool& applyNow = true)
+    {
+      if ( (channel >= _numChannels) || (_period == 0) )
+        return false;
+
+      _duty[channel] = (duty > _period) ? _period : duty;
+
+      if (applyNow)
+        apply();
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Duty cycle in 1/1000
+    bool setDutyPermille(const uint8_t& channel, const uint16_t& permille, const bool& applyNow = true)
+    {
+      return setDuty(channel, ( (uint64_t) _period * permille ) / 1000, applyNow);
+    }
+
+    ////////////////////////////////////////
+
+    uint32_t getDuty(const uint8_t& channel)
+    {
+      return (channel < _numChannels) ? _duty[channel] : 0;
+    }
+
+    ////////////////////////////////////////
+
+    // Builds the sorted edge schedule of the current duty cycles. It's used from the next period start
+    void apply()
+    {
+      soft_pwm_schedule_t schedule;
+
+      buildSchedule(schedule);
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_pwmMux);
+
+      memcpy((void *) &_schedule[_active ^ 1], &schedule, sizeof(soft_pwm_schedule_t));
+      _pendingReady = true;
+
+      portEXIT_CRITICAL(&_pwmMux);
+    }
+
+    ////////////////////////////////////////
+
+    // Period in counts
+    uint32_t getPeriod()
+    {
+      return _period;
+    }
+
+    ////////////////////////////////////////
+
+    uint8_t getNumChannels()
+    {
+      return _numChannels;
+    }
+
+    ////////////////////////////////////////
+
+    // Number of distinct edges per period in the active schedule, i.e. of interrupts per period minus 1
+    uint8_t getNumEdges()
+    {
+      return _schedule[_active].numEdges;
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    ////////////////////////////////////////
+
+    void buildSchedule(soft_pwm_schedule_t& schedule)
+    {
+      uint8_t  order[MAX_SOFT_PWM_CHANNELS];
+      uint8_t  numSorted = 0;
+
+      schedule.setMask0 = 0;
+      schedule.setMask1 = 0;
+      schedule.numEdges = 0;
+
+      for (uint8_t i = 0; i < _numChannels; i++)
+      {
+        if (_duty[i] == 0)
+          continue;
+
+        if (_pin[i] < 32)
+          schedule.setMask0 |= (1UL << _pin[i]);
+        else
+          schedule.setMask1 |= (1UL << (_pin[i] - 32));
+
+        if (_duty[i] >= _period)
+          continue;
+
+        // insertion sort of the channels with an edge, by duty
+        uint8_t pos = numSorted++;
+
+        while ( (pos > 0) && (_duty[order[pos - 1]] > _duty[i]) )
+        {
+          order[pos] = order[pos - 1];
+          pos--;
+        }
+
+        order[pos] = i;
+      }
+
+      // one edge per distinct time. Edges closer than SOFT_PWM_MIN_EDGE_COUNTS are merged into the earlier one
+      for (uint8_t k = 0; k < numSorted; k++)
+      {
+        uint8_t   i     = order[k];
+        uint32_t  time  = _duty[i];
+
+        if (time < SOFT_PWM_MIN_EDGE_COUNTS)
+          time = SOFT_PWM_MIN_EDGE_COUNTS;
+        else if (time > _period - SOFT_PWM_MIN_EDGE_COUNTS)
+          time = _period - SOFT_PWM_MIN_EDGE_COUNTS;
+
+        soft_pwm_edge_t* edge = (schedule.numEdges > 0) ? &schedule.edges[schedule.numEdges - 1] : NULL;
+
+        if ( (edge == NULL) || (time >= edge->time + SOFT_PWM_MIN_EDGE_COUNTS) )
+        {
+          edge = &schedule.edges[schedule.numEdges++];
+
+          edge->time  = time;
+          edge->mask0 = 0;
+          edge->mask1 = 0;
+        }
+
+        if (_pin[i] < 32)
+          edge->mask0 |= (1UL << _pin[i]);
+        else
+          edge->mask1 |= (1UL << (_pin[i] - 32));
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Applies event _event (0 = period start, k = edge k - 1) of the active schedule.
+    // Returns the counts until the next event
+    inline uint32_t IRAM_ATTR processEvent() __attribute__((always_inline))
+    {
+      uint32_t  curTime;
+
+      if (_event == 0)
+      {
+        // new duty cycles only at the period boundary
+        if (_pendingReady)
+        {
+          portENTER_CRITICAL_ISR(&_pwmMux);
+
+          _active       ^= 1;
+          _pendingReady = false;
+
+          portEXIT_CRITICAL_ISR(&_pwmMux);
+        }
+
+        const soft_pwm_schedule_t* schedule = &_schedule[_active];
+
+        GPIO.out_w1ts = schedule->setMask0;
+
+        if (schedule->setMask1)
+          GPIO.out1_w1ts.val = schedule->setMask1;
+
+        curTime = 0;
+      }
+      else
+      {
+        const soft_pwm_edge_t* edge = &_schedule[_active].edges[_event - 1];
+
+        if (edge->mask0)
+          GPIO.out_w1tc = edge->mask0;
+
+        if (edge->mask1)
+          GPIO.out1_w1tc.val = edge->mask1;
+
+        curTime = edge->time;
+      }
+
+      if (++_event > _schedule[_active].numEdges)
+      {
+        _event = 0;
+
+        return _period - curTime;
+      }
+
+      return _schedule[_active].edges[_event - 1].time - curTime;
+    }
+
+    ////////////////////////////////////////
+
+    // Chained callback of the timer, called at each event
+    static bool IRAM_ATTR pwmISR(void * arg)
+    {
+      ESP32_SoftPWM* pwm = (ESP32_SoftPWM*) arg;
+
+      // counts from the last auto-reload to the next event
+      uint32_t nextAlarm = 0;
+
+      // too close to arm an alarm in time, or already late: merged with this one, no waiting in the ISR. Each event is
+      // at least SOFT_PWM_MIN_EDGE_COUNTS after the previous one, so this ends once past the counter
+      do
+      {
+        nextAlarm += pwm->processEvent();
+      } while (pwm->_timer->getCounter() + SOFT_PWM_MIN_EDGE_COUNTS > nextAlarm);
+
+      pwm->_timer->setNextAlarmInISR(nextAlarm);
+
+      return false;
+    }
+
+    ////////////////////////////////////////
+
+    ESP32TimerInterrupt*  _timer;
+    uint32_t              _period;              // counts
+
+    uint8_t               _pin[MAX_SOFT_PWM_CHANNELS];
+    uint32_t              _duty[MAX_SOFT_PWM_CHANNELS];
+    uint8_t               _numChannels;
+
+    // double-buffered schedules, _active used by the ISR, the other one written by apply()
+    soft_pwm_schedule_t   _schedule[2];
+    volatile uint8_t      _active;
+    volatile bool         _pendingReady;
+    uint8_t               _event;               // next event of the active schedule
+
+    // ESP32 is a multi core / multi processing chip. Protects the schedule swap against the ISR on the other core
+    portMUX_TYPE          _pwmMux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif    // SOFT_PWM_GENERIC_H
@@ -0,0 +1,554 @@
+/****************************************************************************************************************************
+  ESP32_S2_TimerCoroutine.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  C++20 coroutine awaitables driven by the timer ISR. Many lightweight logical tasks (ESP32_CoTask) can co_await
+  sleep_for(us), next_tick(tick) or event.wait(timeoutUs) and all share one FreeRTOS task and one hardware timer.
+  The ISR only moves expired waiters to a ready queue; coroutines are always resumed by ESP32_CoScheduler::run(),
+  in task context. Opt-in, as the ESP32 cores build with -std=gnu++11 / gnu++17: define
+  USING_ESP32_S2_TIMER_COROUTINE true before including this file, and build with -std=gnu++20 (or -fcoroutines).
+  Otherwise this file is empty.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32_S2_TIMER_COROUTINE_H
+#define ESP32_S2_TIMER_COROUTINE_H
+
+////////////////////////////////////////
+
+#if !defined(USING_ESP32_S2_TIMER_COROUTINE)
+  #define USING_ESP32_S2_TIMER_COROUTINE      false
+#endif
+
+#if USING_ESP32_S2_TIMER_COROUTINE
+
+#if !defined(__cpp_impl_coroutine)
+  #error USING_ESP32_S2_TIMER_COROUTINE needs C++20 coroutines. Please compile with -std=gnu++20 or -fcoroutines
+#endif
+
+////////////////////////////////////////
+
+#if defined(ARDUINO)
+  #if ARDUINO >= 100
+    #include <Arduino.h>
+  #else
+    #include <WProgram.h>
+  #endif
+#endif
+
+#include "TimerInterrupt_Generic_Debug.h"
+
+#include <coroutine>
+#include <esp_timer.h>
+
+////////////////////////////////////////
+
+class ESP32_CoScheduler;
+
+////////////////////////////////////////
+
+// Intrusive waiter node, living inside the awaiter, i.e. inside the suspended coroutine frame. No allocation
+typedef struct co_waiter_s
+{
+  std::coroutine_handle<>  handle;
+  int64_t                  deadline;      // esp_timer_get_time() us, or -1 if no timeout
+  struct co_waiter_s*      next;          // sleep list, then ready queue
+  struct co_waiter_s*      nextWait;      // event / tick waiter list
+  void*                    waitList;      // ESP32_CoEvent / ESP32_CoTick waited on, or NULL
+  bool                     result;        // true if woken by the event / tick, false if timed out
+} co_waiter_t;
+
+////////////////////////////////////////
+
+// Fire-and-forget coroutine. Starts suspended, until ESP32_CoScheduler::spawn()
+class ESP32_CoTask
+{
+  public:
+
+    struct promise_type
+    {
+      ESP32_CoTask get_return_object()
+      {
+        return ESP32_CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+
+      std::suspend_always initial_suspend() noexcept
+      {
+        return {};
+      }
+
+      // Frame is destroyed as soon as the coroutine body returns
+      std::suspend_never final_suspend() noexcept
+      {
+        return {};
+      }
+
+      void return_void() {}
+
+      void unhandled_exception()
+      {
+        abort();
+      }
+    };
+
+    ////////////////////////////////////////
+
+    explicit ESP32_CoTask(std::coroutine_handle<> h) : _handle(h) {};
+
+    std::coroutine_handle<> _handle;
+};
+
+////////////////////////////////////////
+
+class ESP32_CoScheduler
+{
+  public:
+
+    ESP32_CoScheduler()
+      : _sleepers(NULL), _readyHead(NULL), _readyTail(NULL), _runner(NULL)
+    {
+    };
+
+    ////////////////////////////////////////
+
+    // Start a coroutine. It runs the next time run() / runReady() is called
+    void spawn(ESP32_CoTask task)
+    {
+      co_waiter_t* waiter = new co_waiter_t;
+
+      waiter->handle    = task._handle;
+      waiter->deadline  = -1;
+      waiter->result    = true;
+
+      // Spawn nodes are owned by the scheduler, flagged by waitList == this, and freed in runReady()
+      waiter->waitList  = (void*) this;
+
+      portENTER_CRITICAL(&_mux);
+      pushReady(waiter);
+      _spawned++;
+      portEXIT_CRITICAL(&_mux);
+
+      notifyRunner();
+    }
+
+    ////////////////////////////////////////
+
+    // Call from the timer ISR, e.g. an ESP32_ISR_Timer callback or an ESP32TimerInterrupt callback.
+    // Moves expired sleepers to the ready queue. Returns true if the runner task must be switched to: return it from
+    // an ESP32TimerInterrupt callback, or pass it to ESP32_ISR_Timer::requestYield() from a void ESP32_ISR_Timer
+    // callback, e.g. "if (scheduler.tick()) ISR_Timer.requestYield();"
+    bool IRAM_ATTR tick()
+    {
+      int64_t currTime  = esp_timer_get_time();
+      bool    woken     = false;
+
+      portENTER_CRITICAL_ISR(&_mux);
+
+      while ( _sleepers && (_sleepers->deadline <= currTime) )
+      {
+        co_waiter_t* waiter = _sleepers;
+
+        _sleepers = waiter->next;
+
+        waiter->result = false;
+        detachWait(waiter);
+        pushReady(waiter);
+        woken = true;
+      }
+
+      portEXIT_CRITICAL_ISR(&_mux);
+
+      if (woken)
+        return notifyRunnerFromISR();
+
+      return false;
+    }
+
+    ////////////////////////////////////////
+
+    // Resume every ready coroutine once. Must always be called from the same task
+    // Returns true if at least one coroutine was resumed
+    bool runReady()
+    {
+      bool resumed = false;
+
+      _runner = xTaskGetCurrentTaskHandle();
+
+      while (true)
+      {
+        portENTER_CRITICAL(&_mux);
+
+        co_waiter_t* waiter = _readyHead;
+
+        if (waiter)
+        {
+          _readyHead = waiter->next;
+
+          if (_readyHead == NULL)
+            _readyTail = NULL;
+        }
+
+        portEXIT_CRITICAL(&_mux);
+
+        if (waiter == NULL)
+          break;
+
+        std::coroutine_handle<> handle = waiter->handle;
+
+        if (waiter->waitList == (void*) this)
+        {
+          // spawn node
+          delete waiter;
+        }
+
+        _current = this;
+        handle.resume();
+        _current = NULL;
+
+        resumed = true;
+      }
+
+      return resumed;
+    }
+
+    ////////////////////////////////////////
+
+    // Body of the FreeRTOS task hosting all coroutines. Never returns
+    void run()
+    {
+      while (true)
+      {
+        runReady();
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Scheduler running the calling coroutine, or NULL outside of run() / runReady()
+    static ESP32_CoScheduler* current()
+    {
+      return _current;
+    }
+
+    ////////////////////////////////////////
+
+    // Number of coroutines ever spawned
+    uint32_t getNumSpawned()
+    {
+      return _spawned;
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    friend class ESP32_CoEvent;
+    friend class ESP32_CoTick;
+    friend struct co_sleep_awaiter;
+    friend struct co_wait_awaiter;
+
+    co_waiter_t*          _sleepers;      // sorted by deadline, nearest first
+    co_waiter_t*          _readyHead;
+    co_waiter_t*          _readyTail;
+
+    volatile TaskHandle_t _runner;
+    uint32_t              _spawned = 0;
+
+    static inline ESP32_CoScheduler* _current = NULL;
+
+    // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+    portMUX_TYPE          _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held
+    void IRAM_ATTR pushReady(co_waiter_t* waiter)
+    {
+      waiter->next = NULL;
+
+      if (_readyTail)
+        _readyTail->next = waiter;
+      else
+        _readyHead = waiter;
+
+      _readyTail = waiter;
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held
+    void insertSleeper(co_waiter_t* waiter)
+    {
+      co_waiter_t** pp = &_sleepers;
+
+      while ( *pp && ( (*pp)->deadline <= waiter->deadline ) )
+        pp = &(*pp)->next;
+
+      waiter->next  = *pp;
+      *pp           = waiter;
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held
+    void IRAM_ATTR removeSleeper(co_waiter_t* waiter)
+    {
+      co_waiter_t** pp = &_sleepers;
+
+      while (*pp)
+      {
+        if (*pp == waiter)
+        {
+          *pp = waiter->next;
+
+          return;
+        }
+
+        pp = &(*pp)->next;
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held. Removes a timed-out waiter from its event / tick list
+    void IRAM_ATTR detachWait(co_waiter_t* waiter)
+    {
+      if (waiter->waitList == NULL)
+        return;
+
+      co_waiter_t** pp = (co_waiter_t**) waiter->waitList;
+
+      while (*pp)
+      {
+        if (*pp == waiter)
+        {
+          *pp = waiter->nextWait;
+          break;
+        }
+
+        pp = &(*pp)->nextWait;
+      }
+
+      waiter->waitList = NULL;
+    }
+
+    ////////////////////////////////////////
+
+    // Must be called with _mux held. Moves all waiters of a list to the ready queue
+    void IRAM_ATTR wakeAll(co_waiter_t** list)
+    {
+      while (*list)
+      {
+        co_waiter_t* waiter = *list;
+
+        *list = waiter->nextWait;
+
+        waiter->waitList  = NULL;
+        waiter->result    = true;
+
+        if (waiter->deadline >= 0)
+          removeSleeper(waiter);
+
+        pushReady(waiter);
+      }
+    }
+
+    ////////////////////////////////////////
+
+    void notifyRunner()
+    {
+      if (_runner)
+        xTaskNotifyGive(_runner);
+    }
+
+    ////////////////////////////////////////
+
+    bool IRAM_ATTR notifyRunnerFromISR()
+    {
+      BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+      if (_runner)
+        vTaskNotifyGiveFromISR(_runner, &higherPriorityTaskWoken);
+
+      return (higherPriorityTaskWoken == pdTRUE);
+    }
+
+    ////////////////////////////////////////
+
+    // Called from await_suspend(), i.e. from the runner task
+    void suspend(co_waiter_t* waiter, void* waitList, const int64_t& timeoutUs)
+    {
+      waiter->waitList  = waitList;
+      waiter->nextWait  = NULL;
+      waiter->deadline  = (timeoutUs < 0) ? -1 : esp_timer_get_time() + timeoutUs;
+      waiter->result    = false;
+
+      portENTER_CRITICAL(&_mux);
+
+      if (waitList)
+      {
+        waiter->nextWait            = *(co_waiter_t**) waitList;
+        *(co_waiter_t**) waitList   = waiter;
+      }
+
+      if (waiter->deadline >= 0)
+        insertSleeper(waiter);
+
+      portEXIT_CRITICAL(&_mux);
+    }
+
+}; // class ESP32_CoScheduler
+
+////////////////////////////////////////
+
+// co_await sleep_for(us) : resumes the coroutine after at least 'us' microseconds, rounded up to the next tick()
+struct co_sleep_awaiter
+{
+  int64_t     timeoutUs;
+  co_waiter_t waiter;
+
+  bool await_ready() const noexcept
+  {
+    return (timeoutUs <= 0);
+  }
+
+  void await_suspend(std::coroutine_handle<> h)
+  {
+    waiter.handle = h;
+    ESP32_CoScheduler::current()->suspend(&waiter, NULL, timeoutUs);
+  }
+
+  void await_resume() const noexcept {}
+};
+
+inline co_sleep_awaiter sleep_for(const int64_t& us)
+{
+  return co_sleep_awaiter{ us, {} };
+}
+
+////////////////////////////////////////
+
+// Awaiter shared by ESP32_CoEvent::wait() and next_tick(). await_resume() is true if signalled, false if timed out
+struct co_wait_awaiter
+{
+  co_waiter_t**   list;
+  int64_t         timeoutUs;
+  co_waiter_t     waiter;
+
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> h)
+  {
+    waiter.handle = h;
+    ESP32_CoScheduler::current()->suspend(&waiter, (void*) list, timeoutUs);
+  }
+
+  bool await_resume() const noexcept
+  {
+    return waiter.result;
+  }
+};
+
+////////////////////////////////////////
+
+// Event settable from ISR or task. All coroutines waiting on it are resumed
+class ESP32_CoEvent
+{
+  public:
+
+    ESP32_CoEvent(ESP32_CoScheduler& scheduler) : _scheduler(scheduler), _waiters(NULL) {};
+
+    // co_await event.wait() / co_await event.wait(timeoutUs) : true if set, false if timed out
+    co_wait_awaiter wait(const int64_t& timeoutUs = -1)
+    {
+      return co_wait_awaiter{ &_waiters, timeoutUs, {} };
+    }
+
+    // Returns true if the runner task must be switched to. From task context, the return value can be ignored
+    bool IRAM_ATTR set()
+    {
+      bool woken;
+
+      portENTER_CRITICAL_SAFE(&_scheduler._mux);
+
+      woken = (_waiters != NULL);
+      _scheduler.wakeAll(&_waiters);
+
+      portEXIT_CRITICAL_SAFE(&_scheduler._mux);
+
+      if (!woken)
+        return false;
+
+      if (xPortInIsrContext())
+        return _scheduler.notifyRunnerFromISR();
+
+      _scheduler.notifyRunner();
+
+      return false;
+    }
+
+  private:
+
+    ESP32_CoScheduler&  _scheduler;
+    co_waiter_t*        _waiters;
+};
+
+////////////////////////////////////////
+
+// Tick source, signalled from a timer callback. co_await next_tick(tick) resumes on the next signal()
+class ESP32_CoTick : public ESP32_CoEvent
+{
+  public:
+
+    ESP32_CoTick(ESP32_CoScheduler& scheduler) : ESP32_CoEvent(scheduler) {};
+
+    bool IRAM_ATTR signal()
+    {
+      return set();
+    }
+};
+
+inline co_wait_awaiter next_tick(ESP32_CoTick& tick, const int64_t& timeoutUs = -1)
+{
+  return tick.wait(timeoutUs);
+}
+
+////////////////////////////////////////
+
+#endif    // USING_ESP32_S2_TIMER_COROUTINE
+
+#endif    // ESP32_S2_TIMER_COROUTINE_H
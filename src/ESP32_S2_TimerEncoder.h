@@ -0,0 +1,315 @@
+/****************************************************************************************************************************
+  ESP32_S2_TimerEncoder.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_TimerEncoder decodes several quadrature encoders by sampling their A/B pins at a fixed rate on an
+  ESP32TimerInterrupt tick, instead of one GPIO interrupt per edge. All pins are read with one GPIO register read per tick,
+  and each encoder is decoded without branches with a 16-entry transition table. It keeps 32-bit positions, and
+  estimates the velocity from the timer timestamps of the edges.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef TIMER_ENCODER_GENERIC_H
+#define TIMER_ENCODER_GENERIC_H
+
+////////////////////////////////////////
+
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include <soc/gpio_struct.h>
+
+////////////////////////////////////////
+
+#ifndef MAX_TIMER_ENCODERS
+  #define MAX_TIMER_ENCODERS            8
+#endif
+
+// Transition table, indexed by (previous AB << 2) | current AB. Each 2-bit entry is the position change + 1.
+// Forward is AB = 00 -> 01 -> 11 -> 10 -> 00. The invalid transitions (both pins changed, i.e. a missed state) count 0,
+// and are flagged by ENCODER_INVALID_TRANSITIONS
+#define ENCODER_TRANSITION_TABLE        0x61169449UL
+#define ENCODER_INVALID_TRANSITIONS     0x1248U
+
+// Without any edge for this long, getVelocity() returns 0
+#ifndef ENCODER_VELOCITY_TIMEOUT_US
+  #define ENCODER_VELOCITY_TIMEOUT_US   500000UL
+#endif
+
+////////////////////////////////////////
+
+typedef struct
+{
+  uint8_t             pinA;
+  uint8_t             pinB;
+  bool                reverse;            // swaps the counting direction
+  uint8_t             state;              // last AB
+  volatile int32_t    position;
+  volatile uint32_t   errors;             // invalid transitions, i.e. sample rate too low for the edge rate
+  volatile uint64_t   edgeTimestamp;      // timer timestamp (counts) of the last position change
+  volatile int32_t    edgePosition;       // position at edgeTimestamp
+
+  // previous getVelocity() reference, task context only
+  uint64_t            refTimestamp;
+  int32_t             refPosition;
+  float               velocity;
+} timer_encoder_t;
+
+////////////////////////////////////////
+
+class ESP32_TimerEncoder
+{
+  public:
+
+    ////////////////////////////////////////
+
+    ESP32_TimerEncoder()
+    {
+      _timer        = NULL;
+      _numEncoders  = 0;
+      _callbackNo   = -1;
+    }
+
+    ////////////////////////////////////////
+
+    // Adds an encoder on pinA / pinB, configured as inputs with pull-ups. Returns the encoder number, or -1
+    int8_t addEncoder(const uint8_t& pinA, const uint8_t& pinB, const bool& reverse = false)
+    {
+      if ( (_numEncoders >= MAX_TIMER_ENCODERS) || (pinA >= 64) || (pinB >= 64) || (_callbackNo >= 0) )
+      {
+        TISR_LOGERROR1(F("ESP32_TimerEncoder: invalid pin, already started or max encoders = "), MAX_TIMER_ENCODERS);
+
+        return -1;
+      }
+
+      pinMode(pinA, INPUT_PULLUP);
+      pinMode(pinB, INPUT_PULLUP);
+
+      timer_encoder_t* encoder = &_encoders[_numEncoders];
+
+      memset((void *) encoder, 0, sizeof(timer_encoder_t));
+
+      encoder->pinA     = pinA;
+      encoder->pinB     = pinB;
+      encoder->reverse  = reverse;
+      encoder->state    = (digitalRead(pinA) << 1) | digitalRead(pinB);
+
+      return _numEncoders++;
+    }
+
+    ////////////////////////////////////////
+
+    // Starts sampling every divisor-th tick of timer, which can be running already and shared with other callbacks.
+    // The tick rate must be higher than the highest edge rate (4 edges per encoder cycle), or errors are counted
+    bool begin(ESP32TimerInterrupt& timer, const uint32_t& divisor = 1)
+    {
+      if (_callbackNo >= 0)
+        return false;
+
+      _timer      = &timer;
+
+      uint64_t now = timer.getTimestamp();
+
+      for (uint8_t i = 0; i < _numEncoders; i++)
+      {
+        _encoders[i].edgeTimestamp  = now;
+        _encoders[i].refTimestamp   = now;
+      }
+
+      _callbackNo = timer.addCallback(sampleISR, this, divisor);
+
+      return (_callbackNo >= 0);
+    }
+
+    ////////////////////////////////////////
+
+    void end()
+    {
+      if (_callbackNo >= 0)
+      {
+        _timer->removeCallback(_callbackNo);
+        _callbackNo = -1;
+      }
+    }
+
+    ////////////////////////////////////////
+
+    int32_t getPosition(const uint8_t& encoderNo)
+    {
+      return (encoderNo < _numEncoders) ? _encoders[encoderNo].position : 0;
+    }
+
+    ////////////////////////////////////////
+
+    void setPosition(const uint8_t& encoderNo, const int32_t& position)
+    {
+      if (encoderNo >= _numEncoders)
+        return;
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_encoderMux);
+
+      timer_encoder_t* encoder = &_encoders[encoderNo];
+
+      encoder->refPosition  += position - encoder->position;
+      encoder->edgePosition += position - encoder->position;
+      encoder->position     = position;
+
+      portEXIT_CRITICAL(&_encoderMux);
+    }
+
+    ////////////////////////////////////////
+
+    // Number of invalid transitions (missed states) since addEncoder()
+    uint32_t getErrors(const uint8_t& encoderNo)
+    {
+      return (encoderNo < _numEncoders) ? _encoders[encoderNo].errors : 0;
+    }
+
+    ////////////////////////////////////////
+
+    // Velocity in counts / s, from the timestamps of the edges since the previous call. Without any new edge, the
+    // velocity decays as 1 count / time since the last edge, down to 0 after ENCODER_VELOCITY_TIMEOUT_US.
+    // Must not be called from ISR
+    float getVelocity(const uint8_t& encoderNo)
+    {
+      if (encoderNo >= _numEncoders)
+        return 0.0f;
+
+      timer_encoder_t* encoder = &_encoders[encoderNo];
+
+      portENTER_CRITICAL(&_encoderMux);
+
+      uint64_t  edgeTimestamp = encoder->edgeTimestamp;
+      int32_t   edgePosition  = encoder->edgePosition;
+
+      portEXIT_CRITICAL(&_encoderMux);
+
+      if ( (edgePosition != encoder->refPosition) && (edgeTimestamp > encoder->refTimestamp) )
+      {
+        // edge to edge timing: exact counts over the exact time they took
+        encoder->velocity     = ( (float) (edgePosition - encoder->refPosition) * TIMER_SCALE ) /
+                                (float) (edgeTimestamp - encoder->refTimestamp);
+        encoder->refPosition  = edgePosition;
+        encoder->refTimestamp = edgeTimestamp;
+      }
+      else
+      {
+        // no new edge: the velocity is at most 1 count since the last edge
+        uint64_t sinceEdge = _timer->getTimestamp() - edgeTimestamp;
+
+        if (sinceEdge > (uint64_t) ENCODER_VELOCITY_TIMEOUT_US * (TIMER_SCALE / 1000000))
+        {
+          encoder->velocity = 0.0f;
+        }
+        else if (sinceEdge > 0)
+        {
+          float maxVelocity = (float) TIMER_SCALE / (float) sinceEdge;
+
+          if (encoder->velocity > maxVelocity)
+            encoder->velocity = maxVelocity;
+          else if (encoder->velocity < -maxVelocity)
+            encoder->velocity = -maxVelocity;
+        }
+      }
+
+      return encoder->velocity;
+    }
+
+    ////////////////////////////////////////
+
+    uint8_t getNumEncoders()
+    {
+      return _numEncoders;
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    ////////////////////////////////////////
+
+    // Chained callback of the timer: one GPIO read for all encoders, then one table lookup each
+    static bool IRAM_ATTR sampleISR(void * arg)
+    {
+      ESP32_TimerEncoder* decoder = (ESP32_TimerEncoder*) arg;
+
+      uint64_t  pins      = ( (uint64_t) GPIO.in1.val << 32 ) | GPIO.in;
+      uint64_t  now       = 0;
+
+      portENTER_CRITICAL_ISR(&decoder->_encoderMux);
+
+      for (uint8_t i = 0; i < decoder->_numEncoders; i++)
+      {
+        timer_encoder_t* encoder = &decoder->_encoders[i];
+
+        uint8_t state     = ( ( (pins >> encoder->pinA) & 1 ) << 1 ) | ( (pins >> encoder->pinB) & 1 );
+        uint8_t index     = (encoder->state << 2) | state;
+        int32_t delta     = (int32_t) ( (ENCODER_TRANSITION_TABLE >> (index << 1)) & 3 ) - 1;
+
+        encoder->state    = state;
+
+        if (delta == 0)
+        {
+          if ( (ENCODER_INVALID_TRANSITIONS >> index) & 1 )
+            encoder->errors++;
+
+          continue;
+        }
+
+        encoder->position += encoder->reverse ? -delta : delta;
+
+        // one timestamp per tick, only if an edge is seen
+        if (now == 0)
+          now = decoder->_timer->getTimestamp();
+
+        encoder->edgeTimestamp  = now;
+        encoder->edgePosition   = encoder->position;
+      }
+
+      portEXIT_CRITICAL_ISR(&decoder->_encoderMux);
+
+      return false;
+    }
+
+    ////////////////////////////////////////
+
+    ESP32TimerInterrupt*  _timer;
+    timer_encoder_t       _encoders[MAX_TIMER_ENCODERS];
+    uint8_t               _numEncoders;
+    int8_t                _callbackNo;          // entry in the timer chained callbacks, -1 if not started
+
+    // ESP32 is a multi core / multi processing chip. Protects the encoder states against the ISR on the other core
+    portMUX_TYPE          _encoderMux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif    // TIMER_ENCODER_GENERIC_H
@@ -76,6 +76,15 @@
 
 ////////////////////////////////////////
 
+// Opt-in IRAM mode: the timer interrupt is allocated with ESP_INTR_FLAG_IRAM, so it keeps firing while the flash cache
+// is disabled (OTA, NVS, SPIFFS / LittleFS writes). The whole dispatch path, including all your callbacks and the data
+// they touch, must then be in IRAM / DRAM (IRAM_ATTR, DRAM_ATTR). Can't use Serial, millis(), digitalWrite(), etc.
+#ifndef USING_ESP32_S2_TIMER_IRAM
+  #define USING_ESP32_S2_TIMER_IRAM       false
+#endif
+
+////////////////////////////////////////
+
 #if defined(ARDUINO)
   #if ARDUINO >= 100
     #include <Arduino.h>
@@ -87,6 +96,36 @@
 #include "TimerInterrupt_Generic_Debug.h"
 
 #include <driver/timer.h>
+#include <esp_intr_alloc.h>
+
+#if defined(__XTENSA__)
+  // Xthal_intlevel[], the level of each CPU interrupt
+  #include <xtensa/hal.h>
+#endif
+
+////////////////////////////////////////
+
+#if USING_ESP32_S2_TIMER_IRAM
+
+  // Build-time checks of the IRAM mode. The timer driver ISR and its *_in_isr() helpers are IRAM-resident
+  #if ( defined(CONFIG_FREERTOS_PLACE_FUNCTIONS_INTO_FLASH) && CONFIG_FREERTOS_PLACE_FUNCTIONS_INTO_FLASH )
+    #error USING_ESP32_S2_TIMER_IRAM needs FreeRTOS critical sections in IRAM. Disable CONFIG_FREERTOS_PLACE_FUNCTIONS_INTO_FLASH
+  #endif
+
+  #if ( defined(CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY) && CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY )
+    #warning USING_ESP32_S2_TIMER_IRAM : timer objects placed in PSRAM (EXT_RAM_ATTR) are not accessible during flash operations
+  #endif
+
+  #if ( defined(ESP_IDF_VERSION_MAJOR) && (ESP_IDF_VERSION_MAJOR >= 5) )
+    #include <esp_memory_utils.h>
+  #else
+    #include <soc/soc_memory_layout.h>
+  #endif
+
+  #define ESP32_S2_TIMER_INTR_FLAGS       ESP_INTR_FLAG_IRAM
+#else
+  #define ESP32_S2_TIMER_INTR_FLAGS       0
+#endif
 
 ////////////////////////////////////////
 
@@ -211,6 +250,13 @@ typedef ESP32TimerInterrupt ESP32Timer;
 
 #define MAX_ESP32_NUM_TIMERS      4
 
+// Interrupt levels usable with C handlers. Levels 4+ (high-priority interrupts) need assembly handlers on Xtensa
+#define ESP32_S2_TIMER_DEFAULT_INTR_LEVEL   0       // let the allocator choose, from level 1 to 3
+#define ESP32_S2_TIMER_MAX_INTR_LEVEL       3
+
+// Core affinity of the timer interrupt
+#define ESP32_S2_TIMER_ANY_CORE             -1      // the core calling setFrequency()
+
 #define TIMER_DIVIDER             80                                //  Hardware timer clock divider
 // TIMER_BASE_CLK = APB_CLK_FREQ = Frequency of the clock on the input of the timer groups
 #define TIMER_SCALE               (TIMER_BASE_CLK / TIMER_DIVIDER)  // convert counter value to seconds
@@ -221,6 +267,7 @@ typedef ESP32TimerInterrupt ESP32Timer;
 // typedef bool (*timer_isr_t)(void *);
 //esp_err_t timer_isr_callback_add(timer_group_t group_num, timer_idx_t timer_num, timer_isr_t isr_handler, void *arg, int intr_alloc_flags);
 //esp_err_t timer_isr_callback_remove(timer_group_t group_num, timer_idx_t timer_num);
+//esp_err_t timer_isr_register(timer_group_t group_num, timer_idx_t timer_num, void (*fn)(void*), void * arg, int intr_alloc_flags, timer_isr_handle_t *handle);
 //timer_deinit(timer_group_t group_num, timer_idx_t timer_num);
 //esp_err_t timer_group_intr_enable(timer_group_t group_num, timer_intr_t intr_mask);
 //esp_err_t timer_group_intr_disable(timer_group_t group_num, timer_intr_t intr_mask);
@@ -231,6 +278,80 @@ typedef bool (*esp32_timer_callback)  (void *);
 
 ////////////////////////////////////////
 
+// Callbacks chained on one hardware timer with addCallback(), each run every divisor-th tick
+#ifndef MAX_ESP32_TIMER_CALLBACKS
+  #define MAX_ESP32_TIMER_CALLBACKS     8
+#endif
+
+typedef struct
+{
+  esp32_timer_callback  callback;           // NULL if the entry is free
+  void*                 context;            // argument passed to callback
+  uint32_t              divisor;            // run every divisor-th tick
+  uint32_t              countdown;          // ticks left before the next run
+} timer_callback_t;
+
+////////////////////////////////////////
+
+// Task notifications bound to one hardware timer with addTaskNotify(), each sent every divisor-th tick.
+// All the notifications of one tick are coalesced (bits OR-ed per task), and yield only once at the end of the ISR
+#ifndef MAX_ESP32_TIMER_NOTIFY
+  #define MAX_ESP32_TIMER_NOTIFY        4
+#endif
+
+// Number of different tasks queued for notification at once, by notifyFromISR(). More tasks due at the same tick are
+// notified in further batches
+#ifndef MAX_ESP32_TIMER_NOTIFY_PENDING
+  #define MAX_ESP32_TIMER_NOTIFY_PENDING  4
+#endif
+
+typedef struct
+{
+  TaskHandle_t          task;               // NULL if the entry is free
+  uint32_t              bits;               // notification value bits, set with eSetBits
+  uint32_t              divisor;            // sent every divisor-th tick
+  uint32_t              countdown;          // ticks left before the next notification
+  bool                  due;                // due at this tick, not queued yet
+} timer_notify_t;
+
+////////////////////////////////////////
+
+// Interrupt entry latency, measured as the counter value at timerISR() entry, i.e. counts since the alarm.
+// With the default TIMER_DIVIDER, 1 count = 1us
+typedef struct
+{
+  uint32_t              lead;               // calibrated lead: alarms are scheduled this many counts early
+  uint32_t              numSamples;         // number of measured fires
+  uint32_t              minLatency;         // entry latency after the alarm
+  uint32_t              maxLatency;
+  uint32_t              meanLatency;
+  int32_t               lastError;          // residual error of the last fire vs the programmed time, = latency - lead
+} timer_latency_t;
+
+// Default number of fires measured by calibrateLatency()
+#ifndef ESP32_S2_TIMER_CALIBRATION_SAMPLES
+  #define ESP32_S2_TIMER_CALIBRATION_SAMPLES    64
+#endif
+
+////////////////////////////////////////
+
+// Dispatch time histogram: bucket k counts the dispatches of 2^k to 2^(k+1) - 1 CPU cycles
+#define ESP32_S2_TIMER_UTIL_BUCKETS           32
+
+// CPU time spent in timerISR(), from its entry to its return, i.e. the user callback, the chained callbacks and the
+// task notifications. The interrupt entry / exit of the driver is not included, see timer_latency_t
+typedef struct
+{
+  uint32_t              numSamples;         // measured dispatches
+  uint32_t              utilization;        // share of one core in the last complete window, in 1/100 %
+  uint32_t              meanCycles;         // CPU cycles per dispatch
+  uint32_t              peakCycles;
+  uint32_t              lastCycles;
+  uint32_t              histogram[ESP32_S2_TIMER_UTIL_BUCKETS];
+} timer_utilization_t;
+
+////////////////////////////////////////
+
 typedef struct
 {
   timer_idx_t         timer_idx;
@@ -273,176 +394,1424 @@ class ESP32TimerInterrupt
 
     uint8_t           _timerNo;
 
+    uint8_t           _intrLevel;           // requested interrupt level, ESP32_S2_TIMER_DEFAULT_INTR_LEVEL = any
+    int8_t            _coreAffinity;        // requested core, ESP32_S2_TIMER_ANY_CORE = calling core
+    int8_t            _intrCore;            // core the interrupt is allocated on, -1 if not allocated
+    intr_handle_t     _intrHandle;          // handle of the allocated interrupt, NULL if not allocated
+    esp_err_t         _intrResult;          // result of the last interrupt allocation
+    SemaphoreHandle_t _allocDone;           // signals the end of an allocation on another core
+
     esp32_timer_callback _callback;         // pointer to the callback function
 
+    timer_callback_t  _callbacks[MAX_ESP32_TIMER_CALLBACKS];
+    volatile uint8_t  _numCallbackSlots;    // entries 0 to _numCallbackSlots - 1 are scanned by timerISR
+
+    timer_notify_t    _notifies[MAX_ESP32_TIMER_NOTIFY];
+    volatile uint8_t  _numNotifySlots;      // entries 0 to _numNotifySlots - 1 are scanned by timerISR
+
+    // notifications of the current tick, only used in timerISR context
+    TaskHandle_t      _pendingTask[MAX_ESP32_TIMER_NOTIFY_PENDING];
+    uint32_t          _pendingBits[MAX_ESP32_TIMER_NOTIFY_PENDING];
+    uint8_t           _numPending;
+    BaseType_t        _notifyWoken;
+
+    // ESP32 is a multi core / multi processing chip. Protects _callbacks and the latency compensation state against
+    // the ISR running on the other core
+    portMUX_TYPE      _timerMux = portMUX_INITIALIZER_UNLOCKED;
+
     float             TIM_CLOCK_FREQ;       // Timer Clock
     float             _frequency;           // Timer frequency
     uint64_t          _timerCount;          // count to activate timer
 
+    // The counter is auto-reloaded to 0 at each alarm. The 64-bit timestamp is rebuilt from the counts of all
+    // completed periods plus the current counter value
+    volatile uint64_t _baseCount;           // counts of all completed periods
+    volatile uint64_t _alarmCount;          // alarm value of the current period
+
+    // Latency compensation. The periods stay _timerCount long, only the phase is moved by shortening one period
+    volatile uint32_t _latencyLead;         // calibrated lead, in counts. 0 => no compensation
+    volatile int32_t  _pendingShift;        // counts to remove from the next period, negative to add
+    volatile bool     _latencyTracking;     // measure the entry latency in timerISR()
+    volatile uint32_t _latencyNum;
+    volatile uint32_t _latencySum;
+    volatile uint32_t _latencyMin;
+    volatile uint32_t _latencyMax;
+    volatile uint32_t _latencyLast;
+
+    // NCO mode, attachInterruptExact(). Periods alternate between _timerCount and _timerCount + 1 counts: the phase
+    // accumulator gains _ncoIncrement / 2^32 count per period, and a carry lengthens the period by one count
+    volatile bool     _ncoEnabled;
+    uint32_t          _ncoPhase;            // fractional count accumulator, only used in timerISR context
+    uint32_t          _ncoIncrement;
+    volatile bool     _ncoPending;          // retune requested by changeFrequencyExact(), applied by the next alarm
+    uint64_t          _ncoPendingCount;
+    uint32_t          _ncoPendingIncrement;
+
+    // Utilization meter, in CPU cycles of the core running timerISR()
+    volatile bool     _utilTracking;        // measure the dispatch time in timerISR()
+    uint32_t          _utilCpuMhz;
+    uint32_t          _utilWindowCycles;    // length of the utilization window
+    uint32_t          _utilWindowStart;
+    uint32_t          _utilBusy;            // cycles spent in timerISR() in the current window
+    volatile uint32_t _utilization;         // of the last complete window, in 1/100 %
+    volatile uint32_t _utilNum;
+    volatile uint64_t _utilSum;
+    volatile uint32_t _utilPeak;
+    volatile uint32_t _utilLast;
+    uint32_t          _utilHistogram[ESP32_S2_TIMER_UTIL_BUCKETS];
+
     //xQueueHandle      s_timer_queue;
 
-  public:
+    ////////////////////////////////////////
+
+    // Registered with timer_isr_register(), which, unlike timer_isr_callback_add(), returns the interrupt handle.
+    // Does what the driver ISR of timer_isr_callback_add() does: checks and clears the interrupt of this timer, and
+    // re-enables the alarm, which the hardware disables at each alarm
+    static void IRAM_ATTR rawISR(void * arg)
+    {
+      ESP32TimerInterrupt* timer = (ESP32TimerInterrupt*) arg;
+
+      uint32_t intrMask = (timer->_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1;
+
+      if ( (timer_group_get_intr_status_in_isr(timer->_timerGroup) & intrMask) == 0 )
+        return;
+
+      timer_group_clr_intr_status_in_isr(timer->_timerGroup, timer->_timerIndex);
+
+      bool yield = timerISR(arg);
+
+      timer_group_enable_alarm_in_isr(timer->_timerGroup, timer->_timerIndex);
+
+      if (yield)
+        portYIELD_FROM_ISR();
+    }
 
     ////////////////////////////////////////
 
-    ESP32TimerInterrupt(const uint8_t& timerNo)
+    // Brackets dispatchISR() with cycle counter reads when the utilization meter is on
+    static bool IRAM_ATTR timerISR(void * arg)
     {
-      _callback = NULL;
+      ESP32TimerInterrupt* timer = (ESP32TimerInterrupt*) arg;
 
-      if (timerNo < MAX_ESP32_NUM_TIMERS)
+      if (!timer->_utilTracking)
+        return dispatchISR(timer);
+
+      uint32_t startCycles  = TISR_GET_CYCLE_COUNT();
+      bool     yield        = dispatchISR(timer);
+      uint32_t endCycles    = TISR_GET_CYCLE_COUNT();
+
+      timer->recordUtilization(startCycles, endCycles);
+
+      return yield;
+    }
+
+    ////////////////////////////////////////
+
+    // Keeps the timestamp base, then calls the user callback with the same (void *) timerNo argument as before,
+    // then the chained callbacks due at this tick
+    static bool IRAM_ATTR dispatchISR(ESP32TimerInterrupt* timer)
+    {
+      bool yield = false;
+
+      if (timer->_latencyTracking)
+        timer->recordLatency();
+
+      timer->_baseCount += timer->_alarmCount;
+
+      // fractional period, N or N + 1 counts
+      if (timer->_ncoEnabled)
       {
-        _timerNo  = timerNo;
+        timer->advanceNCOInISR();
+      }
+      // phase shift requested by calibrateLatency(), or back to the normal period after it
+      else if (timer->_pendingShift)
+      {
+        portENTER_CRITICAL_ISR(&timer->_timerMux);
 
-        _timerIndex = (timer_idx_t)   (_timerNo % TIMER_MAX);
+        timer->setNextAlarmInISR(timer->_timerCount - timer->_pendingShift);
+        timer->_pendingShift = 0;
 
-        _timerGroup = (timer_group_t) (_timerNo / TIMER_MAX);
+        portEXIT_CRITICAL_ISR(&timer->_timerMux);
       }
-      else
+      else if (timer->_alarmCount != timer->_timerCount)
       {
-        _timerNo  = MAX_ESP32_NUM_TIMERS;
+        timer->setNextAlarmInISR(timer->_timerCount);
       }
-    };
 
-    ////////////////////////////////////////
+      if (timer->_callback)
+        yield = timer->_callback((void *) (uint32_t) timer->_timerNo);
 
-    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
-    bool setFrequency(const float& frequency, esp32_timer_callback callback)
-    {
-      if (_timerNo < MAX_ESP32_NUM_TIMERS)
+      if ( (timer->_numCallbackSlots == 0) && (timer->_numNotifySlots == 0) && (timer->_numPending == 0) )
+        return yield;
+
+      // the due entries are only collected under the lock. The callbacks and the notifications run without it, so
+      // that they can take their own locks, or notify and yield
+      esp32_timer_callback  dueCallback[MAX_ESP32_TIMER_CALLBACKS];
+      void*                 dueContext[MAX_ESP32_TIMER_CALLBACKS];
+      uint8_t               numDue    = 0;
+      bool                  notifyDue = false;
+
+      portENTER_CRITICAL_ISR(&timer->_timerMux);
+
+      for (uint8_t i = 0; i < timer->_numCallbackSlots; i++)
       {
-        // select timer frequency is 1MHz for better accuracy. We don't use 16-bit prescaler for now.
-        // Will use later if very low frequency is needed.
-        _frequency = frequency;
-        TIM_CLOCK_FREQ  = TIMER_BASE_CLK / TIMER_DIVIDER;   //1000000;
-        _timerCount = (uint64_t) TIM_CLOCK_FREQ / frequency;
-        // count up
+        timer_callback_t* entry = &timer->_callbacks[i];
+
+        if ( entry->callback && (--entry->countdown == 0) )
+        {
+          entry->countdown      = entry->divisor;
+          dueCallback[numDue]   = entry->callback;
+          dueContext[numDue]    = entry->context;
+          numDue++;
+        }
+      }
 
-        TISR_LOGWARN3(F("ESP32_S2_TimerInterrupt: _timerNo = "), _timerNo, F(", TIM_CLOCK_FREQ = "), TIM_CLOCK_FREQ);
-        TISR_LOGWARN3(F("TIMER_BASE_CLK = "), TIMER_BASE_CLK, F(", TIMER_DIVIDER = "), TIMER_DIVIDER);
-        TISR_LOGWARN3(F("_timerIndex = "), _timerIndex, F(", _timerGroup = "), _timerGroup);
-        TISR_LOGWARN5(F("Timer freq = "), _frequency, F(", _count = "), (uint32_t) (_timerCount >> 32), F("-"),
-                      (uint32_t) (_timerCount));
-        TISR_LOGWARN1(F("timer_set_alarm_value = "), TIMER_SCALE / frequency);
+      for (uint8_t i = 0; i < timer->_numNotifySlots; i++)
+      {
+        timer_notify_t* entry = &timer->_notifies[i];
+
+        if ( entry->task && (--entry->countdown == 0) )
+        {
+          entry->countdown  = entry->divisor;
+          entry->due        = true;
+          notifyDue         = true;
+        }
+      }
 
-        timer_init(_timerGroup, _timerIndex, &stdConfig);
+      portEXIT_CRITICAL_ISR(&timer->_timerMux);
 
-        // Counter value to 0 => counting up to alarm value as .counter_dir == TIMER_COUNT_UP
-        timer_set_counter_value(_timerGroup, _timerIndex, 0x00000000ULL);
+      for (uint8_t i = 0; i < numDue; i++)
+      {
+        if (dueCallback[i](dueContext[i]))
+          yield = true;
+      }
 
-        timer_set_alarm_value(_timerGroup, _timerIndex, TIMER_SCALE / frequency);
+      // one notification per task, and only one yield request for all of them. The entries due at this tick are
+      // added to the notifications queued by the callbacks, in batches of MAX_ESP32_TIMER_NOTIFY_PENDING tasks
+      do
+      {
+        if (notifyDue)
+        {
+          notifyDue = false;
 
-        // enable interrupts for _timerGroup, _timerIndex
-        timer_enable_intr(_timerGroup, _timerIndex);
+          portENTER_CRITICAL_ISR(&timer->_timerMux);
 
-        _callback = callback;
+          for (uint8_t i = 0; i < timer->_numNotifySlots; i++)
+          {
+            timer_notify_t* entry = &timer->_notifies[i];
 
-        // Register the ISR handler
-        // If the intr_alloc_flags value ESP_INTR_FLAG_IRAM is set, the handler function must be declared with IRAM_ATTR attribute
-        // and can only call functions in IRAM or ROM. It cannot call other timer APIs.
-        //timer_isr_register(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, ESP_INTR_FLAG_IRAM, NULL);
-        timer_isr_callback_add(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, 0);
+            if (!entry->due)
+              continue;
 
-        timer_start(_timerGroup, _timerIndex);
+            // removed meanwhile, or the next batch
+            if ( entry->task && !timer->notifyFromISR(entry->task, entry->bits) )
+            {
+              notifyDue = true;
 
-        return true;
-      }
-      else
+              continue;
+            }
+
+            entry->due = false;
+          }
+
+          portEXIT_CRITICAL_ISR(&timer->_timerMux);
+        }
+
+        for (uint8_t i = 0; i < timer->_numPending; i++)
+        {
+          xTaskNotifyFromISR(timer->_pendingTask[i], timer->_pendingBits[i], eSetBits, &timer->_notifyWoken);
+        }
+
+        timer->_numPending = 0;
+      } while (notifyDue);
+
+      if (timer->_notifyWoken == pdTRUE)
       {
-        TISR_LOGERROR(F("Error. Timer must be 0-3"));
+        timer->_notifyWoken = pdFALSE;
 
-        return false;
+        yield = true;
       }
+
+      return yield;
     }
 
+
     ////////////////////////////////////////
 
-    // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
-    bool setInterval(const unsigned long& interval, esp32_timer_callback callback)
+    // The counter was auto-reloaded to 0 at the alarm, so it's now the entry latency
+    void IRAM_ATTR recordLatency()
     {
-      return setFrequency((float) (1000000.0f / interval), callback);
+      uint64_t count    = getCounter();
+      uint32_t latency  = (count > 0xFFFFFFFFULL) ? 0xFFFFFFFFUL : (uint32_t) count;
+
+      portENTER_CRITICAL_ISR(&_timerMux);
+
+      _latencyLast = latency;
+      _latencySum += latency;
+
+      if ( (_latencyNum == 0) || (latency < _latencyMin) )
+        _latencyMin = latency;
+
+      if (latency > _latencyMax)
+        _latencyMax = latency;
+
+      _latencyNum++;
+
+      portEXIT_CRITICAL_ISR(&_timerMux);
     }
 
     ////////////////////////////////////////
 
-    bool attachInterrupt(const float& frequency, esp32_timer_callback callback)
+    // Programs the period started by this alarm. The auto-reload already restarted the counter, so the alarm value
+    // is the length of the current period
+    void IRAM_ATTR advanceNCOInISR()
     {
-      return setFrequency(frequency, callback);
+      int32_t shift = 0;
+
+      if (_ncoPending || _pendingShift)
+      {
+        portENTER_CRITICAL_ISR(&_timerMux);
+
+        // glitch-free retune: the new rate starts at a period boundary, and the phase accumulator is kept
+        if (_ncoPending)
+        {
+          _timerCount   = _ncoPendingCount;
+          _ncoIncrement = _ncoPendingIncrement;
+          _ncoPending   = false;
+        }
+
+        shift         = _pendingShift;
+        _pendingShift = 0;
+
+        portEXIT_CRITICAL_ISR(&_timerMux);
+      }
+
+      uint32_t phase      = _ncoPhase + _ncoIncrement;
+      uint64_t alarmCount = _timerCount + ( (phase < _ncoPhase) ? 1 : 0 ) - shift;
+
+      _ncoPhase = phase;
+
+      if (alarmCount != _alarmCount)
+        setNextAlarmInISR(alarmCount);
     }
 
     ////////////////////////////////////////
 
-    // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
-    bool attachInterruptInterval(const unsigned long& interval, esp32_timer_callback callback)
+    // Splits the period of 'frequency' into whole counts and a 32-bit binary fraction of count. In double, as a float
+    // has less than 24 significant bits
+    bool computeNCO(const double& frequency, uint64_t& count, uint32_t& increment)
     {
-      return setFrequency( (float) ( 1000000.0f / interval), callback);
+      if ( !(frequency > 0) )
+        return false;
+
+      double counts = (double) TIMER_SCALE / frequency;
+
+      // N + 1 must stay far enough from the alarm of the latency compensation
+      if ( (counts < 2.0) || (counts >= 18446744073709551615.0) || (_latencyLead >= ( (uint64_t) counts >> 1) ) )
+        return false;
+
+      count = (uint64_t) counts;
+
+      double fraction = (counts - (double) count) * 4294967296.0 + 0.5;
+
+      // rounded up to a whole count
+      if (fraction >= 4294967296.0)
+      {
+        count++;
+        increment = 0;
+      }
+      else
+        increment = (uint32_t) fraction;
+
+      return true;
     }
 
     ////////////////////////////////////////
 
-    void detachInterrupt()
+    void IRAM_ATTR recordUtilization(const uint32_t& startCycles, const uint32_t& endCycles)
     {
-      timer_group_intr_disable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+      uint32_t cycles = endCycles - startCycles;
+      uint8_t  bucket = (cycles > 1) ? (31 - __builtin_clz(cycles)) : 0;
+
+      portENTER_CRITICAL_ISR(&_timerMux);
+
+      // the first dispatch opens the window
+      if (_utilNum == 0)
+        _utilWindowStart = startCycles;
+
+      _utilLast = cycles;
+      _utilSum += cycles;
+      _utilBusy += cycles;
+      _utilHistogram[bucket]++;
+
+      if (cycles > _utilPeak)
+        _utilPeak = cycles;
+
+      _utilNum++;
+
+      // closed at the first dispatch after windowMs, so the window is never shorter
+      uint32_t elapsed = endCycles - _utilWindowStart;
+
+      if (elapsed >= _utilWindowCycles)
+      {
+        _utilization      = (uint32_t) ( ( (uint64_t) _utilBusy * 10000 ) / elapsed );
+        _utilBusy         = 0;
+        _utilWindowStart  = endCycles;
+      }
+
+      portEXIT_CRITICAL_ISR(&_timerMux);
     }
 
     ////////////////////////////////////////
 
-    void disableTimer()
+    void resetUtilizationStats()
     {
-      timer_group_intr_disable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+      portENTER_CRITICAL(&_timerMux);
+
+      _utilBusy     = 0;
+      _utilization  = 0;
+      _utilNum      = 0;
+      _utilSum      = 0;
+      _utilPeak     = 0;
+      _utilLast     = 0;
+
+      memset(_utilHistogram, 0, sizeof(_utilHistogram));
+
+      portEXIT_CRITICAL(&_timerMux);
     }
 
     ////////////////////////////////////////
 
-    // Duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    void reattachInterrupt()
+    void resetLatencyStats()
     {
-      timer_group_intr_enable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+      portENTER_CRITICAL(&_timerMux);
+
+      _latencyNum   = 0;
+      _latencySum   = 0;
+      _latencyMin   = 0;
+      _latencyMax   = 0;
+      _latencyLast  = 0;
+
+      portEXIT_CRITICAL(&_timerMux);
     }
 
     ////////////////////////////////////////
 
-    // Duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    void enableTimer()
+    // The interrupt is allocated on the core calling timer_isr_register()
+    esp_err_t allocateInterrupt()
     {
-      timer_group_intr_enable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+      int intrFlags = ESP32_S2_TIMER_INTR_FLAGS;
+
+      if (_intrLevel != ESP32_S2_TIMER_DEFAULT_INTR_LEVEL)
+        intrFlags |= (ESP_INTR_FLAG_LEVEL1 << (_intrLevel - 1));
+
+      _intrResult = timer_isr_register(_timerGroup, _timerIndex, rawISR, (void *) this, intrFlags, &_intrHandle);
+
+      if (_intrResult != ESP_OK)
+        _intrHandle = NULL;
+
+      _intrCore   = _intrHandle ? esp_intr_get_cpu(_intrHandle) : -1;
+
+      return _intrResult;
     }
 
     ////////////////////////////////////////
 
-    // Just stop clock source, clear the count
-    void stopTimer()
+    void freeInterrupt()
     {
-      timer_pause(_timerGroup, _timerIndex);
+      if (_intrHandle)
+      {
+        esp_intr_free(_intrHandle);
+
+        _intrHandle = NULL;
+        _intrCore   = -1;
+      }
     }
 
     ////////////////////////////////////////
 
-    // Just reconnect clock source, start current count from 0
-    void restartTimer()
+    // Short-lived task pinned to _coreAffinity, doing the allocation there. Never used on the single core ESP32-S2,
+    // where _coreAffinity can only be 0 or ESP32_S2_TIMER_ANY_CORE
+    static void allocateInterruptTask(void * arg)
     {
-      timer_set_counter_value(_timerGroup, _timerIndex, 0x00000000ULL);
-      timer_start(_timerGroup, _timerIndex);
+      ESP32TimerInterrupt* timer = (ESP32TimerInterrupt*) arg;
+
+      timer->allocateInterrupt();
+
+      xSemaphoreGive(timer->_allocDone);
+
+      vTaskDelete(NULL);
     }
 
     ////////////////////////////////////////
 
-    int8_t getTimer() __attribute__((always_inline))
+    esp_err_t allocateInterruptOnCore()
     {
-      return _timerIndex;
-    };
+      if ( (_coreAffinity == ESP32_S2_TIMER_ANY_CORE) || (_coreAffinity == xPortGetCoreID()) )
+        return allocateInterrupt();
+
+      _allocDone = xSemaphoreCreateBinary();
+
+      if ( (_allocDone == NULL) || (xTaskCreatePinnedToCore(allocateInterruptTask, "TimerIntrAlloc", 2048, this,
+                                                            configMAX_PRIORITIES - 1, NULL, _coreAffinity) != pdPASS) )
+      {
+        if (_allocDone)
+          vSemaphoreDelete(_allocDone);
+
+        _intrResult = ESP_ERR_NO_MEM;
+
+        return _intrResult;
+      }
+
+      xSemaphoreTake(_allocDone, portMAX_DELAY);
+      vSemaphoreDelete(_allocDone);
+
+      return _intrResult;
+    }
+
+  public:
 
     ////////////////////////////////////////
 
-    int8_t getTimerGroup() __attribute__((always_inline))
+    // intrLevel  : interrupt level, 1 to ESP32_S2_TIMER_MAX_INTR_LEVEL, or ESP32_S2_TIMER_DEFAULT_INTR_LEVEL
+    // core       : core to run the timer interrupt on, or ESP32_S2_TIMER_ANY_CORE for the core calling setFrequency()
+    // Both are validated by setFrequency()
+    ESP32TimerInterrupt(const uint8_t& timerNo, const uint8_t& intrLevel = ESP32_S2_TIMER_DEFAULT_INTR_LEVEL,
+                        const int8_t& core = ESP32_S2_TIMER_ANY_CORE)
     {
-      return _timerGroup;
+      _callback     = NULL;
+      _baseCount    = 0;
+      _alarmCount   = 0;
+
+      memset(_callbacks, 0, sizeof(_callbacks));
+      _numCallbackSlots = 0;
+
+      memset(_notifies, 0, sizeof(_notifies));
+      _numNotifySlots   = 0;
+      _numPending       = 0;
+      _notifyWoken      = pdFALSE;
+
+      _intrLevel    = intrLevel;
+      _coreAffinity = core;
+      _intrCore     = -1;
+      _intrHandle   = NULL;
+      _intrResult   = ESP_OK;
+      _allocDone    = NULL;
+
+      _latencyLead      = 0;
+      _pendingShift     = 0;
+      _latencyTracking  = false;
+      _latencyNum       = 0;
+      _latencySum       = 0;
+      _latencyMin       = 0;
+      _latencyMax       = 0;
+      _latencyLast      = 0;
+
+      _ncoEnabled           = false;
+      _ncoPhase             = 0;
+      _ncoIncrement         = 0;
+      _ncoPending           = false;
+      _ncoPendingCount      = 0;
+      _ncoPendingIncrement  = 0;
+
+      _utilTracking     = false;
+      _utilCpuMhz       = 0;
+      _utilWindowCycles = 0;
+      _utilWindowStart  = 0;
+      _utilBusy         = 0;
+      _utilization      = 0;
+      _utilNum          = 0;
+      _utilSum          = 0;
+      _utilPeak         = 0;
+      _utilLast         = 0;
+
+      memset(_utilHistogram, 0, sizeof(_utilHistogram));
+
+      if (timerNo < MAX_ESP32_NUM_TIMERS)
+      {
+        _timerNo  = timerNo;
+
+        _timerIndex = (timer_idx_t)   (_timerNo % TIMER_MAX);
+
+        _timerGroup = (timer_group_t) (_timerNo / TIMER_MAX);
+      }
+      else
+      {
+        _timerNo  = MAX_ESP32_NUM_TIMERS;
+      }
     };
 
     ////////////////////////////////////////
 
+    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    bool setFrequency(const float& frequency, esp32_timer_callback callback)
+    {
+      if ( (_intrLevel > ESP32_S2_TIMER_MAX_INTR_LEVEL) ||
+           (_coreAffinity < ESP32_S2_TIMER_ANY_CORE) || (_coreAffinity >= portNUM_PROCESSORS) )
+      {
+        TISR_LOGERROR3(F("Error. Invalid interrupt level = "), _intrLevel, F(" or core = "), _coreAffinity);
+
+        return false;
+      }
+
+      // integer period, until attachInterruptExact() enables the NCO again
+      _ncoEnabled = false;
+      _ncoPending = false;
+
+      if (_timerNo < MAX_ESP32_NUM_TIMERS)
+      {
+        // select timer frequency is 1MHz for better accuracy. We don't use 16-bit prescaler for now.
+        // Will use later if very low frequency is needed.
+        _frequency = frequency;
+        TIM_CLOCK_FREQ  = TIMER_BASE_CLK / TIMER_DIVIDER;   //1000000;
+        _timerCount = (uint64_t) TIM_CLOCK_FREQ / frequency;
+        // count up
+
+        TISR_LOGWARN3(F("ESP32_S2_TimerInterrupt: _timerNo = "), _timerNo, F(", TIM_CLOCK_FREQ = "), TIM_CLOCK_FREQ);
+        TISR_LOGWARN3(F("TIMER_BASE_CLK = "), TIMER_BASE_CLK, F(", TIMER_DIVIDER = "), TIMER_DIVIDER);
+        TISR_LOGWARN3(F("_timerIndex = "), _timerIndex, F(", _timerGroup = "), _timerGroup);
+        TISR_LOGWARN5(F("Timer freq = "), _frequency, F(", _count = "), (uint32_t) (_timerCount >> 32), F("-"),
+                      (uint32_t) (_timerCount));
+        TISR_LOGWARN1(F("timer_set_alarm_value = "), TIMER_SCALE / frequency);
+
+#if USING_ESP32_S2_TIMER_IRAM
+
+        // Run-time checks of the IRAM mode: callback in IRAM, and this object in internal RAM
+        if ( ( callback && !esp_ptr_in_iram((const void *) callback) ) || !esp_ptr_internal((const void *) this) )
+        {
+          TISR_LOGERROR(F("Error. USING_ESP32_S2_TIMER_IRAM needs an IRAM_ATTR callback and a timer in internal RAM"));
+
+          return false;
+        }
+
+#endif
+
+        // Free the interrupt of a previous setFrequency() before allocating again, possibly on another level / core
+        freeInterrupt();
+
+        timer_init(_timerGroup, _timerIndex, &stdConfig);
+
+        // Counter value to 0 => counting up to alarm value as .counter_dir == TIMER_COUNT_UP
+        timer_set_counter_value(_timerGroup, _timerIndex, 0x00000000ULL);
+
+        if (_latencyLead >= (_timerCount >> 1))
+        {
+          TISR_LOGWARN1(F("Latency compensation dropped, too large for this period, lead = "), _latencyLead);
+
+          _latencyLead = 0;
+        }
+
+        // With latency compensation, the first period is shortened by the lead, then timerISR() restores _timerCount
+        _baseCount    = 0;
+        _alarmCount   = _timerCount - _latencyLead;
+        _pendingShift = 0;
+
+        timer_set_alarm_value(_timerGroup, _timerIndex, _alarmCount);
+
+        // enable interrupts for _timerGroup, _timerIndex
+        timer_enable_intr(_timerGroup, _timerIndex);
+
+        _callback = callback;
+
+        // Register the ISR handler
+        // If the intr_alloc_flags value ESP_INTR_FLAG_IRAM is set, the handler function must be declared with IRAM_ATTR attribute
+        // and can only call functions in IRAM or ROM. It cannot call other timer APIs.
+        //timer_isr_register(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, ESP_INTR_FLAG_IRAM, NULL);
+        // ESP_INTR_FLAG_IRAM is only used with USING_ESP32_S2_TIMER_IRAM
+        if (allocateInterruptOnCore() != ESP_OK)
+        {
+          TISR_LOGERROR3(F("Error. Can't allocate interrupt, level = "), _intrLevel, F(", err = "), _intrResult);
+
+          return false;
+        }
+
+        TISR_LOGWARN3(F("Interrupt level = "), getAllocatedInterruptLevel(), F(", core = "), _intrCore);
+
+        timer_start(_timerGroup, _timerIndex);
+
+        return true;
+      }
+      else
+      {
+        TISR_LOGERROR(F("Error. Timer must be 0-3"));
+
+        return false;
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Chains a callback on this timer, called with context every divisor-th tick, after the setFrequency() callback.
+    // The setFrequency() callback can be NULL if only chained callbacks are used.
+    // Returns the entry number to use with removeCallback(), or -1 if the list is full
+    int8_t addCallback(esp32_timer_callback callback, void* context = NULL, const uint32_t& divisor = 1)
+    {
+      if ( (callback == NULL) || (divisor == 0) )
+      {
+        TISR_LOGERROR(F("Error. Callback must not be NULL and divisor must be > 0"));
+
+        return -1;
+      }
+
+#if USING_ESP32_S2_TIMER_IRAM
+
+      if (!esp_ptr_in_iram((const void *) callback))
+      {
+        TISR_LOGERROR(F("Error. USING_ESP32_S2_TIMER_IRAM needs an IRAM_ATTR callback"));
+
+        return -1;
+      }
+
+#endif
+
+      int8_t entryNum = -1;
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_timerMux);
+
+      for (uint8_t i = 0; i < MAX_ESP32_TIMER_CALLBACKS; i++)
+      {
+        if (_callbacks[i].callback == NULL)
+        {
+          _callbacks[i].context   = context;
+          _callbacks[i].divisor   = divisor;
+          _callbacks[i].countdown = divisor;
+          _callbacks[i].callback  = callback;
+
+          if (i >= _numCallbackSlots)
+            _numCallbackSlots = i + 1;
+
+          entryNum = i;
+
+          break;
+        }
+      }
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      if (entryNum < 0)
+      {
+        TISR_LOGERROR1(F("Error. Max number of chained callbacks = "), MAX_ESP32_TIMER_CALLBACKS);
+      }
+
+      return entryNum;
+    }
+
+    ////////////////////////////////////////
+
+    // The callbacks are called out of the lock: one removed on another core while its tick is dispatched may still be
+    // called once
+    bool removeCallback(const uint8_t& entryNum)
+    {
+      if ( (entryNum >= MAX_ESP32_TIMER_CALLBACKS) || (_callbacks[entryNum].callback == NULL) )
+        return false;
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_timerMux);
+
+      _callbacks[entryNum].callback = NULL;
+
+      // Shorten the scanned range down to the last used entry
+      while ( (_numCallbackSlots > 0) && (_callbacks[_numCallbackSlots - 1].callback == NULL) )
+        _numCallbackSlots--;
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    uint8_t getNumCallbacks()
+    {
+      uint8_t numCallbacks = 0;
+
+      for (uint8_t i = 0; i < _numCallbackSlots; i++)
+      {
+        if (_callbacks[i].callback)
+          numCallbacks++;
+      }
+
+      return numCallbacks;
+    }
+
+    ////////////////////////////////////////
+
+    // Sets 'bits' in the notification value of 'task' (eSetBits) every divisor-th tick, directly from timerISR(),
+    // without callback. task = NULL for the calling task, which then waits with xTaskNotifyWait().
+    // Returns the entry number, or -1 if no free entry
+    int8_t addTaskNotify(TaskHandle_t task, const uint32_t& bits, const uint32_t& divisor = 1)
+    {
+      if (task == NULL)
+        task = xTaskGetCurrentTaskHandle();
+
+      if ( (bits == 0) || (divisor == 0) )
+      {
+        TISR_LOGERROR(F("Error. Notification bits and divisor must be > 0"));
+
+        return -1;
+      }
+
+      int8_t entryNum = -1;
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_timerMux);
+
+      for (uint8_t i = 0; i < MAX_ESP32_TIMER_NOTIFY; i++)
+      {
+        if (_notifies[i].task == NULL)
+        {
+          _notifies[i].bits       = bits;
+          _notifies[i].divisor    = divisor;
+          _notifies[i].countdown  = divisor;
+          _notifies[i].due        = false;
+          _notifies[i].task       = task;
+
+          if (i >= _numNotifySlots)
+            _numNotifySlots = i + 1;
+
+          entryNum = i;
+
+          break;
+        }
+      }
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      if (entryNum < 0)
+      {
+        TISR_LOGERROR1(F("Error. Max number of task notifications = "), MAX_ESP32_TIMER_NOTIFY);
+      }
+
+      return entryNum;
+    }
+
+    ////////////////////////////////////////
+
+    bool removeTaskNotify(const uint8_t& entryNum)
+    {
+      if ( (entryNum >= MAX_ESP32_TIMER_NOTIFY) || (_notifies[entryNum].task == NULL) )
+        return false;
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_timerMux);
+
+      _notifies[entryNum].task = NULL;
+
+      // Shorten the scanned range down to the last used entry
+      while ( (_numNotifySlots > 0) && (_notifies[_numNotifySlots - 1].task == NULL) )
+        _numNotifySlots--;
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Queues a notification (eSetBits) of 'task', sent at the end of timerISR(), out of any lock, coalesced with the
+    // other ones of this tick. Only from the callback or a chained callback of this timer, which then don't need to
+    // request a yield
+    // returns false, and queues nothing, if MAX_ESP32_TIMER_NOTIFY_PENDING other tasks are already queued. Never
+    // notifies right away, as the caller may hold a lock, e.g. an ESP32_ISR_Timer callback
+    bool IRAM_ATTR notifyFromISR(TaskHandle_t task, const uint32_t& bits)
+    {
+      for (uint8_t i = 0; i < _numPending; i++)
+      {
+        if (_pendingTask[i] == task)
+        {
+          _pendingBits[i] |= bits;
+
+          return true;
+        }
+      }
+
+      if (_numPending >= MAX_ESP32_TIMER_NOTIFY_PENDING)
+        return false;
+
+      _pendingTask[_numPending] = task;
+      _pendingBits[_numPending] = bits;
+      _numPending++;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    bool setInterval(const unsigned long& interval, esp32_timer_callback callback)
+    {
+      return setFrequency((float) (1000000.0f / interval), callback);
+    }
+
+    ////////////////////////////////////////
+
+    bool attachInterrupt(const float& frequency, esp32_timer_callback callback)
+    {
+      return setFrequency(frequency, callback);
+    }
+
+    ////////////////////////////////////////
+
+    // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    bool attachInterruptInterval(const unsigned long& interval, esp32_timer_callback callback)
+    {
+      return setFrequency( (float) ( 1000000.0f / interval), callback);
+    }
+
+    ////////////////////////////////////////
+
+    // Changes the interval (in microseconds) of the running timer, without stopping it nor allocating its interrupt
+    // again. The current period ends as programmed, the new interval applies from the next alarm on
+    bool changeInterval(const unsigned long& interval)
+    {
+      uint64_t timerCount = ( (uint64_t) TIMER_SCALE * interval ) / 1000000ULL;
+
+      if ( (_intrCore < 0) || (timerCount == 0) || (_latencyLead >= (timerCount >> 1)) )
+      {
+        TISR_LOGERROR1(F("Error. Timer not started, or invalid interval = "), interval);
+
+        return false;
+      }
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_timerMux);
+
+      _timerCount = timerCount;
+      _ncoEnabled = false;
+      _ncoPending = false;
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      _frequency = 1000000.0f / interval;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // NCO mode: frequency (in hertz) exact in the long run, even when the period isn't a whole number of counts,
+    // e.g. 44.1 kHz from the 1 MHz counter (22.675... counts). Periods alternate between N and N + 1 counts, driven
+    // by a 32-bit phase accumulator, so the mean period is exact to 2^-32 count and the jitter is at most one count
+    bool attachInterruptExact(const double& frequency, esp32_timer_callback callback)
+    {
+      uint64_t count;
+      uint32_t increment;
+
+      if (!computeNCO(frequency, count, increment))
+      {
+        TISR_LOGERROR1(F("Error. Invalid exact frequency = "), (float) frequency);
+
+        return false;
+      }
+
+      // the first period is the whole count of setFrequency(), the NCO takes over from the first alarm
+      if (!setFrequency( (float) frequency, callback))
+        return false;
+
+      portENTER_CRITICAL(&_timerMux);
+
+      _ncoPhase             = 0;
+      _ncoIncrement         = increment;
+      _ncoPendingCount      = count;
+      _ncoPendingIncrement  = increment;
+      _ncoPending           = true;
+      _ncoEnabled           = true;
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      _frequency = (float) frequency;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Glitch-free retune of a running timer, in NCO mode from now on. The current period ends as programmed, and
+    // the new frequency applies from the next alarm on, without resetting the phase accumulator
+    bool changeFrequencyExact(const double& frequency)
+    {
+      uint64_t count;
+      uint32_t increment;
+
+      if ( (_intrCore < 0) || !computeNCO(frequency, count, increment) )
+      {
+        TISR_LOGERROR1(F("Error. Timer not started, or invalid exact frequency = "), (float) frequency);
+
+        return false;
+      }
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_timerMux);
+
+      if (!_ncoEnabled)
+        _ncoPhase = 0;
+
+      _ncoPendingCount      = count;
+      _ncoPendingIncrement  = increment;
+      _ncoPending           = true;
+      _ncoEnabled           = true;
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      _frequency = (float) frequency;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Mean frequency actually generated, in hertz: the requested one within the 2^-32 count resolution in NCO mode,
+    // the truncated one otherwise
+    double getExactFrequency()
+    {
+      portENTER_CRITICAL(&_timerMux);
+
+      bool      pending   = _ncoPending;
+      uint64_t  count     = pending ? _ncoPendingCount : _timerCount;
+      uint32_t  increment = !_ncoEnabled ? 0 : (pending ? _ncoPendingIncrement : _ncoIncrement);
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      if (count == 0)
+        return 0;
+
+      return (double) TIMER_SCALE / ( (double) count + increment / 4294967296.0 );
+    }
+
+    ////////////////////////////////////////
+
+    void detachInterrupt()
+    {
+      timer_group_intr_disable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+    }
+
+    ////////////////////////////////////////
+
+    void disableTimer()
+    {
+      timer_group_intr_disable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+    }
+
+    ////////////////////////////////////////
+
+    // Duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    void reattachInterrupt()
+    {
+      timer_group_intr_enable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+    }
+
+    ////////////////////////////////////////
+
+    // Duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    void enableTimer()
+    {
+      timer_group_intr_enable(_timerGroup, (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1);
+    }
+
+    ////////////////////////////////////////
+
+    // Just stop clock source, clear the count
+    void stopTimer()
+    {
+      timer_pause(_timerGroup, _timerIndex);
+    }
+
+    ////////////////////////////////////////
+
+    // Just reconnect clock source, start current count from 0
+    void restartTimer()
+    {
+      // keep the timestamp monotonic across the counter reset
+      _baseCount = getTimestamp();
+
+      timer_set_counter_value(_timerGroup, _timerIndex, 0x00000000ULL);
+
+      // new phase origin => shorten the first period by the calibrated lead again
+      _alarmCount   = _timerCount - _latencyLead;
+      _pendingShift = 0;
+      timer_set_alarm_value(_timerGroup, _timerIndex, _alarmCount);
+
+      timer_start(_timerGroup, _timerIndex);
+    }
+
+    ////////////////////////////////////////
+
+    int8_t getTimer() __attribute__((always_inline))
+    {
+      return _timerIndex;
+    };
+
+    ////////////////////////////////////////
+
+    int8_t getTimerGroup() __attribute__((always_inline))
+    {
+      return _timerGroup;
+    };
+
+    ////////////////////////////////////////
+
+    // Measures the interrupt entry latency over numSamples fires of the running timer, then schedules the alarms
+    // early by the mean latency, so that timerISR() is entered on the programmed time. Only the phase is moved, by
+    // shortening one period, the period itself is unchanged. Can be called again, e.g. after changing the CPU frequency.
+    // Blocks for about numSamples periods. Must not be called from ISR
+    bool calibrateLatency(const uint16_t& numSamples = ESP32_S2_TIMER_CALIBRATION_SAMPLES)
+    {
+      if ( (_timerCount == 0) || (numSamples == 0) )
+      {
+        TISR_LOGERROR(F("Error. Timer must be running to calibrate the latency"));
+
+        return false;
+      }
+
+      bool tracking = _latencyTracking;
+
+      resetLatencyStats();
+      _latencyTracking = true;
+
+      // 2 x the expected time, plus margin
+      unsigned long timeout = (unsigned long) ( ( (uint64_t) numSamples * _timerCount * 2 ) / (TIMER_SCALE / 1000) ) + 100;
+      unsigned long start   = millis();
+
+      while ( (_latencyNum < numSamples) && (millis() - start < timeout) )
+        delay(1);
+
+      _latencyTracking = tracking;
+
+      if (_latencyNum < numSamples)
+      {
+        TISR_LOGERROR1(F("Error. Latency calibration timeout, samples = "), _latencyNum);
+
+        return false;
+      }
+
+      uint32_t lead = (_latencySum + (_latencyNum >> 1)) / _latencyNum;
+
+      if (lead >= (_timerCount >> 1))
+      {
+        TISR_LOGERROR1(F("Error. Latency too large for this period, latency = "), lead);
+
+        return false;
+      }
+
+      TISR_LOGWARN5(F("Latency lead = "), lead, F(", min = "), _latencyMin, F(", max = "), _latencyMax);
+
+      // ESP32 is a multi core / multi processing chip.
+      // It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_timerMux);
+
+      // only the difference with the current lead, if already calibrated
+      _pendingShift += (int32_t) lead - (int32_t) _latencyLead;
+      _latencyLead   = lead;
+
+      portEXIT_CRITICAL(&_timerMux);
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Removes the latency compensation, by lengthening one period by the lead
+    void clearLatencyCompensation()
+    {
+      portENTER_CRITICAL(&_timerMux);
+
+      _pendingShift -= (int32_t) _latencyLead;
+      _latencyLead   = 0;
+
+      portEXIT_CRITICAL(&_timerMux);
+    }
+
+    ////////////////////////////////////////
+
+    // Keeps measuring the entry latency at each fire, for getLatencyStats(). Costs a counter read per fire
+    void setLatencyTracking(const bool& enabled)
+    {
+      if (enabled && !_latencyTracking)
+        resetLatencyStats();
+
+      _latencyTracking = enabled;
+    }
+
+    ////////////////////////////////////////
+
+    // Calibrated lead, in counts
+    uint32_t getLatencyLead()
+    {
+      return _latencyLead;
+    }
+
+    ////////////////////////////////////////
+
+    // Latency statistics of the last calibrateLatency(), or since setLatencyTracking(true)
+    void getLatencyStats(timer_latency_t& latencyStats)
+    {
+      portENTER_CRITICAL(&_timerMux);
+
+      latencyStats.lead         = _latencyLead;
+      latencyStats.numSamples   = _latencyNum;
+      latencyStats.minLatency   = _latencyMin;
+      latencyStats.maxLatency   = _latencyMax;
+      latencyStats.meanLatency  = _latencyNum ? (_latencySum + (_latencyNum >> 1)) / _latencyNum : 0;
+      latencyStats.lastError    = (int32_t) _latencyLast - (int32_t) _latencyLead;
+
+      portEXIT_CRITICAL(&_timerMux);
+    }
+
+    ////////////////////////////////////////
+
+    // Measures the CPU time of each dispatch, for getUtilizationStats() and getMaxTickRate(). Costs two cycle counter
+    // reads per fire. The utilization is computed over windows of windowMs, up to 2^31 CPU cycles (8.9 s at 240 MHz)
+    bool setUtilizationTracking(const bool& enabled, const unsigned long& windowMs = 1000)
+    {
+      if (!enabled)
+      {
+        _utilTracking = false;
+
+        return true;
+      }
+
+      uint32_t cpuMhz = getCpuFrequencyMhz();
+
+      if ( (windowMs == 0) || ( (uint64_t) windowMs * cpuMhz * 1000 > 0x80000000ULL ) )
+      {
+        TISR_LOGERROR1(F("Error. Invalid utilization window (ms) = "), windowMs);
+
+        return false;
+      }
+
+      if (!_utilTracking)
+        resetUtilizationStats();
+
+      _utilCpuMhz       = cpuMhz;
+      _utilWindowCycles = windowMs * cpuMhz * 1000;
+      _utilTracking     = true;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Utilization statistics since setUtilizationTracking(true)
+    void getUtilizationStats(timer_utilization_t& utilStats)
+    {
+      portENTER_CRITICAL(&_timerMux);
+
+      utilStats.numSamples  = _utilNum;
+      utilStats.utilization = _utilization;
+      utilStats.meanCycles  = _utilNum ? (uint32_t) ( (_utilSum + (_utilNum >> 1)) / _utilNum ) : 0;
+      utilStats.peakCycles  = _utilPeak;
+      utilStats.lastCycles  = _utilLast;
+
+      memcpy(utilStats.histogram, _utilHistogram, sizeof(_utilHistogram));
+
+      portEXIT_CRITICAL(&_timerMux);
+    }
+
+    ////////////////////////////////////////
+
+    // Highest tick rate, in Hz, the current callback mix could sustain using at most maxUtilizationPercent of the core,
+    // assuming the mean dispatch time stays the same at a higher rate. Never more than one peak dispatch per tick.
+    // 0 if nothing was measured
+    float getMaxTickRate(const uint8_t& maxUtilizationPercent = 100)
+    {
+      timer_utilization_t utilStats;
+
+      getUtilizationStats(utilStats);
+
+      if ( (utilStats.meanCycles == 0) || (utilStats.peakCycles == 0) )
+        return 0;
+
+      float cpuHz   = _utilCpuMhz * 1000000.0f;
+      float meanMax = cpuHz * maxUtilizationPercent / (100.0f * utilStats.meanCycles);
+      float peakMax = cpuHz / utilStats.peakCycles;
+
+      return (meanMax < peakMax) ? meanMax : peakMax;
+    }
+
+    ////////////////////////////////////////
+
+    // Interrupt level for the next setFrequency(): 1 to ESP32_S2_TIMER_MAX_INTR_LEVEL, or ESP32_S2_TIMER_DEFAULT_INTR_LEVEL
+    bool setInterruptLevel(const uint8_t& intrLevel)
+    {
+      if (intrLevel > ESP32_S2_TIMER_MAX_INTR_LEVEL)
+      {
+        TISR_LOGERROR1(F("Error. Interrupt level must be 0-"), ESP32_S2_TIMER_MAX_INTR_LEVEL);
+
+        return false;
+      }
+
+      _intrLevel = intrLevel;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Requested interrupt level, see getAllocatedInterruptLevel() for the level actually used
+    uint8_t getInterruptLevel()
+    {
+      return _intrLevel;
+    }
+
+    ////////////////////////////////////////
+
+    // Core for the next setFrequency(): 0 to portNUM_PROCESSORS - 1, or ESP32_S2_TIMER_ANY_CORE
+    bool setCoreAffinity(const int8_t& core)
+    {
+      if ( (core < ESP32_S2_TIMER_ANY_CORE) || (core >= portNUM_PROCESSORS) )
+      {
+        TISR_LOGERROR1(F("Error. Core must be -1 to "), portNUM_PROCESSORS - 1);
+
+        return false;
+      }
+
+      _coreAffinity = core;
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Core the interrupt is allocated on, or -1 if not allocated
+    int8_t getInterruptCore()
+    {
+      return _intrCore;
+    }
+
+    ////////////////////////////////////////
+
+    // Result (ESP_OK or ESP_ERR_xxx) of the last interrupt allocation
+    esp_err_t getInterruptResult()
+    {
+      return _intrResult;
+    }
+
+    ////////////////////////////////////////
+
+    // Handle of the allocated interrupt, for the esp_intr_xxx() functions, or NULL if not allocated
+    intr_handle_t getInterruptHandle()
+    {
+      return _intrHandle;
+    }
+
+    ////////////////////////////////////////
+
+    // CPU interrupt number of the allocated interrupt, or -1 if not allocated
+    int getInterruptNumber()
+    {
+      return _intrHandle ? esp_intr_get_intno(_intrHandle) : -1;
+    }
+
+    ////////////////////////////////////////
+
+    // Level of the allocated interrupt, i.e. the one chosen by the allocator for ESP32_S2_TIMER_DEFAULT_INTR_LEVEL,
+    // or 0 if not allocated
+    uint8_t getAllocatedInterruptLevel()
+    {
+      if (_intrHandle == NULL)
+        return 0;
+
+#if defined(__XTENSA__)
+      return Xthal_intlevel[esp_intr_get_intno(_intrHandle)];
+#else
+      return _intrLevel;
+#endif
+    }
+
+    ////////////////////////////////////////
+
+    // Raw value of the hardware counter, in counts of 1 / TIMER_SCALE s since the last alarm. Safe to use in ISR
+    inline uint64_t IRAM_ATTR getCounter() __attribute__((always_inline))
+    {
+      return timer_group_get_counter_value_in_isr(_timerGroup, _timerIndex);
+    }
+
+    ////////////////////////////////////////
+
+    // Monotonic 64-bit timestamp, in counts of 1 / TIMER_SCALE s since setFrequency(). Safe to use in ISR
+    uint64_t IRAM_ATTR getTimestamp()
+    {
+      uint64_t base;
+      uint64_t count;
+
+      // retry if the timer ISR updated _baseCount meanwhile (64-bit reads are not atomic)
+      do
+      {
+        base  = _baseCount;
+        count = getCounter();
+      } while (base != _baseCount);
+
+      // alarm already reached, but its ISR not yet run (we are in a higher or same priority ISR, or in a critical
+      // section). A small counter value means it was read after the auto-reload
+      if ( (timer_group_get_intr_status_in_isr(_timerGroup) & ( (_timerIndex == 0) ? TIMER_INTR_T0 : TIMER_INTR_T1) )
+           && (count < (_alarmCount >> 1)) )
+      {
+        base += _alarmCount;
+      }
+
+      return base + count;
+    }
+
+    ////////////////////////////////////////
+
+    // Converts timer counts to nanoseconds, without overflow for any 64-bit count. Safe to use in ISR
+    static inline uint64_t IRAM_ATTR countsToNs(const uint64_t& counts)
+    {
+      // TIMER_SCALE is 1MHz by default => no division at all
+      if ( (1000000000ULL % TIMER_SCALE) == 0 )
+        return counts * (1000000000ULL / TIMER_SCALE);
+
+      return ( (counts / TIMER_SCALE) * 1000000000ULL ) + ( ( (counts % TIMER_SCALE) * 1000000000ULL ) / TIMER_SCALE );
+    }
+
+    ////////////////////////////////////////
+
+    // Monotonic timestamp in nanoseconds since setFrequency(). Safe to use in ISR
+    inline uint64_t IRAM_ATTR getTimestampNs()
+    {
+      return countsToNs(getTimestamp());
+    }
+
+    ////////////////////////////////////////
+
+    // Alarm value (counts) of the period starting now, i.e. just after the auto-reload. Only from timerISR() or a
+    // callback of this timer, for one-shot alarms at variable times: the following periods go back to the
+    // setFrequency() period, unless set again. Must be larger than getCounter(), or the counter runs to its 64-bit wrap
+    inline void IRAM_ATTR setNextAlarmInISR(const uint64_t& alarmCount) __attribute__((always_inline))
+    {
+      _alarmCount = alarmCount;
+      timer_group_set_alarm_value_in_isr(_timerGroup, _timerIndex, alarmCount);
+    }
+    ////////////////////////////////////////
+
+    // Counts left until the next alarm. Safe to use in ISR
+    inline uint64_t IRAM_ATTR getTimeToNextAlarm()
+    {
+      uint64_t count = getCounter();
+
+      return (count < _alarmCount) ? (_alarmCount - count) : 0;
+    }
+
+    ////////////////////////////////////////
+
+    // Nanoseconds left until the next alarm. Safe to use in ISR
+    inline uint64_t IRAM_ATTR getTimeToNextAlarmNs()
+    {
+      return countsToNs(getTimeToNextAlarm());
+    }
+
+    ////////////////////////////////////////
+
 }; // class ESP32TimerInterrupt
 
 #endif    // ESP32_S2_TIMERINTERRUPT_H
@@ -0,0 +1,224 @@
+/****************************************************************************************************************************
+  ESP32_S2_TimerRateLimiter.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_TimerRateLimiter is a token bucket for ISR and task producers, e.g. outgoing messages or actuator commands.
+  It refills lazily from the 64-bit timestamp of an ESP32TimerInterrupt, so it needs no refill timer or timer slot,
+  and any number of buckets can share the same timer as timebase. The bucket state is one 32-bit theoretical arrival
+  time (GCRA), and tryAcquire() is one timestamp read and one compare-and-swap, without lock.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+
+#pragma once
+
+#ifndef TIMER_RATE_LIMITER_GENERIC_H
+#define TIMER_RATE_LIMITER_GENERIC_H
+
+////////////////////////////////////////
+
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include <atomic>
+
+////////////////////////////////////////
+
+class ESP32_TimerRateLimiter
+{
+  public:
+
+    ////////////////////////////////////////
+
+    ESP32_TimerRateLimiter()
+    {
+      _timebase   = NULL;
+      _interval   = 0;
+      _limit      = 0;
+      _tat        = 0;
+      _rejected   = 0;
+    }
+
+    ////////////////////////////////////////
+
+    // Allows 'rate' tokens per second on average, and bursts of up to 'burst' tokens. timebase must be running
+    // (attachInterruptInterval(), etc.). Its timestamps are in counts of 1 / TIMER_SCALE s, 1us by default, so the
+    // rate is limited to TIMER_SCALE tokens/s, and the burst window (burst / rate) to 2^31 counts, ~35 minutes.
+    // The bucket starts full
+    bool begin(ESP32TimerInterrupt& timebase, const float& rate, const uint32_t& burst = 1)
+    {
+      _timebase = &timebase;
+
+      return setRate(rate, burst);
+    }
+
+    ////////////////////////////////////////
+
+    // Changes the rate and burst, from task context. A tryAcquire() running meanwhile uses the old or the new values
+    bool setRate(const float& rate, const uint32_t& burst = 1)
+    {
+      // conversion to counts here, so tryAcquire() only adds and compares integers
+      double interval = (double) TIMER_SCALE / rate;
+
+      if ( (_timebase == NULL) || (rate <= 0) || (burst == 0) || (interval < 1.0) ||
+           ( (interval * burst) >= (double) 0x80000000UL ) )
+      {
+        TISR_LOGERROR3(F("ESP32_TimerRateLimiter: invalid rate = "), rate, F(", burst = "), burst);
+
+        return false;
+      }
+
+      _interval = (uint32_t) (interval + 0.5);
+      _limit    = _interval * burst;
+
+      reset();
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Takes n tokens if available. Never blocks. Safe in ISR (IRAM) and from any task or core
+    // returns false, and takes nothing, if fewer than n tokens are available
+    bool IRAM_ATTR tryAcquire(const uint32_t& n = 1)
+    {
+      if ( (_interval == 0) || (n > (_limit / _interval)) )
+      {
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+      }
+
+      uint32_t now    = (uint32_t) _timebase->getTimestamp();
+      uint32_t tat    = _tat.load(std::memory_order_relaxed);
+      uint32_t newTat;
+
+      do
+      {
+        // The theoretical arrival time is never more than _limit ahead of now. Behind now (bucket full), or stale
+        // after a 32-bit wrap of the timestamp, the unsigned difference is larger: restart from now
+        newTat = ( (uint32_t) (tat - now) <= _limit ) ? tat : now;
+        newTat += n * _interval;
+
+        if ( (uint32_t) (newTat - now) > _limit )
+        {
+          _rejected.fetch_add(1, std::memory_order_relaxed);
+
+          return false;
+        }
+      } while (!_tat.compare_exchange_weak(tat, newTat, std::memory_order_relaxed));
+
+      return true;
+    }
+
+    ////////////////////////////////////////
+
+    // Number of tokens available now. Safe in ISR
+    uint32_t IRAM_ATTR available()
+    {
+      if (_interval == 0)
+        return 0;
+
+      uint32_t now    = (uint32_t) _timebase->getTimestamp();
+      uint32_t ahead  = _tat.load(std::memory_order_relaxed) - now;
+
+      if (ahead > _limit)
+        return _limit / _interval;
+
+      return (_limit - ahead) / _interval;
+    }
+
+    ////////////////////////////////////////
+
+    // Time until n tokens are available, in counts of 1 / TIMER_SCALE s, 0 if available now. Safe in ISR
+    uint32_t IRAM_ATTR getWaitTime(const uint32_t& n = 1)
+    {
+      if ( (_interval == 0) || (n > (_limit / _interval)) )
+        return UINT32_MAX;
+
+      uint32_t now    = (uint32_t) _timebase->getTimestamp();
+      uint32_t ahead  = _tat.load(std::memory_order_relaxed) - now;
+
+      if (ahead > _limit)
+        return 0;
+
+      uint32_t needed = ahead + n * _interval;
+
+      return (needed > _limit) ? (needed - _limit) : 0;
+    }
+
+    ////////////////////////////////////////
+
+    // Refills the bucket
+    void reset()
+    {
+      if (_timebase)
+        _tat.store((uint32_t) _timebase->getTimestamp(), std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////
+
+    // Number of rejected tryAcquire() calls
+    uint32_t getRejected()
+    {
+      return _rejected.load(std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////
+
+    void clearRejected()
+    {
+      _rejected.store(0, std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////
+
+    // Emission interval, in counts of 1 / TIMER_SCALE s per token
+    uint32_t getInterval()
+    {
+      return _interval;
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    ESP32TimerInterrupt*    _timebase;
+
+    // counts per token, and burst window (counts per burst)
+    uint32_t                _interval;
+    uint32_t                _limit;
+
+    // theoretical arrival time: lower 32 bits of the timestamp when the bucket is full again
+    std::atomic<uint32_t>   _tat;
+
+    std::atomic<uint32_t>   _rejected;
+};
+
+#endif    // TIMER_RATE_LIMITER_GENERIC_H
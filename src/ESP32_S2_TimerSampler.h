@@ -0,0 +1,246 @@
+/****************************************************************************************************************************
+  ESP32_S2_TimerSampler.h
+  For ESP32_S2 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_S2_TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32-S2 has two timer groups, each one with two general purpose hardware timers. All the timers are based on 64 bits
+  counters and 16 bit prescalers. The timer counters can be configured to count up or down and support automatic reload
+  and software reload. They can also generate alarms when they reach a specific value, defined by the software. The value
+  of the counter can be read by the software program.
+
+  ESP32_TimerSampler is a timer-driven streaming sampler. At each tick of an ESP32TimerInterrupt, it stores the value of
+  a user sample function into a preallocated ping-pong buffer, and wakes a consumer task only when a whole block is full,
+  with the timestamp of its first sample and an overrun count.
+
+  Based on SimpleTimer - A timer library for Arduino.
+  Author: mromani@ottotecnica.com
+  Copyright (c) 2010 OTTOTECNICA Italy
+
+  Based on BlynkTimer.h
+  Author: Volodymyr Shymanskyy
+
+  Version: 1.8.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  1.3.0   K Hoang      06/05/2019 Initial coding. Sync with ESP32TimerInterrupt v1.3.0
+  1.4.0   K Hoang      01/06/2021 Add complex examples. Fix compiler errors due to conflict to some libraries.
+  1.5.0   K.Hoang      23/01/2022 Avoid deprecated functions. Fix `multiple-definitions` linker error
+  1.5.1   K Hoang      16/06/2022 Add support to new Adafruit board QTPY_ESP32S2
+  1.6.0   K Hoang      10/08/2022 Suppress errors and warnings for new ESP32 core
+  1.7.0   K Hoang      11/08/2022 Suppress warnings and add support for more ESP32_S2 boards
+  1.8.0   K Hoang      16/11/2022 Fix doubled time for ESP32_S2
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef TIMER_SAMPLER_GENERIC_H
+#define TIMER_SAMPLER_GENERIC_H
+
+////////////////////////////////////////
+
+#include "ESP32_S2_TimerInterrupt.h"
+
+////////////////////////////////////////
+
+// SampleType : type of one sample, e.g. uint16_t for ADC values or uint32_t for a whole GPIO.in register
+// BlockSize  : number of samples per block. The object holds 2 blocks
+template <typename SampleType, size_t BlockSize>
+class ESP32_TimerSampler
+{
+    static_assert(BlockSize > 0, "BlockSize must be > 0");
+
+  public:
+
+    // Called in ISR at each sample: must be IRAM_ATTR with USING_ESP32_S2_TIMER_IRAM, and not use Serial, etc.
+    typedef SampleType (*sampler_read_t)(void * context);
+
+    ////////////////////////////////////////
+
+    ESP32_TimerSampler()
+    {
+      _timer      = NULL;
+      _read       = NULL;
+      _context    = NULL;
+      _consumer   = NULL;
+      _callbackNo = -1;
+
+      clear();
+    }
+
+    ////////////////////////////////////////
+
+    // Starts sampling every divisor-th tick of timer, which can be running already and shared with other callbacks.
+    // consumer is the task woken at each full block, NULL for the calling task
+    bool begin(ESP32TimerInterrupt& timer, sampler_read_t read, void * context = NULL, const uint32_t& divisor = 1,
+               TaskHandle_t consumer = NULL)
+    {
+      if ( (read == NULL) || (_callbackNo >= 0) )
+      {
+        TISR_LOGERROR(F("ESP32_TimerSampler: invalid read function or already started"));
+
+        return false;
+      }
+
+      _timer    = &timer;
+      _read     = read;
+      _context  = context;
+      _consumer = consumer ? consumer : xTaskGetCurrentTaskHandle();
+
+      clear();
+
+      _callbackNo = timer.addCallback(sampleISR, this, divisor);
+
+      return (_callbackNo >= 0);
+    }
+
+    ////////////////////////////////////////
+
+    void end()
+    {
+      if (_callbackNo >= 0)
+      {
+        _timer->removeCallback(_callbackNo);
+        _callbackNo = -1;
+      }
+    }
+
+    ////////////////////////////////////////
+
+    // Waits up to timeout ticks for a full block. Returns its samples, or NULL on timeout.
+    // timestamp, if not NULL, gets the timestamp (timer counts, see ESP32TimerInterrupt::countsToNs()) of its first
+    // sample. The block is owned by the caller until releaseBlock(). Only from the consumer task
+    const SampleType* waitBlock(const TickType_t& timeout = portMAX_DELAY, uint64_t* timestamp = NULL)
+    {
+      // the notification of an already ready block is consumed too, so that it can't wake a later call
+      if ( (ulTaskNotifyTake(pdTRUE, (_readyBlock < 0) ? timeout : 0) == 0) && (_readyBlock < 0) )
+        return NULL;
+
+      int8_t block = _readyBlock;
+
+      if (block < 0)
+        return NULL;
+
+      if (timestamp)
+        *timestamp = _blockTimestamp[block];
+
+      return _buffer[block];
+    }
+
+    ////////////////////////////////////////
+
+    // Gives the block of the last waitBlock() back to the sampler
+    void releaseBlock()
+    {
+      _readyBlock = -1;
+    }
+
+    ////////////////////////////////////////
+
+    // Number of blocks lost because the consumer still held the previous one when the next one was full
+    uint32_t getOverruns()
+    {
+      return _overruns;
+    }
+
+    ////////////////////////////////////////
+
+    // Number of full blocks delivered to the consumer
+    uint32_t getNumBlocks()
+    {
+      return _numBlocks;
+    }
+
+    ////////////////////////////////////////
+
+    static constexpr size_t getBlockSize()
+    {
+      return BlockSize;
+    }
+
+    ////////////////////////////////////////
+
+  private:
+
+    ////////////////////////////////////////
+
+    void clear()
+    {
+      _writeBlock = 0;
+      _readyBlock = -1;
+      _fill       = 0;
+      _overruns   = 0;
+      _numBlocks  = 0;
+    }
+
+    ////////////////////////////////////////
+
+    // Chained callback of the ESP32TimerInterrupt. Returns true if the consumer task must run now
+    static bool IRAM_ATTR sampleISR(void * arg)
+    {
+      ESP32_TimerSampler* sampler = (ESP32_TimerSampler*) arg;
+
+      uint8_t block = sampler->_writeBlock;
+      size_t  fill  = sampler->_fill;
+
+      if (fill == 0)
+        sampler->_blockTimestamp[block] = sampler->_timer->getTimestamp();
+
+      sampler->_buffer[block][fill++] = sampler->_read(sampler->_context);
+
+      if (fill < BlockSize)
+      {
+        sampler->_fill = fill;
+
+        return false;
+      }
+
+      sampler->_fill = 0;
+
+      // consumer still busy with the other block: this block is overwritten
+      if (sampler->_readyBlock >= 0)
+      {
+        sampler->_overruns++;
+
+        return false;
+      }
+
+      sampler->_readyBlock = block;
+      sampler->_writeBlock = block ^ 1;
+      sampler->_numBlocks++;
+
+      // coalesced with the other notifications of this tick, sent and yielded for by the timer ISR. Any bit wakes
+      // ulTaskNotifyTake() in waitBlock()
+      if (sampler->_timer->notifyFromISR(sampler->_consumer, 1))
+        return false;
+
+      // too many tasks notified at this tick. Chained callbacks are called out of the timer lock
+      BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+      vTaskNotifyGiveFromISR(sampler->_consumer, &higherPriorityTaskWoken);
+
+      return (higherPriorityTaskWoken == pdTRUE);
+    }
+
+    ////////////////////////////////////////
+
+    ESP32TimerInterrupt*  _timer;
+    sampler_read_t        _read;
+    void*                 _context;
+    TaskHandle_t          _consumer;
+    int8_t                _callbackNo;          // entry in the timer chained callbacks, -1 if not started
+
+    SampleType            _buffer[2][BlockSize];
+    volatile uint64_t     _blockTimestamp[2];   // timestamp of the first sample of each block
+
+    volatile uint8_t      _writeBlock;          // block being filled by the ISR
+    volatile int8_t       _readyBlock;          // block owned by the consumer, -1 if none
+    volatile size_t       _fill;                // samples in _writeBlock
+    volatile uint32_t     _overruns;
+    volatile uint32_t     _numBlocks;
+};
+
+#endif    // TIMER_SAMPLER_GENERIC_H
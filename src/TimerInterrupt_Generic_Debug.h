@@ -112,4 +112,17 @@ const char TISR_SP[]    = " ";
 
 ////////////////////////////////////////
 
+// CPU cycle counter, for ISR / callback execution time measurements. Safe to use in ISR
+#include <esp_idf_version.h>
+
+#if ( defined(ESP_IDF_VERSION_MAJOR) && (ESP_IDF_VERSION_MAJOR >= 5) )
+  #include <esp_cpu.h>
+  #define TISR_GET_CYCLE_COUNT()     esp_cpu_get_cycle_count()
+#else
+  #include <hal/cpu_hal.h>
+  #define TISR_GET_CYCLE_COUNT()     cpu_hal_get_cycle_count()
+#endif
+
+////////////////////////////////////////
+
 #endif    //TIMERINTERRUPT_GENERIC_DEBUG_H
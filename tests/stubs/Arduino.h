@@ -0,0 +1,115 @@
+#pragma once
+// Host stub of the Arduino-ESP32 core for tests/: just enough to build the library. Time follows g_us, see stubs.cpp
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define ESP_INTR_FLAG_LEVEL1 (1<<1)
+#define ESP_INTR_FLAG_LEVEL2 (1<<2)
+#define ESP_INTR_FLAG_LEVEL3 (1<<3)
+#define ESP_INTR_FLAG_LEVEL4 (1<<4)
+#define ESP_INTR_FLAG_LEVEL5 (1<<5)
+#define ESP_INTR_FLAG_LEVEL6 (1<<6)
+#define ESP_INTR_FLAG_NMI (1<<7)
+#define ESP_INTR_FLAG_IRAM (1<<10)
+#define ESP_INTR_FLAG_LOWMED (ESP_INTR_FLAG_LEVEL1|ESP_INTR_FLAG_LEVEL2|ESP_INTR_FLAG_LEVEL3)
+#define F(x) x
+#define OUTPUT 1
+#define INPUT 0
+#define INPUT_PULLUP 2
+#define HIGH 1
+#define LOW 0
+#define ARDUINO_BOARD "stub"
+#define F_CPU 240000000L
+#define TIMER_BASE_CLK 80000000
+#ifndef portNUM_PROCESSORS
+#define portNUM_PROCESSORS 1
+#endif
+#define ESP_IDF_VERSION_MAJOR 4
+#define ESP_IDF_VERSION_MINOR 4
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+typedef struct { int a; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+// g_critical: depth of the critical sections entered, to check what the library calls under its locks
+extern int g_critical;
+#define portENTER_CRITICAL(x) ((void)(x), g_critical++)
+#define portEXIT_CRITICAL(x) ((void)(x), g_critical--)
+#define portENTER_CRITICAL_ISR(x) ((void)(x), g_critical++)
+#define portEXIT_CRITICAL_ISR(x) ((void)(x), g_critical--)
+#define portENTER_CRITICAL_SAFE(x) ((void)(x), g_critical++)
+#define portEXIT_CRITICAL_SAFE(x) ((void)(x), g_critical--)
+#define configMAX_PRIORITIES 25
+#define ESP_ERR_NO_MEM 0x101
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define portMAX_DELAY 0xffffffff
+#define portYIELD_FROM_ISR()
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(x) (x)
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void*);
+typedef enum { eNoAction, eSetBits, eIncrement, eSetValueWithOverwrite } eNotifyAction;
+// g_notifyLocked: notifications sent in a critical section. g_notifyTask: task of the last notification
+extern int g_notifyCalls; extern uint32_t g_notifyLast; extern int g_notifyLocked; extern TaskHandle_t g_notifyTask;
+inline BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t b, eNotifyAction, BaseType_t* w) { g_notifyCalls++; g_notifyLast = b; g_notifyTask = t; g_notifyLocked += (g_critical > 0); if (w) *w = 1; return 1; }
+inline BaseType_t xTaskNotify(TaskHandle_t t, uint32_t b, eNotifyAction) { g_notifyCalls += 100; g_notifyLast = b; g_notifyTask = t; g_notifyLocked += (g_critical > 0); return 1; }
+inline BaseType_t xTaskNotifyWait(uint32_t, uint32_t, uint32_t*, TickType_t) { return 1; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t* w) { g_notifyCalls++; if (w) *w = 1; }
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 1; }
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return 1; }
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return (TaskHandle_t) 1; }
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t, TaskHandle_t* h, BaseType_t) { if (h) *h = (TaskHandle_t) 1; return 1; }
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskDelay(TickType_t) {}
+extern int g_core;
+inline BaseType_t xPortGetCoreID() { return g_core; }
+#include <deque>
+#include <vector>
+struct StubQueue { std::deque<std::vector<char>> q; size_t len, sz; };
+inline QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t sz) { StubQueue* q = new StubQueue; q->len = len; q->sz = sz; return q; }
+inline BaseType_t xQueueSend(QueueHandle_t h, const void* p, TickType_t) { StubQueue* q = (StubQueue*) h; if (q->q.size() >= q->len) return 0; q->q.push_back(std::vector<char>((const char*) p, (const char*) p + q->sz)); return 1; }
+inline BaseType_t xQueueSendFromISR(QueueHandle_t h, const void* p, BaseType_t*) { return xQueueSend(h, p, 0); }
+inline BaseType_t xQueueReceive(QueueHandle_t h, void* p, TickType_t) { StubQueue* q = (StubQueue*) h; if (q->q.empty()) return 0; memcpy(p, q->q.front().data(), q->sz); q->q.pop_front(); return 1; }
+inline BaseType_t xQueueReceiveFromISR(QueueHandle_t h, void* p, BaseType_t*) { return xQueueReceive(h, p, 0); }
+extern int g_inISR;
+inline BaseType_t xPortInIsrContext() { return g_inISR; }
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return (void*)1; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return 1; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return 1; }
+inline void vSemaphoreDelete(SemaphoreHandle_t) {}
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long);
+void delayMicroseconds(unsigned);
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+int analogRead(uint8_t);
+uint32_t getCpuFrequencyMhz();
+int64_t esp_timer_get_time();
+uint32_t cpu_hal_get_cycle_count();
+uint32_t esp_cpu_get_cycle_count();
+struct StubSerial {
+  template<class T> void print(T) {}
+  template<class T> void print(T, int) {}
+  template<class T> void println(T) {}
+  template<class T> void println(T, int) {}
+  void println() {}
+  void begin(int) {}
+  operator bool() { return true; }
+};
+extern StubSerial Serial;
@@ -0,0 +1,30 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_intr_alloc.h>
+typedef enum { TIMER_GROUP_0 = 0, TIMER_GROUP_1 = 1, TIMER_GROUP_MAX } timer_group_t;
+typedef enum { TIMER_0 = 0, TIMER_1 = 1, TIMER_MAX } timer_idx_t;
+typedef enum { TIMER_COUNT_DOWN = 0, TIMER_COUNT_UP = 1, TIMER_COUNT_MAX } timer_count_dir_t;
+typedef enum { TIMER_PAUSE = 0, TIMER_START = 1 } timer_start_t;
+typedef enum { TIMER_ALARM_DIS = 0, TIMER_ALARM_EN = 1, TIMER_ALARM_MAX } timer_alarm_t;
+typedef enum { TIMER_INTR_LEVEL = 0, TIMER_INTR_MAX } timer_intr_mode_t;
+typedef enum { TIMER_AUTORELOAD_DIS = 0, TIMER_AUTORELOAD_EN = 1, TIMER_AUTORELOAD_MAX } timer_autoreload_t;
+typedef enum { TIMER_INTR_T0 = 1, TIMER_INTR_T1 = 2, TIMER_INTR_WDT = 4, TIMER_INTR_NONE = 0 } timer_intr_t;
+typedef struct { timer_alarm_t alarm_en; timer_start_t counter_en; timer_intr_mode_t intr_type; timer_count_dir_t counter_dir; timer_autoreload_t auto_reload; uint32_t divider; } timer_config_t;
+typedef bool (*timer_isr_t)(void *);
+esp_err_t timer_init(timer_group_t, timer_idx_t, const timer_config_t*);
+esp_err_t timer_set_counter_value(timer_group_t, timer_idx_t, uint64_t);
+esp_err_t timer_get_counter_value(timer_group_t, timer_idx_t, uint64_t*);
+esp_err_t timer_set_alarm_value(timer_group_t, timer_idx_t, uint64_t);
+esp_err_t timer_enable_intr(timer_group_t, timer_idx_t);
+esp_err_t timer_start(timer_group_t, timer_idx_t);
+esp_err_t timer_pause(timer_group_t, timer_idx_t);
+esp_err_t timer_group_intr_enable(timer_group_t, timer_intr_t);
+esp_err_t timer_group_intr_disable(timer_group_t, timer_intr_t);
+uint64_t timer_group_get_counter_value_in_isr(timer_group_t, timer_idx_t);
+void timer_group_set_alarm_value_in_isr(timer_group_t, timer_idx_t, uint64_t);
+uint32_t timer_group_get_intr_status_in_isr(timer_group_t);
+void timer_group_clr_intr_status_in_isr(timer_group_t, timer_idx_t);
+void timer_group_enable_alarm_in_isr(timer_group_t, timer_idx_t);
+esp_err_t timer_isr_register(timer_group_t, timer_idx_t, void (*)(void*), void*, int, intr_handle_t*);
+// runs the ISR registered for the timer, as its alarm would
+void stubFireTimer(timer_group_t, timer_idx_t);
@@ -0,0 +1,6 @@
+#pragma once
+#include <Arduino.h>
+typedef struct intr_handle_data_t* intr_handle_t;
+esp_err_t esp_intr_free(intr_handle_t);
+int esp_intr_get_intno(intr_handle_t);
+int esp_intr_get_cpu(intr_handle_t);
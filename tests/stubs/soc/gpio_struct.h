@@ -0,0 +1,4 @@
+#pragma once
+#include <stdint.h>
+typedef struct { uint32_t out; uint32_t out_w1ts; uint32_t out_w1tc; union { struct { uint32_t data:22; }; uint32_t val; } out1_w1ts, out1_w1tc; uint32_t in; union { struct { uint32_t data:22; }; uint32_t val; } in1; } gpio_dev_t;
+extern volatile gpio_dev_t GPIO;
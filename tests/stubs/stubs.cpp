@@ -0,0 +1,50 @@
+// Host stub implementation for tests/: millis(), micros() and esp_timer_get_time() follow g_us, set by the tests
+
+#include <Arduino.h>
+#include <driver/timer.h>
+StubSerial Serial;
+int g_notifyCalls = 0; uint32_t g_notifyLast = 0; int g_inISR = 0;
+int g_notifyLocked = 0; TaskHandle_t g_notifyTask = NULL; int g_critical = 0;
+int g_core = 0;
+int64_t g_us = 0;
+unsigned long millis() { return g_us / 1000; }
+unsigned long micros() { return g_us; }
+void delay(unsigned long) {}
+void delayMicroseconds(unsigned) {}
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return 0; }
+int analogRead(uint8_t) { return 0; }
+uint32_t getCpuFrequencyMhz() { return 240; }
+int64_t esp_timer_get_time() { return g_us; }
+uint32_t g_ccount = 0;
+uint32_t cpu_hal_get_cycle_count() { return g_ccount; }
+uint32_t esp_cpu_get_cycle_count() { return g_ccount; }
+uint64_t g_hwcount = 0, g_alarm = 0;
+esp_err_t timer_init(timer_group_t, timer_idx_t, const timer_config_t*) { return 0; }
+esp_err_t timer_set_counter_value(timer_group_t, timer_idx_t, uint64_t v) { g_hwcount = v; return 0; }
+esp_err_t timer_get_counter_value(timer_group_t, timer_idx_t, uint64_t* v) { *v = g_hwcount; return 0; }
+esp_err_t timer_set_alarm_value(timer_group_t, timer_idx_t, uint64_t v) { g_alarm = v; return 0; }
+esp_err_t timer_enable_intr(timer_group_t, timer_idx_t) { return 0; }
+esp_err_t timer_start(timer_group_t, timer_idx_t) { return 0; }
+esp_err_t timer_pause(timer_group_t, timer_idx_t) { return 0; }
+esp_err_t timer_group_intr_enable(timer_group_t, timer_intr_t) { return 0; }
+esp_err_t timer_group_intr_disable(timer_group_t, timer_intr_t) { return 0; }
+uint64_t timer_group_get_counter_value_in_isr(timer_group_t, timer_idx_t) { return g_hwcount; }
+void timer_group_set_alarm_value_in_isr(timer_group_t, timer_idx_t, uint64_t v) { g_alarm = v; }
+uint32_t g_intrStatus[2] = { 0, 0 };
+uint32_t timer_group_get_intr_status_in_isr(timer_group_t g) { return g_intrStatus[g]; }
+void timer_group_clr_intr_status_in_isr(timer_group_t g, timer_idx_t i) { g_intrStatus[g] &= ~(1u << i); }
+int g_alarmEnables = 0;
+void timer_group_enable_alarm_in_isr(timer_group_t, timer_idx_t) { g_alarmEnables++; }
+struct intr_handle_data_t { int cpu; bool used; };
+intr_handle_data_t g_intrs[4];
+void (*g_rawIsrs[4])(void*); void* g_rawIsrArgs[4];
+esp_err_t timer_isr_register(timer_group_t g, timer_idx_t i, void (*f)(void*), void* a, int, intr_handle_t* h)
+{ int k = g * 2 + i; g_rawIsrs[k] = f; g_rawIsrArgs[k] = a; g_intrs[k].cpu = g_core; g_intrs[k].used = true; if (h) *h = &g_intrs[k]; return 0; }
+esp_err_t esp_intr_free(intr_handle_t h) { h->used = false; return 0; }
+int esp_intr_get_intno(intr_handle_t h) { return 17 + (int) (h - g_intrs); }
+int esp_intr_get_cpu(intr_handle_t h) { return h->cpu; }
+void stubFireTimer(timer_group_t g, timer_idx_t i)
+{ int k = g * 2 + i; if (!g_rawIsrs[k] || !g_intrs[k].used) return; g_intrStatus[g] |= (1u << i); int was = g_inISR; g_inISR = 1; g_rawIsrs[k](g_rawIsrArgs[k]); g_inISR = was; }
+
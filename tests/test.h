@@ -0,0 +1,22 @@
+// Minimal host test support for tests/: CHECK() reports the failed condition and counts it, TEST_END() returns
+// the exit status of the test
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+
+extern int64_t  g_us;
+extern int      g_inISR;
+
+static int test_failures = 0;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); test_failures++; } } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { long long _a = (long long) (a), _b = (long long) (b); \
+       if (_a != _b) { printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+                       test_failures++; } } while (0)
+
+#define TEST_END() \
+  ( printf("%s: %s\n", __FILE__, test_failures ? "FAILED" : "passed"), test_failures ? 1 : 0 )
@@ -0,0 +1,148 @@
+// ESP32_ISR_Timer::enableAutoTick(): tick selection against an exhaustive search, domains, sequences, exemption
+#include "test.h"
+#include "ESP32_S2_TimerInterrupt.h"
+#include "ESP32_S2_ISR_Timer.h"
+
+ESP32Timer      ITimer(0);
+ESP32_ISR_Timer ISR_Timer;
+
+bool IRAM_ATTR TimerHandler(void*)
+{
+  return ISR_Timer.run();
+}
+
+void f() {}
+void fp(void*) {}
+
+// coarsest tick up to maxTick serving all the intervals within tolerance, the plain way
+unsigned long referenceTick(const unsigned long* intervals, int n, unsigned long maxTick, unsigned long tolerance)
+{
+  for (unsigned long tick = maxTick; tick > 1; tick--)
+  {
+    bool serves = true;
+
+    for (int i = 0; serves && (i < n); i++)
+    {
+      unsigned long rem   = intervals[i] % tick;
+      unsigned long error = (rem < tick - rem) ? rem : tick - rem;
+
+      serves = (intervals[i] >= tick) && (error * 100 <= intervals[i] * tolerance);
+    }
+
+    if (serves)
+      return tick;
+  }
+
+  return 1;
+}
+
+int main()
+{
+  ITimer.attachInterruptInterval(1000, TimerHandler);
+
+  CHECK(!ISR_Timer.enableAutoTick(ITimer, 0));
+  CHECK(!ISR_Timer.enableAutoTick(ITimer, 1000, 51));
+  CHECK(ISR_Timer.enableAutoTick(ITimer, 1000));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 1000);
+
+  int a = ISR_Timer.setInterval(1000, f);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 1000);
+
+  int b = ISR_Timer.setInterval(1500, f);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 500);
+
+  int c = ISR_Timer.setInterval(333, f);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 1);
+
+  // an exempt timer doesn't count
+  CHECK(ISR_Timer.setAutoTickExempt(c));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 500);
+  CHECK(ISR_Timer.changeInterval(c, 7));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 500);
+  CHECK(ISR_Timer.setAutoTickExempt(c, false));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 1);
+  ISR_Timer.deleteTimer(c);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 500);
+
+  // the exemption goes with the timer
+  c = ISR_Timer.setInterval(7, f);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 1);
+  ISR_Timer.deleteTimer(c);
+  CHECK(!ISR_Timer.setAutoTickExempt(c));
+
+  // 1500 ms at 3x are 500 ms of real time
+  int dom = ISR_Timer.addTimeDomain("x3");
+  CHECK(ISR_Timer.setTimerDomain(b, dom));
+  CHECK(ISR_Timer.setDomainRate(dom, 3.0f));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 500);
+  CHECK(ISR_Timer.setDomainRate(dom, 1.0f));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 500);
+
+  // all the steps of a sequence count
+  static const timer_step_t steps[] = { { 200, fp, NULL }, { 300, fp, NULL } };
+  static timer_sequence_t   seq     = { steps, 2, 0 };
+
+  int s = ISR_Timer.setSequence(seq);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 100);
+  ISR_Timer.deleteTimer(s);
+  ISR_Timer.deleteTimer(a);
+  ISR_Timer.deleteTimer(b);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 1000);
+
+  // long intervals with the largest maxTickMs: the largest divisor <= maxTickMs of the GCD
+  ISR_Timer.disableAutoTick();
+  CHECK(ISR_Timer.enableAutoTick(ITimer, 3600000));
+  a = ISR_Timer.setInterval(7200000, f);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 3600000);
+  b = ISR_Timer.setInterval(86400000, f);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 3600000);
+  c = ISR_Timer.setInterval(86399993, f);   // prime: 1
+  CHECK_EQ(ISR_Timer.getAutoTick(), 1);
+  ISR_Timer.deleteTimer(c);
+  c = ISR_Timer.setInterval(4 * 1000003UL, f);   // GCD 4
+  CHECK_EQ(ISR_Timer.getAutoTick(), 4);
+  ISR_Timer.deleteTimer(a);
+  ISR_Timer.deleteTimer(b);
+  CHECK_EQ(ISR_Timer.getAutoTick(), 2000006);
+  ISR_Timer.deleteTimer(c);
+
+  // random sets against the exhaustive search, with and without tolerance
+  srand(47);
+
+  for (int round = 0; round < 300; round++)
+  {
+    unsigned long maxTick   = 1 + rand() % 2000;
+    unsigned long tolerance = (round % 3) ? rand() % 20 : 0;
+    unsigned long intervals[4];
+    int           n         = 1 + rand() % 4;
+    int           ids[4];
+
+    ISR_Timer.disableAutoTick();
+
+    for (int i = 0; i < n; i++)
+    {
+      intervals[i] = 1 + rand() % 3000;
+      ids[i]       = ISR_Timer.setInterval(intervals[i], f);
+    }
+
+    CHECK(ISR_Timer.enableAutoTick(ITimer, maxTick, tolerance));
+
+    unsigned long expected = referenceTick(intervals, n, maxTick, tolerance);
+
+    if (ISR_Timer.getAutoTick() != expected)
+      printf("round %d: max %lu tolerance %lu n %d\n", round, maxTick, tolerance, n);
+
+    CHECK_EQ(ISR_Timer.getAutoTick(), expected);
+
+    for (int i = 0; i < n; i++)
+      ISR_Timer.deleteTimer(ids[i]);
+  }
+
+  // the hardware timer follows the tick
+  ISR_Timer.disableAutoTick();
+  ISR_Timer.setInterval(250, f);
+  CHECK(ISR_Timer.enableAutoTick(ITimer, 1000));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 250);
+
+  return TEST_END();
+}
@@ -0,0 +1,93 @@
+// ESP32_CoScheduler: sleep_for(), event and tick waits with timeout, and the yield of tick() through
+// ESP32_ISR_Timer::requestYield(). Built with -std=gnu++20
+#define USING_ESP32_S2_TIMER_COROUTINE      true
+
+#include "test.h"
+#include "ESP32_S2_TimerInterrupt.h"
+#include "ESP32_S2_ISR_Timer.h"
+#include "ESP32_S2_TimerCoroutine.h"
+
+ESP32_CoScheduler scheduler;
+ESP32_CoEvent     event(scheduler);
+ESP32_CoTick      coTick(scheduler);
+ESP32_ISR_Timer   ISR_Timer;
+
+int trace[32];
+int numTrace = 0;
+
+ESP32_CoTask sleeper()
+{
+  for (int i = 0; i < 3; i++)
+  {
+    co_await sleep_for(1000);
+    trace[numTrace++] = 100 + i;
+  }
+}
+
+ESP32_CoTask waiter()
+{
+  bool set = co_await event.wait(5000);
+  trace[numTrace++] = set ? 200 : 201;
+
+  set = co_await event.wait(2000);
+  trace[numTrace++] = set ? 202 : 203;
+}
+
+ESP32_CoTask ticker()
+{
+  for (int i = 0; i < 2; i++)
+  {
+    co_await next_tick(coTick);
+    trace[numTrace++] = 300 + i;
+  }
+}
+
+void IRAM_ATTR schedulerTick()
+{
+  if (scheduler.tick())
+    ISR_Timer.requestYield();
+}
+
+int main()
+{
+  scheduler.spawn(sleeper());
+  scheduler.spawn(waiter());
+  scheduler.spawn(ticker());
+  CHECK_EQ(scheduler.getNumSpawned(), 3);
+
+  // every 500 us: the event is set at 2.5 ms, the tick signalled at 0.5, 2 and 3.5 ms
+  for (int t = 0; t < 10; t++)
+  {
+    g_us += 500;
+    scheduler.tick();
+
+    if (t == 4)
+      event.set();
+
+    if (t % 3 == 0)
+      coTick.signal();
+
+    scheduler.runReady();
+  }
+
+  static const int expected[] = { 100, 300, 101, 200, 102, 301, 203 };
+
+  CHECK_EQ(numTrace, 7);
+
+  for (int i = 0; i < numTrace; i++)
+    CHECK_EQ(trace[i], expected[i]);
+
+  // the yield of tick() called by an ESP32_ISR_Timer callback comes back from run()
+  scheduler.spawn(sleeper());
+  scheduler.runReady();
+  CHECK(ISR_Timer.setInterval(1, schedulerTick) >= 0);
+
+  g_inISR = 1;
+  g_us   += 1000;
+  CHECK(ISR_Timer.run());       // the sleeper is due: the runner task is woken
+  g_us   += 1000;
+  CHECK(!ISR_Timer.run());      // already in the ready queue
+  g_inISR = 0;
+
+  return TEST_END();
+}
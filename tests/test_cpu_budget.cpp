@@ -0,0 +1,83 @@
+// ESP32_ISR_Timer CPU budget (-DUSING_ISR_TIMER_CPU_BUDGET=true): a TIMER_BUDGET_DEFER timer demoted by an overrun,
+// its last run deferred to runDeferred(), which only deletes the slot if it still holds the same timer
+#include "test.h"
+#include "ESP32_S2_ISR_Timer.h"
+
+extern uint32_t g_ccount;
+
+ESP32_ISR_Timer ISR_Timer;
+
+int slowRuns  = 0;
+int quickRuns = 0;
+int slowId    = -1;
+int quickId   = -1;
+
+void quick() { quickRuns++; }
+
+// 1 ms of CPU at 240 MHz
+void slow()
+{
+  slowRuns++;
+  g_ccount += 240000;
+}
+
+// the deferred last run replaces its own timer
+void slowReplaced()
+{
+  slow();
+
+  if (slowRuns == 2)
+  {
+    ISR_Timer.deleteTimer(slowId);
+    quickId = ISR_Timer.setInterval(10, quick);
+  }
+}
+
+void tick(const int& ms)
+{
+  for (int t = 0; t < ms; t++)
+  {
+    g_us += 1000;
+    ISR_Timer.run();
+  }
+}
+
+int main()
+{
+  ISR_Timer.init();
+
+  // 2 runs: the first one overruns in run(), the last one is deferred and deletes the timer in runDeferred()
+  slowId = ISR_Timer.setTimer(10, slow, 2);
+  CHECK(ISR_Timer.setBudget(slowId, 100, TIMER_BUDGET_DEFER));
+
+  tick(20);
+
+  timer_stats_t stats;
+
+  CHECK(ISR_Timer.getTimerStats(slowId, stats));
+  CHECK(stats.demoted);
+  CHECK_EQ(stats.numOverruns, 1);
+  CHECK_EQ(stats.pendingCalls, 1);
+  CHECK_EQ(slowRuns, 1);
+
+  CHECK_EQ(ISR_Timer.runDeferred(), 1);
+  CHECK_EQ(slowRuns, 2);
+  CHECK_EQ(ISR_Timer.getNumTimers(), 0);
+
+  // the same, but the slot is deleted and taken again by the deferred callback: the new timer is kept
+  slowRuns  = 0;
+  slowId    = ISR_Timer.setTimer(10, slowReplaced, 2);
+  CHECK(ISR_Timer.setBudget(slowId, 100, TIMER_BUDGET_DEFER));
+
+  tick(20);
+  CHECK_EQ(ISR_Timer.runDeferred(), 1);
+  CHECK_EQ(slowRuns, 2);
+  CHECK_EQ(quickId, slowId);
+  CHECK_EQ(ISR_Timer.getNumTimers(), 1);
+  CHECK(ISR_Timer.isEnabled(quickId));
+
+  tick(20);
+  CHECK_EQ(quickRuns, 2);
+
+  return TEST_END();
+}
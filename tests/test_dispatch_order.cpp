@@ -0,0 +1,74 @@
+// ESP32_ISR_Timer::setDispatchOrder(): order of the timers due in the same run(), by slot, by priority class, and by
+// earliest deadline, equal deadlines and priorities keeping the slot order
+#include "test.h"
+#include "ESP32_S2_ISR_Timer.h"
+
+#include <string.h>
+
+ESP32_ISR_Timer ISR_Timer;
+
+char order[16];
+int  numCalls = 0;
+
+void record(void* p)
+{
+  order[numCalls++] = *(char*) p;
+  order[numCalls]   = 0;
+}
+
+char A = 'a', B = 'b', C = 'c', D = 'd';
+
+// the calls of the run() at 'ms', all 4 timers being due then
+const char* dispatch(const unsigned long& ms)
+{
+  for (unsigned long t = g_us / 1000; t < ms; t++)
+  {
+    numCalls = 0;
+    order[0] = 0;
+
+    g_us += 1000;
+    ISR_Timer.run();
+  }
+
+  return order;
+}
+
+int main()
+{
+  ISR_Timer.init();
+
+  // slots 0 to 3: deadlines 40, 30, 40, 30 ms at the run() of 20 ms. c is the only high priority timer
+  CHECK_EQ(ISR_Timer.setInterval(20, record, &A), 0);
+  CHECK_EQ(ISR_Timer.setInterval(10, record, &B), 1);
+  CHECK_EQ(ISR_Timer.setInterval(20, record, &C), 2);
+  CHECK_EQ(ISR_Timer.setInterval(10, record, &D), 3);
+
+  CHECK(ISR_Timer.setPriority(2, TIMER_PRIORITY_HIGH));
+  CHECK(!ISR_Timer.setPriority(2, TIMER_PRIORITY_CRITICAL + 1));
+  CHECK(!ISR_Timer.setPriority(4, TIMER_PRIORITY_HIGH));
+  CHECK_EQ(ISR_Timer.getPriority(2), TIMER_PRIORITY_HIGH);
+  CHECK_EQ(ISR_Timer.getPriority(3), TIMER_PRIORITY_NORMAL);
+
+  CHECK_EQ(ISR_Timer.getDispatchOrder(), TIMER_DISPATCH_SLOT);
+  CHECK(strcmp(dispatch(20), "abcd") == 0);
+
+  ISR_Timer.setDispatchOrder(TIMER_DISPATCH_PRIORITY);
+  CHECK(strcmp(dispatch(40), "cabd") == 0);
+
+  // b and d share the earliest deadline: slot order between them
+  ISR_Timer.setDispatchOrder(TIMER_DISPATCH_EDF);
+  CHECK(strcmp(dispatch(60), "cbda") == 0);
+
+  // same priority class for all: earliest deadlines first, then the slot order
+  CHECK(ISR_Timer.setPriority(2, TIMER_PRIORITY_NORMAL));
+  CHECK(strcmp(dispatch(80), "bdac") == 0);
+
+  // only the timers due: b and d alone at 90 ms
+  CHECK(strcmp(dispatch(90), "bd") == 0);
+
+  // an invalid order is ignored
+  ISR_Timer.setDispatchOrder(TIMER_DISPATCH_EDF + 1);
+  CHECK_EQ(ISR_Timer.getDispatchOrder(), TIMER_DISPATCH_EDF);
+
+  return TEST_END();
+}
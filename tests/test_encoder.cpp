@@ -0,0 +1,100 @@
+// ESP32_TimerEncoder: the packed transition table against the quadrature Gray sequence, and decoding through the ISR
+// in both directions, with reversed encoders, pins above 31 and missed states
+#include "test.h"
+#include "ESP32_S2_TimerEncoder.h"
+
+volatile gpio_dev_t GPIO;
+
+ESP32Timer          ITimer(0);
+ESP32_TimerEncoder  Encoder;
+
+// forward sequence of AB
+static const uint8_t gray[4] = { 0, 1, 3, 2 };
+
+int step(const uint8_t& from, const uint8_t& to)
+{
+  int k = 0;
+
+  while (gray[k] != from)
+    k++;
+
+  if (gray[(k + 1) & 3] == to)
+    return 1;
+
+  if (gray[(k + 3) & 3] == to)
+    return -1;
+
+  return 0;
+}
+
+void setPins(const uint8_t& pinA, const uint8_t& pinB, const uint8_t& state)
+{
+  uint64_t pins = ( ( (uint64_t) GPIO.in1.val ) << 32 ) | GPIO.in;
+
+  pins &= ~( (1ULL << pinA) | (1ULL << pinB) );
+  pins |= ( (uint64_t) (state >> 1) << pinA ) | ( (uint64_t) (state & 1) << pinB );
+
+  GPIO.in         = (uint32_t) pins;
+  GPIO.in1.val    = (uint32_t) (pins >> 32);
+}
+
+int main()
+{
+  // all 16 transitions
+  for (uint8_t from = 0; from < 4; from++)
+  {
+    for (uint8_t to = 0; to < 4; to++)
+    {
+      uint8_t index   = (from << 2) | to;
+      int     delta   = (int) ( (ENCODER_TRANSITION_TABLE >> (index << 1)) & 3 ) - 1;
+      bool    invalid = (ENCODER_INVALID_TRANSITIONS >> index) & 1;
+
+      CHECK_EQ(delta, step(from, to));
+      CHECK_EQ(invalid, (from ^ to) == 3);
+    }
+  }
+
+  // both pins low at start (stub digitalRead() returns 0)
+  int8_t a = Encoder.addEncoder(4, 5);
+  int8_t b = Encoder.addEncoder(33, 34, true);
+
+  CHECK(ITimer.attachInterruptInterval(10, NULL));
+  CHECK(Encoder.begin(ITimer));
+
+  // a forward, b backward: both count up
+  for (int k = 1; k <= 40; k++)
+  {
+    setPins(4, 5, gray[k & 3]);
+    setPins(33, 34, gray[(40 - k) & 3]);
+    stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  }
+
+  CHECK_EQ(Encoder.getPosition(a), 40);
+  CHECK_EQ(Encoder.getPosition(b), 40);
+
+  // no change, no count
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(Encoder.getPosition(a), 40);
+
+  // a backward 10 steps
+  for (int k = 39; k >= 30; k--)
+  {
+    setPins(4, 5, gray[k & 3]);
+    stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  }
+
+  CHECK_EQ(Encoder.getPosition(a), 30);
+  CHECK_EQ(Encoder.getErrors(a), 0);
+
+  // a missed state: both pins change, no count, one error
+  setPins(4, 5, gray[(30 + 2) & 3]);
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(Encoder.getPosition(a), 30);
+  CHECK_EQ(Encoder.getErrors(a), 1);
+  CHECK_EQ(Encoder.getErrors(b), 0);
+
+  Encoder.setPosition(b, -5);
+  CHECK_EQ(Encoder.getPosition(b), -5);
+
+  return TEST_END();
+}
@@ -0,0 +1,78 @@
+// ESP32_ISR_Timer::setLazyTimeout(): a kick() just before the expiry re-arms the timeout from the kick, without any
+// call, a one-shot timeout is deleted after it fires, and a TIMER_RUN_FOREVER one fires every period while idle
+#include "test.h"
+#include "ESP32_S2_ISR_Timer.h"
+
+ESP32_ISR_Timer   ISR_Timer;
+ESP32_ISR_Timeout keepalive;
+ESP32_ISR_Timeout watchdog;
+
+int           fired[2];
+unsigned long lastFired[2];
+
+void expired(void* p)
+{
+  int k = *(int*) p;
+
+  fired[k]++;
+  lastFired[k] = g_us / 1000;
+}
+
+int zero = 0, one = 1;
+
+// runs run() every ms up to 'ms', kicking 'timeout' at 'kickMs' right after that run()
+void runTo(const unsigned long& ms, ESP32_ISR_Timeout* timeout = NULL, const unsigned long& kickMs = 0)
+{
+  while (g_us / 1000 < (long long) ms)
+  {
+    g_us += 1000;
+    ISR_Timer.run();
+
+    if (timeout && (g_us / 1000 == (long long) kickMs))
+      timeout->kick();
+  }
+}
+
+int main()
+{
+  ISR_Timer.init();
+
+  // one-shot, 100 ms, kicked at 99 ms: due at 100 ms, but re-armed to 199 ms
+  int id = ISR_Timer.setLazyTimeout(keepalive, 100, expired, &zero);
+  CHECK_EQ(id, 0);
+  CHECK_EQ(keepalive.getTimer(), id);
+
+  // always in real time
+  CHECK(!ISR_Timer.setTimerDomain(id, TIMER_DOMAIN_REALTIME));
+
+  runTo(100, &keepalive, 99);
+  CHECK_EQ(fired[0], 0);
+  CHECK(ISR_Timer.isUsed(id));
+
+  runTo(198);
+  CHECK_EQ(fired[0], 0);
+
+  runTo(199);
+  CHECK_EQ(fired[0], 1);
+  CHECK_EQ(lastFired[0], 199);
+
+  // deleted after its run, and no longer known by its timeout object
+  CHECK(!ISR_Timer.isUsed(id));
+  CHECK_EQ(keepalive.getTimer(), -1);
+
+  // forever, 50 ms from 199 ms: fires every 50 ms while idle, kicked at 348 ms, just before its 3rd expiry
+  CHECK(ISR_Timer.setLazyTimeout(watchdog, 50, expired, &one, TIMER_RUN_FOREVER) >= 0);
+
+  runTo(300);
+  CHECK_EQ(fired[1], 2);
+  CHECK_EQ(lastFired[1], 299);
+
+  runTo(397, &watchdog, 348);
+  CHECK_EQ(fired[1], 2);
+
+  runTo(398);
+  CHECK_EQ(fired[1], 3);
+  CHECK_EQ(lastFired[1], 398);
+
+  return TEST_END();
+}
@@ -0,0 +1,178 @@
+// ESP32_ISR_LongTimer: deadline heap, periodic / aligned / cron runs, cron deadlines computed by the cron task,
+// woken through ESP32_ISR_Timer::notifyFromRun(), the exemption of its slot from the automatic tick, and jobs added
+// before init()
+#include "test.h"
+#include <Arduino.h>
+
+// heap and cron internals
+#define private public
+#include "ESP32_S2_TimerInterrupt.h"
+#include "ESP32_S2_ISR_Timer.h"
+#include "ESP32_S2_ISR_LongTimer.h"
+#undef private
+
+ESP32Timer          ITimer(0);
+ESP32_ISR_Timer     ISR_Timer;
+ESP32_ISR_LongTimer LongTimer;
+
+extern int          g_notifyLocked;
+extern TaskHandle_t g_notifyTask;
+
+int hits[MAX_NUMBER_LONG_TIMERS];
+int cronWakes = 0;
+
+void count(void* p)
+{
+  hits[(uintptr_t) p]++;
+}
+
+bool heapValid()
+{
+  for (uint8_t k = 0; k < LongTimer._heapSize; k++)
+  {
+    if (LongTimer._heapPos[LongTimer._heap[k]] != k)
+      return false;
+
+    if ( (k > 0) && LongTimer.heapBefore(k, (k - 1) / 2) )
+      return false;
+  }
+
+  return true;
+}
+
+bool IRAM_ATTR TimerHandler(void*)
+{
+  return ISR_Timer.run();
+}
+
+int main()
+{
+  ITimer.attachInterruptInterval(100000, TimerHandler);
+
+  ISR_Timer.setInterval(100, (timer_callback) NULL);    // rejected
+  ISR_Timer.setInterval(100, count, (void*) (uintptr_t) (MAX_NUMBER_LONG_TIMERS - 1));
+  CHECK(ISR_Timer.enableAutoTick(ITimer, 1000));
+  CHECK_EQ(ISR_Timer.getAutoTick(), 100);
+
+  CHECK(LongTimer.init(ISR_Timer));
+
+  // the slot of the long timer, re-armed at each run, doesn't move the tick
+  LongTimer.setWallClock(1700000000000ULL);   // Tue Nov 14 2023 22:13:20 UTC
+  CHECK_EQ(ISR_Timer.getAutoTick(), 100);
+
+  // periodic jobs of 1 to 20 minutes
+  srand(26);
+
+  uint64_t periods[20];
+
+  for (int i = 0; i < 20; i++)
+  {
+    periods[i] = 60000ULL * (1 + rand() % 20);
+    CHECK_EQ(LongTimer.setInterval(periods[i], count, (void*) (uintptr_t) i), i);
+    CHECK(heapValid());
+  }
+
+  // every hour on the hour, and Monday / Friday 08:30
+  CHECK_EQ(LongTimer.setAligned(3600000, 0, count, (void*) 20), 20);
+
+  long_timer_cron_t cron = { 1ULL << 30, 1UL << 8, LONG_TIMER_MONDAY | LONG_TIMER_FRIDAY };
+
+  CHECK_EQ(LongTimer.setCron(cron, count, (void*) 21), 21);
+  CHECK(LongTimer._cronTask != NULL);
+  CHECK_EQ(LongTimer.getNextRun(21) + LongTimer._epochOffset, 1700209800000ULL);   // Fri Nov 17 08:30
+  CHECK_EQ(LongTimer.getNextRun(20) + LongTimer._epochOffset, 1700002800000ULL);   // Tue Nov 14 23:00
+  CHECK_EQ(LongTimer.getNumTimers(), 22);
+  CHECK(heapValid());
+
+  // 4 days, 100 ms ticks
+  uint64_t start = LongTimer.now();
+
+  g_inISR = 1;
+
+  for (long t = 0; t < 4L * 86400 * 10; t++)
+  {
+    g_us += 100000;
+    ISR_Timer.run();
+
+    // the cron task, woken by run() out of its lock
+    if (LongTimer._jobs[21].cronPending)
+    {
+      CHECK_EQ(LongTimer._heapPos[21], LONG_TIMER_NOT_IN_HEAP);
+      CHECK(g_notifyTask == LongTimer._cronTask);
+      CHECK(!LongTimer._cronWake);
+
+      cronWakes++;
+      g_notifyTask = NULL;
+      g_inISR = 0;
+      LongTimer.updateCronJobs();
+      g_inISR = 1;
+    }
+
+    if ( (t % 1000) == 0 )
+      CHECK(heapValid());
+  }
+
+  g_inISR = 0;
+
+  uint64_t elapsed = LongTimer.now() - start;
+
+  for (int i = 0; i < 20; i++)
+    CHECK_EQ(hits[i], elapsed / periods[i]);
+
+  CHECK_EQ(hits[20], 4 * 24);
+  CHECK_EQ(hits[21], 1);
+  CHECK_EQ(cronWakes, 1);
+  CHECK_EQ(g_notifyLocked, 0);
+  CHECK_EQ(LongTimer.getNextRun(21) + LongTimer._epochOffset, 1700469000000ULL);   // Mon Nov 20 08:30
+  CHECK_EQ(ISR_Timer.getAutoTick(), 100);
+
+  // deleted jobs leave the heap, the next deadline is the top
+  for (int i = 0; i < 20; i += 2)
+    LongTimer.deleteTimer(i);
+
+  CHECK(heapValid());
+  CHECK_EQ(LongTimer.getNumTimers(), 12);
+
+  uint64_t nearest = 0;
+
+  for (int i = 0; i < MAX_NUMBER_LONG_TIMERS; i++)
+  {
+    if ( (LongTimer._jobs[i].callback != NULL) && ( (nearest == 0) || (LongTimer.getNextRun(i) < nearest) ) )
+      nearest = LongTimer.getNextRun(i);
+  }
+
+  CHECK_EQ(LongTimer.getNextDeadline(), nearest);
+
+  // one-shot
+  int once = LongTimer.setTimeout(500, count, (void*) 0);
+
+  hits[0] = 0;
+
+  for (int t = 0; t < 20; t++)
+  {
+    g_us += 100000;
+    ISR_Timer.run();
+  }
+
+  CHECK_EQ(hits[0], 1);
+  CHECK(LongTimer._jobs[once].callback == NULL);
+  CHECK(heapValid());
+
+  // added before init(): armed by init(), not an hour later
+  ESP32_ISR_LongTimer early;
+
+  CHECK_EQ(early.setTimeout(500, count, (void*) 0), 0);
+  CHECK(early.init(ISR_Timer));
+
+  hits[0] = 0;
+
+  for (int t = 0; t < 5; t++)
+  {
+    g_us += 100000;
+    ISR_Timer.run();
+  }
+
+  CHECK_EQ(hits[0], 1);
+
+  return TEST_END();
+}
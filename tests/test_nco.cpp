@@ -0,0 +1,96 @@
+// ESP32TimerInterrupt NCO mode: attachInterruptExact() periods alternating between N and N + 1 counts, exact in the
+// long run, glitch-free changeFrequencyExact(), getExactFrequency(), and changeInterval() back to whole periods
+#include "test.h"
+#include "ESP32_S2_TimerInterrupt.h"
+
+#include <math.h>
+
+extern uint64_t g_alarm;
+
+ESP32Timer ITimer(0);
+
+int  numShort  = 0;
+int  numLong   = 0;
+bool nOrNPlus1 = true;
+
+// runs n alarms, and checks that the periods are N or N + 1 counts
+void fire(const int& n, const uint64_t& count)
+{
+  for (int i = 0; i < n; i++)
+  {
+    stubFireTimer(TIMER_GROUP_0, TIMER_0);
+
+    if (g_alarm == count)
+      numShort++;
+    else if (g_alarm == count + 1)
+      numLong++;
+    else
+      nOrNPlus1 = false;
+  }
+}
+
+int main()
+{
+  // not started yet, or less than 2 counts per period
+  CHECK(!ITimer.changeFrequencyExact(44100.0));
+  CHECK(!ITimer.attachInterruptExact(0.0, NULL));
+  CHECK(!ITimer.attachInterruptExact(600000.0, NULL));
+
+  // 44.1 kHz from the 1 MHz counter: 22.675... counts
+  CHECK(ITimer.attachInterruptExact(44100.0, NULL));
+  CHECK(fabs(ITimer.getExactFrequency() - 44100.0) < 1e-4);
+
+  // the first period is the whole count of setFrequency(), the NCO takes over from its alarm
+  CHECK_EQ(g_alarm, 22);
+
+  fire(1, 22);
+
+  numShort  = 0;
+  numLong   = 0;
+
+  uint64_t start = ITimer.getTimestamp();
+
+  // 1 s: 44100 periods of 22 or 23 counts, 1000000 counts in all
+  fire(44100, 22);
+
+  CHECK(nOrNPlus1);
+  CHECK_EQ(numShort + numLong, 44100);
+  CHECK(llabs( (long long) (ITimer.getTimestamp() - start) - 1000000LL) <= 1);
+  CHECK(abs(numLong - 29800) <= 1);
+
+  // retune: the period already programmed ends as is, then 333.333... counts
+  CHECK(ITimer.changeFrequencyExact(3000.0));
+  CHECK(fabs(ITimer.getExactFrequency() - 3000.0) < 1e-6);
+
+  uint64_t programmed = g_alarm;
+
+  start = ITimer.getTimestamp();
+  fire(1, 333);
+  CHECK_EQ(ITimer.getTimestamp() - start, programmed);
+
+  numShort  = 0;
+  numLong   = 0;
+  start     = ITimer.getTimestamp();
+
+  // the phase accumulator is kept across the retune
+  fire(3000, 333);
+
+  CHECK(nOrNPlus1);
+  CHECK(llabs( (long long) (ITimer.getTimestamp() - start) - 1000000LL) <= 1);
+  CHECK(abs(numLong - 1000) <= 1);
+
+  // back to whole periods
+  CHECK(ITimer.changeInterval(1000));
+  CHECK(fabs(ITimer.getExactFrequency() - 1000.0) < 1e-9);
+
+  numShort  = 0;
+  numLong   = 0;
+  nOrNPlus1 = true;
+
+  fire(12, 1000);
+
+  CHECK(nOrNPlus1);
+  CHECK_EQ(numShort, 12);
+
+  return TEST_END();
+}
@@ -0,0 +1,120 @@
+// ESP32_ISR_Timer::enablePhaseStagger(): phase binning modulo the GCD of the periods, widened bins, getPeakLoad(),
+// and the callbacks per run() of aligned periods
+#include "test.h"
+#include <Arduino.h>
+
+// phase histogram
+#define private public
+#include "ESP32_S2_ISR_Timer.h"
+#undef private
+
+#define NUMBER_ISR_TIMERS   8
+
+unsigned  callsThisRun  = 0;
+unsigned  calls[NUMBER_ISR_TIMERS];
+long      firstRun[NUMBER_ISR_TIMERS];
+
+void doingSomething(void* p)
+{
+  intptr_t i = (intptr_t) p;
+
+  callsThisRun++;
+
+  if (calls[i]++ == 0)
+    firstRun[i] = g_us / 1000;
+}
+
+// most callbacks in one run() over 'ms'
+unsigned runFor(ESP32_ISR_Timer& timer, const unsigned& ms)
+{
+  unsigned maxCalls = 0;
+
+  for (unsigned t = 0; t < ms; t++)
+  {
+    g_us        += 1000;
+    callsThisRun = 0;
+
+    timer.run();
+
+    if (callsThisRun > maxCalls)
+      maxCalls = callsThisRun;
+  }
+
+  return maxCalls;
+}
+
+int main()
+{
+  g_us = 1000000;
+
+  // 1 to 8 s, not staggered: all due together every 840 s, 4 of them at 6 s
+  {
+    ESP32_ISR_Timer timer;
+    timer.init();
+
+    for (intptr_t i = 0; i < NUMBER_ISR_TIMERS; i++)
+      CHECK(timer.setInterval(1000L * (i + 1), doingSomething, (void*) i) >= 0);
+
+    CHECK_EQ(timer.getPeakLoad(), NUMBER_ISR_TIMERS);
+    CHECK_EQ(runFor(timer, 8000), 4);
+  }
+
+  memset(calls, 0, sizeof(calls));
+
+  ESP32_ISR_Timer timer;
+  timer.enablePhaseStagger(1);
+
+  unsigned long start = millis();
+
+  for (intptr_t i = 0; i < NUMBER_ISR_TIMERS; i++)
+    CHECK(timer.setInterval(1000L * (i + 1), doingSomething, (void*) i) >= 0);
+
+  // GCD of 1 s at 1 ms: ISR_TIMER_STAGGER_BINS bins widened to 8 ms
+  uint8_t       bins[ISR_TIMER_STAGGER_BINS];
+  unsigned      numBins;
+  unsigned long period;
+  unsigned long width;
+
+  CHECK_EQ(timer.phaseHistogram(bins, numBins, period, width, 0), 0);
+  CHECK_EQ(period, 1000);
+  CHECK_EQ(width, (1000 + ISR_TIMER_STAGGER_BINS - 1) / ISR_TIMER_STAGGER_BINS);
+  CHECK_EQ(numBins, (period + width - 1) / width);
+
+  unsigned numTimers = 0;
+
+  for (unsigned k = 0; k < numBins; k++)
+  {
+    CHECK(bins[k] <= 1);
+    numTimers += bins[k];
+  }
+
+  CHECK_EQ(numTimers, NUMBER_ISR_TIMERS);
+  CHECK_EQ(timer.getPeakLoad(), 1);
+
+  // one callback per run() at most, first runs moved earlier by less than one period, periods unchanged
+  CHECK_EQ(runFor(timer, 16000), 1);
+
+  for (int i = 0; i < NUMBER_ISR_TIMERS; i++)
+  {
+    CHECK( (firstRun[i] > (long) start) && (firstRun[i] <= (long) (start + 1000 * (i + 1))) );
+    CHECK_EQ(calls[i], 1 + (start + 16000 - firstRun[i]) / (1000 * (i + 1)));
+  }
+
+  // a period shorter than 2 bins is due at every phase, a one-shot is never moved
+  CHECK(timer.setInterval(10, doingSomething, (void*) 0) >= 0);
+  CHECK_EQ(timer.getPeakLoad(), 2);
+
+  int once = timer.setTimer(500, doingSomething, (void*) 1, TIMER_RUN_ONCE);
+  CHECK(once >= 0);
+  CHECK_EQ(timer.timer[once].prev_millis, millis());
+  CHECK_EQ(timer.getPeakLoad(), 2);
+
+  // not staggered any more
+  timer.disablePhaseStagger();
+
+  int late = timer.setInterval(2000, doingSomething, (void*) 2);
+  CHECK(late >= 0);
+  CHECK_EQ(timer.timer[late].prev_millis, millis());
+
+  return TEST_END();
+}
@@ -0,0 +1,90 @@
+// ESP32_TimerRateLimiter: GCRA bursts and refill, steady rate, wait times, idle periods and 32-bit timestamp wraps
+#include "test.h"
+#include "ESP32_S2_TimerRateLimiter.h"
+
+extern uint64_t g_hwcount;
+
+ESP32Timer              ITimer(0);
+ESP32_TimerRateLimiter  Limiter;
+
+int tryAcquireMany(int n)
+{
+  int acquired = 0;
+
+  for (int i = 0; i < n; i++)
+    acquired += Limiter.tryAcquire();
+
+  return acquired;
+}
+
+int main()
+{
+  // no timebase yet
+  CHECK(!Limiter.setRate(100.0f, 5));
+  CHECK(!Limiter.tryAcquire());
+  CHECK_EQ(Limiter.available(), 0);
+
+  // 100 s period: no alarm during the test, timestamps follow the counter
+  CHECK(ITimer.attachInterruptInterval(100000000ULL, NULL));
+
+  // invalid rates and bursts
+  CHECK(!Limiter.begin(ITimer, 0.0f, 5));
+  CHECK(!Limiter.begin(ITimer, 100.0f, 0));
+  CHECK(!Limiter.begin(ITimer, 2.0f * TIMER_SCALE, 1));      // more than 1 token per count
+  CHECK(!Limiter.begin(ITimer, 1.0f, 2200));                  // burst window over 2^31 counts
+
+  // 100 tokens/s, bursts of 5: starts full
+  CHECK(Limiter.begin(ITimer, 100.0f, 5));
+  CHECK_EQ(Limiter.getInterval(), 10000);
+  CHECK_EQ(Limiter.available(), 5);
+  CHECK_EQ(Limiter.getWaitTime(), 0);
+
+  Limiter.clearRejected();
+
+  CHECK_EQ(tryAcquireMany(10), 5);
+  CHECK_EQ(Limiter.getRejected(), 5);
+  CHECK_EQ(Limiter.available(), 0);
+  CHECK_EQ(Limiter.getWaitTime(), 10000);
+  CHECK_EQ(Limiter.getWaitTime(3), 30000);
+
+  // refill of 2.5 tokens: 2 taken at once, not a 3rd
+  g_hwcount += 25000;
+  CHECK_EQ(Limiter.available(), 2);
+  CHECK(Limiter.tryAcquire(2));
+  CHECK(!Limiter.tryAcquire());
+  CHECK_EQ(Limiter.getRejected(), 6);
+  CHECK_EQ(Limiter.getWaitTime(), 5000);
+
+  // more than the burst is never available
+  CHECK(!Limiter.tryAcquire(6));
+  CHECK_EQ(Limiter.getWaitTime(6), UINT32_MAX);
+
+  // steady rate: 1 s of tries every ms gets 100 tokens, the half token left before included
+  int acquired = 0;
+
+  for (int i = 0; i < 1000; i++)
+  {
+    g_hwcount += 1000;
+    acquired  += Limiter.tryAcquire();
+  }
+
+  CHECK_EQ(acquired, 100);
+
+  // long idle, far more than the burst window: full again
+  g_hwcount = 0xFFFFF000ULL;
+  CHECK_EQ(Limiter.available(), 5);
+  CHECK_EQ(tryAcquireMany(10), 5);
+
+  // the 32-bit theoretical arrival time wraps with the timestamp: still empty 8192 counts later
+  g_hwcount += 0x2000;
+  CHECK_EQ((uint32_t) ITimer.getTimestamp(), 0x1000);
+  CHECK_EQ(Limiter.available(), 0);
+  CHECK(!Limiter.tryAcquire());
+  CHECK_EQ(Limiter.getWaitTime(), 50000 - 0x2000 - 40000);
+
+  // reset() refills
+  Limiter.reset();
+  CHECK_EQ(Limiter.available(), 5);
+
+  return TEST_END();
+}
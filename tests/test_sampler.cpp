@@ -0,0 +1,98 @@
+// ESP32_TimerSampler: double-buffered blocks handed to the consumer task, overruns while it holds a block, the
+// timestamp of the first sample of a block, and the notification sent by the timer ISR out of its lock
+#include "test.h"
+#include "ESP32_S2_TimerSampler.h"
+
+extern int          g_notifyCalls;
+extern int          g_notifyLocked;
+extern TaskHandle_t g_notifyTask;
+
+#define BLOCK_SIZE    4
+
+ESP32Timer                                  ITimer(0);
+ESP32_TimerSampler<uint16_t, BLOCK_SIZE>    Sampler;
+
+uint16_t  numSamples = 0;
+uint64_t  sampleTimestamp[64];
+
+int       consumer = 0;
+
+uint16_t IRAM_ATTR readSample(void* context)
+{
+  CHECK(context == &numSamples);
+
+  sampleTimestamp[numSamples] = ITimer.getTimestamp();
+
+  return numSamples++;
+}
+
+void fire(const int& n)
+{
+  for (int i = 0; i < n; i++)
+    stubFireTimer(TIMER_GROUP_0, TIMER_0);
+}
+
+int main()
+{
+  CHECK(ITimer.attachInterruptInterval(1000, NULL));
+
+  CHECK(Sampler.begin(ITimer, readSample, &numSamples, 1, (TaskHandle_t) &consumer));
+  CHECK(!Sampler.begin(ITimer, readSample, &numSamples, 1, (TaskHandle_t) &consumer));
+  CHECK_EQ(Sampler.getBlockSize(), BLOCK_SIZE);
+
+  // no block before the first one is full
+  fire(BLOCK_SIZE - 1);
+  CHECK_EQ(g_notifyCalls, 0);
+  CHECK(Sampler.waitBlock(0) == NULL);
+
+  // full: the consumer is notified once, by the timer ISR, out of its lock
+  fire(1);
+  CHECK_EQ(g_notifyCalls, 1);
+  CHECK_EQ(g_notifyLocked, 0);
+  CHECK(g_notifyTask == (TaskHandle_t) &consumer);
+  CHECK_EQ(Sampler.getNumBlocks(), 1);
+
+  uint64_t          timestamp = 0;
+  const uint16_t*   block     = Sampler.waitBlock(0, &timestamp);
+
+  CHECK(block != NULL);
+
+  for (int i = 0; i < BLOCK_SIZE; i++)
+    CHECK_EQ(block[i], i);
+
+  CHECK_EQ(timestamp, sampleTimestamp[0]);
+  CHECK(timestamp > 0);
+
+  // the consumer still holds the block: the next one is overwritten
+  fire(BLOCK_SIZE);
+  CHECK_EQ(Sampler.getOverruns(), 1);
+  CHECK_EQ(Sampler.getNumBlocks(), 1);
+  CHECK_EQ(g_notifyCalls, 1);
+
+  Sampler.releaseBlock();
+  CHECK(Sampler.waitBlock(0) == NULL);
+
+  // the following one goes to the other buffer, its timestamp is the one of its own first sample
+  fire(BLOCK_SIZE);
+  CHECK_EQ(Sampler.getNumBlocks(), 2);
+  CHECK_EQ(g_notifyCalls, 2);
+
+  const uint16_t* next = Sampler.waitBlock(0, &timestamp);
+
+  CHECK(next != NULL);
+  CHECK(next != block);
+  CHECK_EQ(next[0], 2 * BLOCK_SIZE);
+  CHECK_EQ(next[BLOCK_SIZE - 1], 3 * BLOCK_SIZE - 1);
+  CHECK_EQ(timestamp, sampleTimestamp[2 * BLOCK_SIZE]);
+  CHECK(timestamp > sampleTimestamp[0]);
+
+  Sampler.releaseBlock();
+
+  // stopped
+  Sampler.end();
+  fire(BLOCK_SIZE);
+  CHECK_EQ(numSamples, 3 * BLOCK_SIZE);
+  CHECK_EQ(ITimer.getNumCallbacks(), 0);
+
+  return TEST_END();
+}
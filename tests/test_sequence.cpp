@@ -0,0 +1,89 @@
+// ESP32_ISR_Timer::setSequence(): steps armed from the due time of the previous one, a last step with delay 0 run in
+// the same run(), the sequence deleted after its last run, and the invalid sequences and registry entries rejected
+#include "test.h"
+#include "ESP32_S2_ISR_Timer.h"
+
+#include <string.h>
+
+ESP32_ISR_Timer ISR_Timer;
+
+char          log_[32];
+unsigned long when[32];
+int           numSteps = 0;
+
+void step(void* p)
+{
+  when[numSteps]    = g_us / 1000;
+  log_[numSteps++]  = *(char*) p;
+  log_[numSteps]    = 0;
+}
+
+char A = 'a', B = 'b', C = 'c';
+
+// pulse a, wait 10 ms, pulse b and c together, wait 5 ms, repeat
+const timer_step_t  steps[] = { { 5, step, &A }, { 10, step, &B }, { 0, step, &C } };
+timer_sequence_t    seq     = { steps, 3, 0 };
+timer_sequence_t    other   = { steps, 3, 0 };
+
+const timer_step_t  tooLong[] = { { 5, step, &A }, { TIMER_MAX_DELAY + 1, step, &B } };
+timer_sequence_t    badSeq    = { tooLong, 2, 0 };
+timer_sequence_t    noSteps   = { steps, 0, 0 };
+
+void runFor(const unsigned& ms)
+{
+  for (unsigned t = 0; t < ms; t++)
+  {
+    g_us += 1000;
+    ISR_Timer.run();
+  }
+}
+
+int main()
+{
+  ISR_Timer.init();
+
+  CHECK_EQ(ISR_Timer.setSequence(badSeq), -1);
+  CHECK_EQ(ISR_Timer.setSequence(noSteps), -1);
+
+  // twice
+  int id = ISR_Timer.setSequence(seq, 2);
+  CHECK_EQ(id, 0);
+  CHECK(!ISR_Timer.changeInterval(id, 10));
+
+  // a timer of the same steps, but another sequence object, isn't the registry entry of 'seq'
+  const timer_registry_t registry[] = { TIMER_REGISTRY_SEQUENCE(steps, other) };
+  timer_snapshot_t       snapshot;
+
+  CHECK_EQ(ISR_Timer.saveSnapshot(snapshot, registry, 1), -1);
+
+  runFor(15);
+
+  // the last step runs with the previous one, and the sequence is then armed for its first step
+  CHECK(strcmp(log_, "abc") == 0);
+  CHECK_EQ(when[0], 5);
+  CHECK_EQ(when[1], 15);
+  CHECK_EQ(when[2], 15);
+  CHECK_EQ(seq.curStep, 0);
+  CHECK_EQ(ISR_Timer.getNumTimers(), 1);
+
+  // from the due time of the last step, then deleted after it
+  runFor(50);
+
+  CHECK(strcmp(log_, "abcabc") == 0);
+  CHECK_EQ(when[3], 20);
+  CHECK_EQ(when[5], 30);
+  CHECK_EQ(ISR_Timer.getNumTimers(), 0);
+  CHECK(!ISR_Timer.isUsed(id));
+
+  // restarted at 75 ms, after its first step, from its first step
+  id = ISR_Timer.setSequence(seq);
+  runFor(10);
+  ISR_Timer.restartTimer(id);
+  runFor(5);
+
+  CHECK(strcmp(log_, "abcabcaa") == 0);
+  CHECK_EQ(when[6], 70);
+  CHECK_EQ(when[7], 80);
+
+  return TEST_END();
+}
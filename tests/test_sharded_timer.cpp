@@ -0,0 +1,143 @@
+// ESP32_ISR_ShardedTimer on a dual core build (-DportNUM_PROCESSORS=2): registration in the calling core's shard,
+// cross-core operations queued to the other shard, and the report of those failing when applied
+#include "test.h"
+#include "ESP32_S2_TimerInterrupt.h"
+#include "ESP32_S2_ISR_Timer.h"
+#include "ESP32_S2_ISR_ShardedTimer.h"
+
+extern int g_core;
+extern int g_critical;
+extern int g_notifyCalls;
+extern int g_notifyLocked;
+
+ESP32Timer              ITimer0(0);
+ESP32Timer              ITimer1(1);
+ESP32_ISR_ShardedTimer  ShardedTimer;
+
+int runs0       = 0;
+int runs1       = 0;
+int maxCritical = 0;
+
+void f0()
+{
+  runs0++;
+
+  if (g_critical > maxCritical)
+    maxCritical = g_critical;
+}
+
+void f1() { runs1++; }
+
+// 1 ms of both shards, each ISR on its core
+void tick(const int& ms)
+{
+  int core = g_core;
+
+  for (int i = 0; i < ms; i++)
+  {
+    g_us += 1000;
+
+    g_core = 0;
+    stubFireTimer(TIMER_GROUP_0, TIMER_0);
+
+    g_core = 1;
+    stubFireTimer(TIMER_GROUP_0, TIMER_1);
+  }
+
+  g_core = core;
+}
+
+int main()
+{
+  CHECK_EQ(ShardedTimer.getNumShards(), 2);
+
+  g_core = 0;
+  CHECK(ShardedTimer.attachShard(0, ITimer0, 1000));
+
+  g_core = 1;
+  CHECK(ShardedTimer.attachShard(1, ITimer1, 1000));
+  CHECK(!ShardedTimer.attachShard(1, ITimer1, 1000));
+
+  // registered in the shard of the calling core
+  g_core = 0;
+  int id0 = ShardedTimer.setInterval(10, f0);
+
+  g_core = 1;
+  int id1 = ShardedTimer.setInterval(10, f1);
+
+  CHECK_EQ(id0, SHARDED_TIMER_ID(0, 0));
+  CHECK_EQ(id1, SHARDED_TIMER_ID(1, 0));
+  CHECK_EQ(ShardedTimer.getNumTimers(), 2);
+
+  tick(50);
+  CHECK_EQ(runs0, 5);
+  CHECK_EQ(runs1, 5);
+
+  // only under the lock of the shard's ESP32_ISR_Timer, not the one of the hardware timer, and notifications of the
+  // shard sent out of any lock
+  CHECK_EQ(maxCritical, 1);
+
+  int task = 0;
+  int idn  = ShardedTimer.getShard(1).setTaskNotify(10, (TaskHandle_t) &task, 1);
+  CHECK(idn >= 0);
+
+  g_notifyCalls = 0;
+
+  tick(10);
+  CHECK_EQ(g_notifyCalls, 1);
+  CHECK_EQ(g_notifyLocked, 0);
+
+  ShardedTimer.getShard(1).deleteTimer(idn);
+
+  // from core 1, on the core 0 timer: queued, applied at the next tick of shard 0
+  CHECK(ShardedTimer.disable(id0));
+  CHECK(ShardedTimer.isEnabled(id0));
+
+  tick(50);
+  CHECK(!ShardedTimer.isEnabled(id0));
+  CHECK_EQ(runs0, 6);
+  CHECK_EQ(runs1, 11);
+
+  // the queue holds ESP32_SHARDED_TIMER_QUEUE_LEN operations until the next tick
+  for (int k = 0; k < ESP32_SHARDED_TIMER_QUEUE_LEN; k++)
+    CHECK(ShardedTimer.changeInterval(id0, 20));
+
+  CHECK(!ShardedTimer.changeInterval(id0, 20));
+
+  tick(1);
+  CHECK_EQ(ShardedTimer.getFailedOps(), 0);
+  CHECK_EQ(ShardedTimer.getLastFailedTimer(), -1);
+
+  // local operations are done at once
+  g_core = 0;
+  CHECK(ShardedTimer.deleteTimer(id0));
+  CHECK_EQ(ShardedTimer.getNumTimers(), 1);
+  CHECK(!ShardedTimer.enable(id0));
+
+  // from core 1 again: accepted, but fails when applied on core 0, the timer being deleted
+  g_core = 1;
+  CHECK(ShardedTimer.enable(id0));
+  CHECK(ShardedTimer.changeInterval(id0, 20));
+
+  tick(1);
+  CHECK_EQ(ShardedTimer.getFailedOps(), 2);
+  CHECK_EQ(ShardedTimer.getLastFailedTimer(), id0);
+
+  // an invalid interval fails too, on the other shard
+  g_core = 0;
+  CHECK(ShardedTimer.changeInterval(id1, TIMER_MAX_DELAY + 1));
+
+  tick(1);
+  CHECK_EQ(ShardedTimer.getFailedOps(), 3);
+  CHECK_EQ(ShardedTimer.getLastFailedTimer(), id1);
+
+  ShardedTimer.clearFailedOps();
+  CHECK_EQ(ShardedTimer.getFailedOps(), 0);
+  CHECK_EQ(ShardedTimer.getLastFailedTimer(), -1);
+
+  // invalid ids
+  CHECK(!ShardedTimer.deleteTimer(-1));
+  CHECK(!ShardedTimer.deleteTimer(SHARDED_TIMER_ID(2, 0)));
+
+  return TEST_END();
+}
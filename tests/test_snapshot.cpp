@@ -0,0 +1,138 @@
+// ESP32_ISR_Timer::saveSnapshot() / restoreSnapshot(): round trip with domains and sequences, timers done but not
+// deleted, and the registry checks
+#include "test.h"
+#include <Arduino.h>
+
+// run counters of the timers
+#define private public
+#include "ESP32_S2_ISR_Timer.h"
+#undef private
+
+unsigned      runs[128];
+unsigned long firstRun[128];
+
+char A = 'a', B = 'b', C = 'c', D = 'd';
+
+void record(char c)
+{
+  if (runs[(int) c]++ == 0)
+    firstRun[(int) c] = g_us / 1000;
+}
+
+void fa()         { record(A); }
+void fb(void* p)  { record(*(char*) p); }
+
+const timer_step_t  steps[] = { { 10, fb, &C }, { 20, fb, &D } };
+timer_sequence_t    seq     = { steps, 2, 0 };
+timer_sequence_t    other   = { steps, 2, 0 };
+
+const timer_registry_t registry[] =
+{
+  TIMER_REGISTRY_ENTRY(fa), TIMER_REGISTRY_ENTRY_P(fb, &B), TIMER_REGISTRY_SEQUENCE(steps, seq)
+};
+
+timer_snapshot_t snapshot;
+
+void runFor(ESP32_ISR_Timer& timer, unsigned ms)
+{
+  for (unsigned i = 0; i < ms; i++)
+  {
+    g_us += 1000;
+    timer.run();
+  }
+}
+
+int main()
+{
+  // save
+  {
+    ESP32_ISR_Timer timer;
+    timer.init();
+
+    int domain = timer.addTimeDomain("game");
+    CHECK_EQ(domain, 1);
+
+    CHECK_EQ(timer.setInterval(1000, fa), 0);
+    CHECK_EQ(timer.setTimer(300, fb, &B, 5), 1);
+    CHECK(timer.setTimerDomain(1, domain));
+    CHECK_EQ(timer.setSequence(seq), 2);
+    CHECK_EQ(timer.setInterval(7, fb, &A), 3);             // not in the registry
+
+    runFor(timer, 450);                                     // t = 450: fb(B) ran once, the sequence its 2nd step
+
+    CHECK_EQ(timer.saveSnapshot(snapshot, registry, 3), -1);
+
+    timer.deleteTimer(3);
+    timer.pauseDomain(domain);
+
+    // done but not deleted yet: would be restored as a run forever timer
+    CHECK_EQ(timer.setTimer(50, fb, &B, 2), 3);
+    timer.timer[3].numRuns = timer.timer[3].maxNumRuns;
+
+    CHECK_EQ(timer.saveSnapshot(snapshot, registry, 3), 3);
+    CHECK_EQ(snapshot.magic, TIMER_SNAPSHOT_MAGIC);
+    CHECK_EQ(snapshot.numEntries, 3);
+    CHECK(snapshot.domainPaused[domain]);
+
+    for (int i = 0; i < snapshot.numEntries; i++)
+      CHECK(snapshot.entries[i].slot != 3);
+  }
+
+  // restore after 2720 ms of deep sleep, at 3170 ms on the old clock
+  g_us = 0;
+  memset(runs, 0, sizeof(runs));
+
+  ESP32_ISR_Timer timer;
+
+  CHECK_EQ(timer.addTimeDomain("game"), 1);
+  CHECK_EQ(timer.restoreSnapshot(snapshot, registry, 3, 2720), 3);
+  CHECK_EQ(timer.getNumTimers(), 3);
+  CHECK(timer.timer[3].callback == NULL);
+
+  runFor(timer, 400);
+  timer.resumeDomain(1);
+  runFor(timer, 800);
+
+  // fa every 1000 ms, phase kept: the runs missed while sleeping coalesced into one, at once, then at 4000 (830)
+  CHECK_EQ(runs['a'], 2);
+  CHECK_EQ(firstRun['a'], 1);
+
+  // fb(B) paused 150 ms before its 2nd run, resumed at 400: runs at 550, 850, 1150
+  CHECK_EQ(runs['b'], 3);
+  CHECK_EQ(firstRun['b'], 550);
+  CHECK_EQ(timer.timer[1].numRuns, 3);
+
+  // the sequence saved 10 ms before its 1st step: late, run at once, then its 2nd step 20 ms later
+  CHECK_EQ(firstRun['c'], 1);
+  CHECK_EQ(firstRun['d'], 20);
+  CHECK_EQ(runs['c'], runs['d'] + 1);
+
+  // invalid snapshots and registries restore nothing
+  ESP32_ISR_Timer other_timer;
+  other_timer.addTimeDomain("game");
+
+  timer_snapshot_t bad = snapshot;
+  bad.magic = 1;
+  CHECK_EQ(other_timer.restoreSnapshot(bad, registry, 3, 0), -1);
+
+  // the sequence entry of the registry must be a sequence of its steps
+  const timer_registry_t swapped[] =
+  {
+    TIMER_REGISTRY_ENTRY(fa), TIMER_REGISTRY_ENTRY_P(fb, &B), TIMER_REGISTRY_ENTRY_P(fb, &seq)
+  };
+
+  CHECK_EQ(other_timer.restoreSnapshot(snapshot, swapped, 3, 0), -1);
+  CHECK_EQ(other_timer.getNumTimers(), 0);
+
+  const timer_registry_t otherSequence[] =
+  {
+    TIMER_REGISTRY_ENTRY(fa), TIMER_REGISTRY_ENTRY_P(fb, &B), TIMER_REGISTRY_SEQUENCE(steps, other)
+  };
+
+  CHECK_EQ(other_timer.restoreSnapshot(snapshot, otherSequence, 3, 0), 3);
+
+  // a registry shorter than the callback ids
+  CHECK_EQ(other_timer.restoreSnapshot(snapshot, registry, 2, 0), -1);
+
+  return TEST_END();
+}
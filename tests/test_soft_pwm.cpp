@@ -0,0 +1,70 @@
+// ESP32_SoftPWM: edges of one period, edges already due merged without waiting in the ISR, and begin() leaving no
+// chained callback behind on failure
+#include "test.h"
+#include "ESP32_S2_SoftPWM.h"
+
+extern uint64_t g_hwcount;
+extern uint64_t g_alarm;
+
+volatile gpio_dev_t GPIO;
+
+ESP32Timer    ITimer(0);
+ESP32Timer    BadTimer(5);
+ESP32_SoftPWM SoftPWM;
+
+void clearGPIO()
+{
+  GPIO.out_w1ts       = 0;
+  GPIO.out_w1tc       = 0;
+  GPIO.out1_w1ts.val  = 0;
+  GPIO.out1_w1tc.val  = 0;
+}
+
+int main()
+{
+  int8_t a = SoftPWM.addChannel(2);
+  int8_t b = SoftPWM.addChannel(5);
+  int8_t c = SoftPWM.addChannel(40);
+
+  // 1 kHz: 1000 counts
+  CHECK(SoftPWM.begin(ITimer, 1000.0f));
+  CHECK_EQ(ITimer.getNumCallbacks(), 1);
+
+  CHECK(SoftPWM.setDuty(a, 250, false));
+  CHECK(SoftPWM.setDuty(b, 254, false));     // merged with a, closer than SOFT_PWM_MIN_EDGE_COUNTS
+  CHECK(SoftPWM.setDuty(c, 600, false));
+  SoftPWM.apply();
+
+  // period start: all pins set, alarm at the first edge
+  clearGPIO();
+  g_hwcount = 2;
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(GPIO.out_w1ts, (1UL << 2) | (1UL << 5));
+  CHECK_EQ(GPIO.out1_w1ts.val, 1UL << (40 - 32));
+  CHECK_EQ(g_alarm, 250);
+  CHECK_EQ(SoftPWM.getNumEdges(), 2);
+
+  // first edge
+  clearGPIO();
+  g_hwcount = 1;
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(GPIO.out_w1tc, (1UL << 2) | (1UL << 5));
+  CHECK_EQ(g_alarm, 600 - 250);
+
+  // the ISR of the second edge runs late, 5 counts before the period end. The stub counter doesn't move, the old
+  // busy-wait would never end: the period start is applied at once, and the alarm armed for the next edge
+  clearGPIO();
+  g_hwcount = (1000 - 600) - 5;
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(GPIO.out1_w1tc.val, 1UL << (40 - 32));
+  CHECK_EQ(GPIO.out_w1ts, (1UL << 2) | (1UL << 5));
+  CHECK_EQ(g_alarm, (1000 - 600) + 250);
+
+  // a failed setFrequency() leaves no chained callback
+  ESP32_SoftPWM pwm;
+
+  CHECK(!pwm.begin(BadTimer, 1000.0f));
+  CHECK_EQ(BadTimer.getNumCallbacks(), 0);
+
+  return TEST_END();
+}
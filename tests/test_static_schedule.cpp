@@ -0,0 +1,57 @@
+// ESP32_ISR_StaticSchedule: runs of a checked table, numRuns entries, and the rejection by init() of an unchecked table
+// with a period below the tick
+#include "test.h"
+#include "ESP32_S2_ISR_StaticSchedule.h"
+
+int runs[3];
+
+void count(void* p)
+{
+  (*(int*) p)++;
+}
+
+constexpr ISRTimerSchedule_t schedule[] =
+{
+  // period (ms), callback, param, numRuns
+  {  10, count, &runs[0], TIMER_RUN_FOREVER },
+  {  30, count, &runs[1], 2 },
+};
+
+ISR_TIMER_STATIC_SCHEDULE(Schedule, schedule, 10);
+
+// not checked at compile time: 5 ms would never run with a 10 ms tick
+constexpr ISRTimerSchedule_t badSchedule[] =
+{
+  {  20, count, &runs[2], TIMER_RUN_FOREVER },
+  {   5, count, &runs[2], TIMER_RUN_FOREVER },
+};
+
+ESP32_ISR_StaticSchedule<ISR_TIMER_SCHEDULE_SIZE(badSchedule), 10> BadSchedule(badSchedule);
+
+static_assert(!ISRTimerScheduleValid(badSchedule, ISR_TIMER_SCHEDULE_SIZE(badSchedule), 10), "5 ms entry accepted");
+
+int main()
+{
+  CHECK(Schedule.init());
+
+  for (int t = 0; t < 10; t++)
+    Schedule.run();
+
+  CHECK_EQ(runs[0], 10);
+  CHECK_EQ(runs[1], 2);
+  CHECK(!Schedule.isEnabled(1));
+  CHECK(Schedule.enable(1));
+  CHECK_EQ(Schedule.getRunsLeft(1), 2);
+
+  // all entries disabled, none run
+  CHECK(!BadSchedule.init());
+  CHECK(!BadSchedule.isEnabled(0));
+  CHECK(!BadSchedule.enable(1));
+
+  for (int t = 0; t < 10; t++)
+    BadSchedule.run();
+
+  CHECK_EQ(runs[2], 0);
+
+  return TEST_END();
+}
@@ -0,0 +1,85 @@
+// ESP32_ISR_Timer::setTaskNotify(): one notification per task and run(), none sent under the lock, also with more
+// tasks than MAX_ISR_TIMER_NOTIFY_TASKS
+#include "test.h"
+#include "ESP32_S2_ISR_Timer.h"
+
+extern int          g_notifyCalls;
+extern uint32_t     g_notifyLast;
+extern int          g_notifyLocked;
+extern TaskHandle_t g_notifyTask;
+extern int          g_critical;
+
+ESP32_ISR_Timer ISR_Timer;
+
+int tasks[MAX_ISR_TIMER_NOTIFY_TASKS + 3];
+
+TaskHandle_t task(const int& k)
+{
+  return (TaskHandle_t) &tasks[k];
+}
+
+int main()
+{
+  ISR_Timer.init();
+
+  CHECK_EQ(ISR_Timer.setTaskNotify(10, task(0), 0), -1);
+
+  // 2 timers of the same task, coalesced
+  CHECK(ISR_Timer.setTaskNotify(10, task(0), 1) >= 0);
+  CHECK(ISR_Timer.setTaskNotify(10, task(0), 4) >= 0);
+
+  for (int k = 1; k < MAX_ISR_TIMER_NOTIFY_TASKS; k++)
+    CHECK(ISR_Timer.setTaskNotify(10, task(k), 1) >= 0);
+
+  g_inISR = 1;
+
+  bool woken = false;
+
+  for (int i = 0; i < 10; i++)
+  {
+    g_us  += 1000;
+    woken  = ISR_Timer.run();
+  }
+
+  CHECK(woken);
+  CHECK_EQ(g_notifyCalls, MAX_ISR_TIMER_NOTIFY_TASKS);
+  CHECK_EQ(g_notifyLocked, 0);
+
+  // more tasks than MAX_ISR_TIMER_NOTIFY_TASKS, the last ones once: notified in a second batch, then deleted
+  for (int k = MAX_ISR_TIMER_NOTIFY_TASKS; k < MAX_ISR_TIMER_NOTIFY_TASKS + 3; k++)
+    CHECK(ISR_Timer.setTaskNotify(10, task(k), 2 << k, (k == MAX_ISR_TIMER_NOTIFY_TASKS + 2) ? 1 : 2) >= 0);
+
+  unsigned numTimers = ISR_Timer.getNumTimers();
+
+  g_notifyCalls = 0;
+
+  for (int i = 0; i < 10; i++)
+  {
+    g_us  += 1000;
+    woken  = ISR_Timer.run();
+  }
+
+  CHECK(woken);
+  CHECK_EQ(g_notifyCalls, MAX_ISR_TIMER_NOTIFY_TASKS + 3);
+  CHECK_EQ(g_notifyLocked, 0);
+  CHECK(g_notifyTask == task(MAX_ISR_TIMER_NOTIFY_TASKS + 2));
+  CHECK_EQ(g_notifyLast, 2 << (MAX_ISR_TIMER_NOTIFY_TASKS + 2));
+  CHECK_EQ(ISR_Timer.getNumTimers(), numTimers - 1);
+
+  // from a task
+  g_inISR       = 0;
+  g_notifyCalls = 0;
+
+  for (int i = 0; i < 10; i++)
+  {
+    g_us += 1000;
+    ISR_Timer.run();
+  }
+
+  CHECK_EQ(g_notifyCalls, 100 * (MAX_ISR_TIMER_NOTIFY_TASKS + 2));
+  CHECK_EQ(g_notifyLocked, 0);
+  CHECK_EQ(ISR_Timer.getNumTimers(), numTimers - 3);
+  CHECK_EQ(g_critical, 0);
+
+  return TEST_END();
+}
@@ -0,0 +1,95 @@
+// ESP32_ISR_Timer time domains: a half rate domain kept exact across the rebase of its clock every 2^30 real ms, and
+// paused over more than 2^30 ms, its timer keeping its remaining domain time
+#include "test.h"
+#include <Arduino.h>
+
+// domain clock base
+#define private public
+#include "ESP32_S2_ISR_Timer.h"
+#undef private
+
+#define REBASE_MS     0x40000000UL
+
+ESP32_ISR_Timer ISR_Timer;
+
+int           runs     = 0;
+unsigned long lastRun  = 0;
+
+void count()
+{
+  runs++;
+  lastRun = millis();
+}
+
+void runFor(const unsigned long& ms, const unsigned long& stepMs = 1)
+{
+  for (unsigned long t = 0; t < ms; t += stepMs)
+  {
+    g_us += 1000LL * stepMs;
+    ISR_Timer.run();
+  }
+}
+
+int main()
+{
+  ISR_Timer.init();
+
+  int d = ISR_Timer.addTimeDomain("game");
+  CHECK_EQ(d, 1);
+  CHECK_EQ(ISR_Timer.findTimeDomain("game"), d);
+  CHECK(ISR_Timer.setDomainRate(d, 0.5));
+  CHECK(!ISR_Timer.pauseDomain(TIMER_DOMAIN_REALTIME));
+
+  int id = ISR_Timer.setInterval(100, count);
+  CHECK(ISR_Timer.setTimerDomain(id, d));
+  CHECK_EQ(ISR_Timer.getTimerDomain(id), d);
+
+  // 100 domain ms every 200 real ms
+  runFor(400);
+  CHECK_EQ(runs, 2);
+  CHECK_EQ(ISR_Timer.getDomainMillis(d), 200);
+
+  // past 2^30 real ms, in 1000 s steps: the clock is rebased once, and stays at half the real time
+  runFor(REBASE_MS + 2000000UL, 1000000UL);
+
+  unsigned long rebased = ISR_Timer.domains[d].baseReal;
+
+  CHECK(rebased >= REBASE_MS);
+  CHECK(rebased < REBASE_MS + 2000000UL);
+  CHECK_EQ(ISR_Timer.getDomainMillis(d), millis() / 2);
+
+  // the timer stays on its 100 domain ms grid: next run 200 real ms from now. 60 real ms later, 70 domain ms left
+  runs = 0;
+  runFor(200);
+  CHECK_EQ(runs, 1);
+  CHECK_EQ( (lastRun / 2) % 100, 0);
+
+  runFor(60);
+
+  // paused over more than 2^30 real ms: frozen, not rebased, no run
+  CHECK(ISR_Timer.pauseDomain(d));
+  CHECK(ISR_Timer.isDomainPaused(d));
+
+  unsigned long frozen = ISR_Timer.getDomainMillis(d);
+  unsigned long paused = ISR_Timer.domains[d].baseReal;
+
+  runFor(REBASE_MS + 2000000UL, 1000000UL);
+  CHECK_EQ(ISR_Timer.getDomainMillis(d), frozen);
+  CHECK_EQ(ISR_Timer.domains[d].baseReal, paused);
+  CHECK_EQ(runs, 1);
+
+  // resumed: the 70 domain ms left take 140 real ms
+  CHECK(ISR_Timer.resumeDomain(d));
+
+  unsigned long resumed = millis();
+
+  runFor(139);
+  CHECK_EQ(runs, 1);
+
+  runFor(1);
+  CHECK_EQ(runs, 2);
+  CHECK_EQ(lastRun, resumed + 140);
+  CHECK_EQ(ISR_Timer.getDomainMillis(d), frozen + 70);
+
+  return TEST_END();
+}
@@ -0,0 +1,129 @@
+// ESP32TimerInterrupt: interrupt allocation through timer_isr_register(), the handle / number / core reported, the
+// ISR checking and clearing the interrupt status and re-enabling the alarm, and chained callbacks and notifications
+// dispatched out of the lock
+#include "test.h"
+#include "ESP32_S2_TimerInterrupt.h"
+
+extern uint32_t g_intrStatus[2];
+extern int      g_alarmEnables;
+extern int      g_core;
+extern int      g_critical;
+extern int      g_notifyCalls;
+extern int      g_notifyLocked;
+
+ESP32Timer ITimer0(0);
+ESP32Timer ITimer1(1);
+
+int calls0 = 0;
+int calls1 = 0;
+
+bool IRAM_ATTR TimerHandler0(void*)
+{
+  calls0++;
+
+  return false;
+}
+
+bool IRAM_ATTR TimerHandler1(void*)
+{
+  calls1++;
+
+  return false;
+}
+
+int   tasks[MAX_ESP32_TIMER_NOTIFY_PENDING + MAX_ESP32_TIMER_NOTIFY];
+int   chainedCalls  = 0;
+int   chainedLocked = 0;
+bool  lastQueued    = true;
+
+// queues MAX_ESP32_TIMER_NOTIFY_PENDING tasks, then one more
+bool IRAM_ATTR Chained(void* context)
+{
+  ESP32TimerInterrupt* timer = (ESP32TimerInterrupt*) context;
+
+  chainedCalls++;
+  chainedLocked += (g_critical > 0);
+
+  for (int k = 0; k < MAX_ESP32_TIMER_NOTIFY_PENDING; k++)
+    timer->notifyFromISR((TaskHandle_t) &tasks[k], 1);
+
+  lastQueued = timer->notifyFromISR((TaskHandle_t) &tasks[MAX_ESP32_TIMER_NOTIFY_PENDING], 1);
+
+  return false;
+}
+
+int main()
+{
+  CHECK(ITimer0.getInterruptHandle() == NULL);
+  CHECK_EQ(ITimer0.getInterruptNumber(), -1);
+  CHECK_EQ(ITimer0.getInterruptCore(), -1);
+  CHECK_EQ(ITimer0.getAllocatedInterruptLevel(), 0);
+
+  CHECK(ITimer0.setInterruptLevel(3));
+  CHECK(ITimer0.attachInterruptInterval(1000, TimerHandler0));
+  CHECK(ITimer1.attachInterruptInterval(2000, TimerHandler1));
+
+  CHECK(ITimer0.getInterruptHandle() != NULL);
+  CHECK(ITimer0.getInterruptNumber() >= 0);
+  CHECK(ITimer0.getInterruptNumber() != ITimer1.getInterruptNumber());
+  CHECK_EQ(ITimer0.getInterruptCore(), 0);
+  CHECK_EQ(ITimer0.getInterruptLevel(), 3);
+  CHECK_EQ(ITimer0.getAllocatedInterruptLevel(), 3);
+
+  // timers 0 and 1 are timer 0 and 1 of group 0
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(calls0, 1);
+  CHECK_EQ(calls1, 0);
+  CHECK_EQ(g_intrStatus[0], 0);
+  CHECK_EQ(g_alarmEnables, 1);
+
+  stubFireTimer(TIMER_GROUP_0, TIMER_1);
+  CHECK_EQ(calls0, 1);
+  CHECK_EQ(calls1, 1);
+  CHECK_EQ(g_alarmEnables, 2);
+
+  // the interrupt of another timer of the group is left alone
+  g_intrStatus[0] = TIMER_INTR_T1;
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(calls0, 2);
+  CHECK_EQ(g_intrStatus[0], TIMER_INTR_T1);
+  g_intrStatus[0] = 0;
+
+  // a new setFrequency() frees the interrupt and allocates it again
+  intr_handle_t handle = ITimer0.getInterruptHandle();
+
+  g_core = 1;
+  CHECK(ITimer0.setFrequency(500, TimerHandler0));
+  CHECK(ITimer0.getInterruptHandle() == handle);
+  CHECK_EQ(ITimer0.getInterruptCore(), 1);
+  g_core = 0;
+
+  stubFireTimer(TIMER_GROUP_0, TIMER_0);
+  CHECK_EQ(calls0, 3);
+
+  // chained callbacks and notifications out of the lock. The notification slots due while the callbacks already
+  // queued MAX_ESP32_TIMER_NOTIFY_PENDING tasks are sent in a second batch
+  CHECK(ITimer1.addCallback(Chained, &ITimer1) >= 0);
+
+  for (int k = 0; k < MAX_ESP32_TIMER_NOTIFY; k++)
+    CHECK(ITimer1.addTaskNotify((TaskHandle_t) &tasks[MAX_ESP32_TIMER_NOTIFY_PENDING + k], 2) >= 0);
+
+  g_notifyCalls = 0;
+
+  stubFireTimer(TIMER_GROUP_0, TIMER_1);
+  CHECK_EQ(chainedCalls, 1);
+  CHECK_EQ(chainedLocked, 0);
+  CHECK(!lastQueued);
+  CHECK_EQ(g_notifyCalls, MAX_ESP32_TIMER_NOTIFY_PENDING + MAX_ESP32_TIMER_NOTIFY);
+  CHECK_EQ(g_notifyLocked, 0);
+  CHECK_EQ(g_critical, 0);
+
+  // nothing left over for the next tick
+  ITimer1.removeCallback(0);
+  g_notifyCalls = 0;
+
+  stubFireTimer(TIMER_GROUP_0, TIMER_1);
+  CHECK_EQ(g_notifyCalls, MAX_ESP32_TIMER_NOTIFY);
+
+  return TEST_END();
+}